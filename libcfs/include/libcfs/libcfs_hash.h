@@ -157,6 +157,12 @@ enum cfs_hash_tag {
          * change on hash table is non-blocking
          */
         CFS_HASH_NBLK_CHANGE    = 1 << 13,
+	/**
+	 * items can be looked up under rcu_read_lock() in the chain
+	 * returned by cfs_hash_hhead_rcu(), the owner must free items
+	 * only after a RCU grace period. Can't be used with rehash or add_tail.
+	 */
+	CFS_HASH_RCU_LOOKUP	= 1 << 14,
         /** NB, we typed hs_flags as  __u16, please change it
          * if you need to extend >=16 flags */
 };
@@ -424,6 +430,12 @@ cfs_hash_with_nblk_change(struct cfs_hash *hs)
         return (hs->hs_flags & CFS_HASH_NBLK_CHANGE) != 0;
 }
 
+static inline int
+cfs_hash_with_rcu_lookup(struct cfs_hash *hs)
+{
+	return (hs->hs_flags & CFS_HASH_RCU_LOOKUP) != 0;
+}
+
 static inline int
 cfs_hash_is_exiting(struct cfs_hash *hs)
 {       /* cfs_hash_destroy is called */
@@ -634,6 +646,8 @@ cfs_hash_bd_lookup_locked(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 struct hlist_node *
 cfs_hash_bd_peek_locked(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 			const void *key);
+struct hlist_head *
+cfs_hash_hhead_rcu(struct cfs_hash *hs, const void *key);
 struct hlist_node *
 cfs_hash_bd_findadd_locked(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 			   const void *key, struct hlist_node *hnode,
@@ -498,6 +498,8 @@ static inline void hlist_add_after(struct hlist_node *n,
 	hlist_for_each_entry_continue(tpos, member)
 #define cfs_hlist_for_each_entry_from(tpos, pos, member) \
 	hlist_for_each_entry_from(tpos, member)
+#define cfs_hlist_for_each_entry_rcu(tpos, pos, head, member) \
+	hlist_for_each_entry_rcu(tpos, head, member)
 #else
 #define cfs_hlist_for_each_entry(tpos, pos, head, member) \
 	hlist_for_each_entry(tpos, pos, head, member)
@@ -507,6 +509,8 @@ static inline void hlist_add_after(struct hlist_node *n,
 	hlist_for_each_entry_continue(tpos, pos, member)
 #define cfs_hlist_for_each_entry_from(tpos, pos, member) \
 	hlist_for_each_entry_from(tpos, pos, member)
+#define cfs_hlist_for_each_entry_rcu(tpos, pos, head, member) \
+	hlist_for_each_entry_rcu(tpos, pos, head, member)
 #endif
 
 #ifdef HAVE_HLIST_ADD_AFTER
@@ -107,6 +107,7 @@
  *   table. Also, user can break the iteration by return 1 in callback.
  */
 #include <linux/seq_file.h>
+#include <linux/rculist.h>
 
 #include <libcfs/libcfs.h>
 
@@ -262,7 +263,10 @@ static int
 cfs_hash_hh_hnode_add(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 		      struct hlist_node *hnode)
 {
-	hlist_add_head(hnode, cfs_hash_hh_hhead(hs, bd));
+	if (cfs_hash_with_rcu_lookup(hs))
+		hlist_add_head_rcu(hnode, cfs_hash_hh_hhead(hs, bd));
+	else
+		hlist_add_head(hnode, cfs_hash_hh_hhead(hs, bd));
 	return -1; /* unknown depth */
 }
 
@@ -270,7 +274,10 @@ static int
 cfs_hash_hh_hnode_del(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 		      struct hlist_node *hnode)
 {
-	hlist_del_init(hnode);
+	if (cfs_hash_with_rcu_lookup(hs))
+		hlist_del_init_rcu(hnode);
+	else
+		hlist_del_init(hnode);
 	return -1; /* unknown depth */
 }
 
@@ -306,7 +313,10 @@ cfs_hash_hd_hnode_add(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 
 	hh = container_of(cfs_hash_hd_hhead(hs, bd),
 			  struct cfs_hash_head_dep, hd_head);
-	hlist_add_head(hnode, &hh->hd_head);
+	if (cfs_hash_with_rcu_lookup(hs))
+		hlist_add_head_rcu(hnode, &hh->hd_head);
+	else
+		hlist_add_head(hnode, &hh->hd_head);
 	return ++hh->hd_depth;
 }
 
@@ -318,7 +328,10 @@ cfs_hash_hd_hnode_del(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 
 	hh = container_of(cfs_hash_hd_hhead(hs, bd),
 			  struct cfs_hash_head_dep, hd_head);
-	hlist_del_init(hnode);
+	if (cfs_hash_with_rcu_lookup(hs))
+		hlist_del_init_rcu(hnode);
+	else
+		hlist_del_init(hnode);
 	return --hh->hd_depth;
 }
 
@@ -681,6 +694,27 @@ cfs_hash_bd_peek_locked(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 }
 EXPORT_SYMBOL(cfs_hash_bd_peek_locked);
 
+/**
+ * Return the bucket head of \a key for a lockless walk, caller must hold
+ * rcu_read_lock() and the hash must be created with CFS_HASH_RCU_LOOKUP.
+ *
+ * Caller walks the chain with cfs_hlist_for_each_entry_rcu(). No refcount
+ * is taken on items found because they may be already on their way out,
+ * caller should try to grab a reference by itself (i.e.
+ * atomic_inc_not_zero()) and fall back to a locked lookup on failure.
+ */
+struct hlist_head *
+cfs_hash_hhead_rcu(struct cfs_hash *hs, const void *key)
+{
+	struct cfs_hash_bd bd;
+
+	LASSERT(cfs_hash_with_rcu_lookup(hs));
+
+	cfs_hash_bd_get(hs, key, &bd);
+	return cfs_hash_bd_hhead(hs, &bd);
+}
+EXPORT_SYMBOL(cfs_hash_hhead_rcu);
+
 static void
 cfs_hash_multi_bd_lock(struct cfs_hash *hs, struct cfs_hash_bd *bds,
                        unsigned n, int excl)
@@ -1030,6 +1064,9 @@ cfs_hash_create(char *name, unsigned cur_bits, unsigned max_bits,
         LASSERT(ergo((flags & CFS_HASH_REHASH) == 0, cur_bits == max_bits));
         LASSERT(ergo((flags & CFS_HASH_REHASH) != 0,
                      (flags & CFS_HASH_NO_LOCK) == 0));
+	LASSERT(ergo((flags & CFS_HASH_RCU_LOOKUP) != 0,
+		     (flags & (CFS_HASH_REHASH | CFS_HASH_ADD_TAIL |
+			       CFS_HASH_NO_LOCK)) == 0));
         LASSERT(ergo((flags & CFS_HASH_REHASH_KEY) != 0,
                       ops->hs_keycpy != NULL));
 
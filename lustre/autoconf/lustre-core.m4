@@ -2044,6 +2044,24 @@ key_payload_data_array, [
 ])
 ]) #LC_HAVE_KEY_PAYLOAD_DATA_ARRAY
 
+#
+# LC_HAVE_INTERVAL_EXP_BLK_INTEGRITY
+#
+# 4.4 kernel moved the integrity profile name into blk_integrity_profile
+# and replaced blk_integrity.sector_size with interval_exp
+#
+AC_DEFUN([LC_HAVE_INTERVAL_EXP_BLK_INTEGRITY], [
+LB_CHECK_COMPILE([if 'blk_integrity.interval_exp' exist],
+blk_integrity_interval_exp, [
+	#include <linux/blkdev.h>
+],[
+	((struct blk_integrity *)0)->interval_exp = 0;
+],[
+	AC_DEFINE(HAVE_INTERVAL_EXP_BLK_INTEGRITY, 1,
+		[blk_integrity.interval_exp exist])
+])
+]) # LC_HAVE_INTERVAL_EXP_BLK_INTEGRITY
+
 #
 # LC_PROG_LINUX
 #
@@ -2213,6 +2231,7 @@ AC_DEFUN([LC_PROG_LINUX], [
 	LC_HAVE_LOCKS_LOCK_FILE_WAIT
 	LC_HAVE_QC_MAKE_REQUEST_FN
 	LC_HAVE_KEY_PAYLOAD_DATA_ARRAY
+	LC_HAVE_INTERVAL_EXP_BLK_INTEGRITY
 
 	#
 	AS_IF([test "x$enable_server" != xno], [
@@ -97,6 +97,7 @@
 #include <linux/atomic.h>
 #include <linux/mutex.h>
 #include <linux/radix-tree.h>
+#include <linux/percpu_counter.h>
 #include <linux/spinlock.h>
 #include <linux/wait.h>
 #include <lustre_dlm.h>
@@ -702,6 +703,12 @@ enum cl_page_type {
         CPT_TRANSIENT,
 };
 
+/**
+ * Maximal number of layers a cl_page may have slices in: vvp, lov, lovsub
+ * and osc.
+ */
+#define CP_MAX_LAYER	4
+
 /**
  * Fields are protected by the lock on struct page, except for atomics and
  * immutables.
@@ -722,8 +729,14 @@ struct cl_page {
 	struct page		*cp_vmpage;
 	/** Linkage of pages within group. Pages must be owned */
 	struct list_head	 cp_batch;
-	/** List of slices. Immutable after creation. */
-	struct list_head	 cp_layers;
+	/** Number of slices. Immutable after creation. */
+	unsigned char		 cp_layer_count;
+	/**
+	 * Offsets of the slices from the start of the page, top layer first.
+	 * All slices live in the same allocation as the cl_page, see
+	 * cl_object_header::coh_page_bufsize. Immutable after creation.
+	 */
+	unsigned short		 cp_layer_offset[CP_MAX_LAYER];
 	/**
 	 * Page state. This field is const to avoid accidental update, it is
 	 * modified only internally within cl_page.c. Protected by a VM lock.
@@ -764,8 +777,6 @@ struct cl_page_slice {
          */
         struct cl_object                *cpl_obj;
         const struct cl_page_operations *cpl_ops;
-        /** Linkage into cl_page::cp_layers. Immutable after creation. */
-	struct list_head		 cpl_linkage;
 };
 
 /**
@@ -1848,7 +1859,12 @@ struct cl_io {
 	/**
 	 * O_NOATIME
 	 */
-			     ci_noatime:1;
+			     ci_noatime:1,
+	/**
+	 * Read ahead on behalf of a reader by a worker thread, there is no
+	 * user buffer and no data is copied by cl_io_start().
+	 */
+			     ci_async_readahead:1;
 	/**
 	 * Number of pages owned by this IO. For invariant checking.
 	 */
@@ -2175,6 +2191,29 @@ void cl_lock_descr_print(const struct lu_env *env, void *cookie,
  * maintained. "unstable" pages are pages pinned by the ptlrpc
  * layer for recovery purposes.
  */
+/**
+ * Per NUMA node part of the client page cache budget.
+ *
+ * LRU slots are taken from the node of the CPU doing the IO, so that IO
+ * threads running on different nodes do not contend on a single counter. A
+ * node running out of slots borrows them from another node. Each slot is
+ * given back to the node it was taken from.
+ */
+struct cl_cache_node {
+	/**
+	 * # of LRU entries available on this node
+	 */
+	atomic_long_t		ccn_lru_left;
+	/**
+	 * stats: # of LRU slots borrowed from the other nodes
+	 */
+	atomic_long_t		ccn_borrowed;
+	/**
+	 * stats: # of pages reclaimed from the LRU lists of this node
+	 */
+	atomic_long_t		ccn_reclaimed;
+} ____cacheline_aligned_in_smp;
+
 struct cl_client_cache {
 	/**
 	 * # of client cache refcount
@@ -2186,9 +2225,13 @@ struct cl_client_cache {
 	 */
 	unsigned int		ccc_lru_shrinkers;
 	/**
-	 * # of LRU entries available
+	 * LRU entries available, per NUMA node (nr_node_ids entries)
 	 */
-	atomic_long_t		ccc_lru_left;
+	struct cl_cache_node	*ccc_nodes;
+	/**
+	 * Total of cl_cache_node::ccn_lru_left, for cheap estimates
+	 */
+	struct percpu_counter	ccc_lru_left;
 	/**
 	 * List of entities(OSCs) for this LRU cache
 	 */
@@ -2221,6 +2264,11 @@ struct cl_client_cache {
 struct cl_client_cache *cl_cache_init(unsigned long lru_page_max);
 void cl_cache_incref(struct cl_client_cache *cache);
 void cl_cache_decref(struct cl_client_cache *cache);
+long cl_cache_lru_left(struct cl_client_cache *cache);
+long cl_cache_lru_left_approx(struct cl_client_cache *cache);
+long cl_cache_lru_take(struct cl_client_cache *cache, int *nid, long npages);
+long cl_cache_lru_shrink(struct cl_client_cache *cache, long npages);
+void cl_cache_lru_give(struct cl_client_cache *cache, int nid, long npages);
 
 /** @} cl_page */
 
@@ -2402,6 +2450,18 @@ struct cl_sync_io {
 	atomic_t		csi_sync_nr;
 	/** error code. */
 	int			csi_sync_rc;
+	/**
+	 * If non-zero, cl_sync_io_note() wakes up csi_waitq once the number
+	 * of outstanding entries drops to this value, see
+	 * cl_sync_io_throttle().
+	 */
+	int			csi_window;
+	/**
+	 * completions which saw csi_window set and may still wake up the
+	 * throttled owner, the anchor must not be destroyed until they're
+	 * done.
+	 */
+	atomic_t		csi_wakers;
 	/** barrier of destroy this structure */
 	atomic_t		csi_barrier;
 	/** completion to be signaled when transfer is complete. */
@@ -2417,6 +2477,8 @@ int  cl_sync_io_wait(const struct lu_env *env, struct cl_sync_io *anchor,
 		     long timeout);
 void cl_sync_io_note(const struct lu_env *env, struct cl_sync_io *anchor,
 		     int ioret);
+void cl_sync_io_throttle(const struct lu_env *env, struct cl_sync_io *anchor,
+			 int window);
 void cl_sync_io_end(const struct lu_env *env, struct cl_sync_io *anchor);
 
 /** @} cl_sync_io */
@@ -89,6 +89,9 @@ struct dt_device_param {
 	/* per-extent insertion overhead to be used by client for grant
 	 * calculation */
 	unsigned	   ddp_extent_tax;
+	/* OBD_CKSUM_T10* type whose guard tags the device stores as its
+	 * integrity metadata, 0 if none */
+	__u32		   ddp_t10_cksum_type;
 };
 
 /**
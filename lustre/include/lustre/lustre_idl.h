@@ -1240,6 +1240,8 @@ struct ptlrpc_body_v2 {
 #define OBD_CONNECT_OPEN_BY_FID	0x20000000000000ULL /* open by fid won't pack
 						       name in request */
 #define OBD_CONNECT_LFSCK      0x40000000000000ULL/* support online LFSCK */
+#define OBD_CONNECT_MULTIOBJ_BRW 0x80000000000000ULL/* several objects in one
+						     * OST_WRITE */
 #define OBD_CONNECT_UNLINK_CLOSE 0x100000000000000ULL/* close file in unlink */
 #define OBD_CONNECT_MULTIMODRPCS 0x200000000000000ULL /* support multiple modify
 							 RPCs in parallel */
@@ -1317,7 +1319,8 @@ struct ptlrpc_body_v2 {
 				OBD_CONNECT_LAYOUTLOCK | OBD_CONNECT_FID | \
 				OBD_CONNECT_PINGLESS | OBD_CONNECT_LFSCK | \
 				OBD_CONNECT_BULK_MBITS | \
-				OBD_CONNECT_GRANT_PARAM)
+				OBD_CONNECT_GRANT_PARAM | \
+				OBD_CONNECT_MULTIOBJ_BRW)
 #define ECHO_CONNECT_SUPPORTED (0)
 #define MGS_CONNECT_SUPPORTED  (OBD_CONNECT_VERSION | OBD_CONNECT_AT | \
 				OBD_CONNECT_FULL20 | OBD_CONNECT_IMP_RECOV | \
@@ -1389,8 +1392,17 @@ typedef enum {
         OBD_CKSUM_CRC32 = 0x00000001,
         OBD_CKSUM_ADLER = 0x00000002,
         OBD_CKSUM_CRC32C= 0x00000004,
+	/* T10-PI style: a 16-bit guard tag per sector, then a crc32 of the
+	 * guard tags as the RPC checksum */
+	OBD_CKSUM_T10IP512  = 0x00000008,
+	OBD_CKSUM_T10IP4K   = 0x00000010,
+	OBD_CKSUM_T10CRC512 = 0x00000020,
+	OBD_CKSUM_T10CRC4K  = 0x00000040,
 } cksum_type_t;
 
+#define OBD_CKSUM_T10_ALL (OBD_CKSUM_T10IP512 | OBD_CKSUM_T10IP4K | \
+			   OBD_CKSUM_T10CRC512 | OBD_CKSUM_T10CRC4K)
+
 /*
  *   OST requests: OBDO & OBD request records
  */
@@ -1436,7 +1448,10 @@ enum obdo_flags {
         OBD_FL_CKSUM_CRC32  = 0x00001000, /* CRC32 checksum type */
         OBD_FL_CKSUM_ADLER  = 0x00002000, /* ADLER checksum type */
         OBD_FL_CKSUM_CRC32C = 0x00004000, /* CRC32C checksum type */
-        OBD_FL_CKSUM_RSVD2  = 0x00008000, /* for future cksum types */
+	OBD_FL_CKSUM_T10IP512  = 0x00005000, /* T10PI IP cksum, 512B sector */
+	OBD_FL_CKSUM_T10IP4K   = 0x00006000, /* T10PI IP cksum, 4KB sector */
+	OBD_FL_CKSUM_T10CRC512 = 0x00007000, /* T10PI CRC cksum, 512B sector */
+	OBD_FL_CKSUM_T10CRC4K  = 0x00008000, /* T10PI CRC cksum, 4KB sector */
         OBD_FL_CKSUM_RSVD3  = 0x00010000, /* for future cksum types */
         OBD_FL_SHRINK_GRANT = 0x00020000, /* object shrink the grant */
         OBD_FL_MMAP         = 0x00040000, /* object is mmapped on the client.
@@ -1447,10 +1462,11 @@ enum obdo_flags {
 	OBD_FL_FLUSH	    = 0x00200000, /* flush pages on the OST */
 	OBD_FL_SHORT_IO	    = 0x00400000, /* short io request */
 
-        /* Note that while these checksum values are currently separate bits,
-         * in 2.x we can actually allow all values from 1-31 if we wanted. */
+        /* Note that while the first checksum values are separate bits,
+         * in 2.x we can actually allow all values from 1-31, which is
+         * how the T10 types are encoded. */
         OBD_FL_CKSUM_ALL    = OBD_FL_CKSUM_CRC32 | OBD_FL_CKSUM_ADLER |
-                              OBD_FL_CKSUM_CRC32C,
+                              OBD_FL_CKSUM_CRC32C | OBD_FL_CKSUM_T10CRC4K,
 
         /* mask for local-only flag, which won't be sent over network */
         OBD_FL_LOCAL_MASK   = 0xF0000000,
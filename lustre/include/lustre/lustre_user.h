@@ -233,6 +233,24 @@ struct ll_futimes_3 {
 	__u64 lfu_ctime_nsec;
 };
 
+/* names under a directory to stat ahead, see LL_IOC_STATAHEAD */
+struct ll_statahead_names {
+	__u32	lsn_count;	/* number of names */
+	__u32	lsn_size;	/* size of lsn_names */
+	__u32	lsn_flags;	/* LL_SA_NAMES_* flags */
+	__u32	lsn_padding;
+	char	lsn_names[0];	/* NUL-terminated names back to back */
+};
+
+/* max names in one LL_IOC_STATAHEAD batch */
+#define LL_SA_NAMES_BATCH	8192
+/* max names of a directory waiting to be stat'ed ahead, the names of the
+ * batch being stat'ed aren't counted */
+#define LL_SA_NAMES_QUEUED	(16 * LL_SA_NAMES_BATCH)
+
+/* drop the names still waiting to be stat'ed ahead, see LL_IOC_STATAHEAD */
+#define LL_SA_NAMES_REPLACE	0x00000001
+
 /*
  * The ioctl naming rules:
  * LL_*     - works on the currently opened filehandle instead of parent dir
@@ -295,6 +313,7 @@ struct ll_futimes_3 {
 #define LL_IOC_FID2MDTIDX		_IOWR('f', 248, struct lu_fid)
 #define LL_IOC_GETPARENT		_IOWR('f', 249, struct getparent)
 #define LL_IOC_LADVISE			_IOR('f', 250, struct lu_ladvise)
+#define LL_IOC_STATAHEAD		_IOW('f', 251, struct ll_statahead_names)
 
 /* Lease types for use as arg and return of LL_IOC_{GET,SET}_LEASE ioctl. */
 enum ll_lease_type {
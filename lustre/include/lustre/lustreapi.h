@@ -299,6 +299,11 @@ extern int llapi_path2parent(const char *path, unsigned int linkno,
 extern int llapi_fd2parent(int fd, unsigned int linkno,
 			   lustre_fid *parent_fid, char *name,
 			   size_t name_size);
+/* stat ahead names under dirfd in the given order, see LL_SA_NAMES_BATCH,
+ * LL_SA_NAMES_QUEUED and LL_SA_NAMES_REPLACE for the limits and flags;
+ * returns the count of names queued, or negative errno */
+extern int llapi_statahead(int dirfd, const char **names, int count,
+			   unsigned int flags);
 extern int llapi_chomp_string(char *buf);
 extern int llapi_open_by_fid(const char *dir, const lustre_fid *fid,
 			     int open_flags);
@@ -198,6 +198,7 @@ struct ldlm_pool;
 struct ldlm_lock;
 struct ldlm_resource;
 struct ldlm_namespace;
+struct ldlm_res_stat;
 
 /**
  * Operations on LDLM pools.
@@ -510,6 +511,12 @@ struct ldlm_namespace {
 	 * Which bucket should we start with the lock reclaim.
 	 */
 	int			ns_reclaim_start;
+
+	/**
+	 * Collect lock statistics for the resources created while it is set,
+	 * server side only. \see ldlm_res_stat
+	 */
+	unsigned int		ns_lockstat;
 };
 
 /**
@@ -854,6 +861,13 @@ struct ldlm_lock {
 	/** Local PID of process which created this lock. */
 	__u32			l_pid;
 
+	/**
+	 * Time when the lock was put into the waiting queue or when its
+	 * blocking AST was sent, used by resource lock statistics only.
+	 * \see ldlm_res_stat
+	 */
+	ktime_t			l_stat_time;
+
 	/**
 	 * Number of times blocking AST was sent for this lock.
 	 * This is for debugging. Valid values are 0 and 1, if there is an
@@ -924,7 +938,7 @@ struct ldlm_resource {
 
 	/**
 	 * List item for list in namespace hash.
-	 * protected by ns_lock
+	 * protected by hash bucket lock, lookups can be done under RCU
 	 */
 	struct hlist_node	lr_hash;
 
@@ -982,6 +996,15 @@ struct ldlm_resource {
 
 	/** List of references to this resource. For debugging. */
 	struct lu_ref		lr_reference;
+
+	/**
+	 * Resource is freed after a RCU grace period, so that lockless
+	 * lookups in ldlm_resource_get() never touch freed memory.
+	 */
+	struct rcu_head		lr_rcu;
+
+	/** Lock statistics, only if ns_lockstat is set. Protected by lr_lock */
+	struct ldlm_res_stat	*lr_stat;
 };
 
 static inline bool ldlm_has_layout(struct ldlm_lock *lock)
@@ -177,7 +177,8 @@ struct obd_export {
 	/**
 	 * Set of counters below is to track where export references are
 	 * kept. The exp_rpc_count is used for reconnect handling also,
-	 * the cb_count and locks_count are for debug purposes only for now.
+	 * the exp_locks_count is checked against the per-export lock limits
+	 * by the ldlm lock reclaim, the cb_count is for debug purposes only.
 	 * The sum of them should be less than exp_refcount by 3
 	 */
 	atomic_t		exp_rpc_count; /* RPC references */
@@ -224,6 +225,11 @@ struct obd_export {
 	 * ldlm_lock::l_exp_flock_hash.
 	 */
 	struct cfs_hash	       *exp_flock_hash;
+	/**
+	 * When the locks of this export were last reclaimed for being over
+	 * the per-export soft limit, protected by exp_lock.
+	 */
+	cfs_time_t		exp_reclaim_time;
 	struct list_head	exp_outstanding_replies;
 	struct list_head	exp_uncommitted_replies;
 	spinlock_t		exp_uncommitted_replies_lock;
@@ -156,6 +156,16 @@ enum {
 
 struct mdc_rpc_lock;
 struct obd_import;
+/** LRU pages of a client_obd that live on one NUMA node */
+struct client_lru_node {
+	/** Lock for cln_list */
+	spinlock_t		 cln_lock;
+	/** List of LRU pages */
+	struct list_head	 cln_list;
+	/** # of pages in cln_list */
+	atomic_long_t		 cln_in_list;
+} ____cacheline_aligned_in_smp;
+
 struct client_obd {
 	struct rw_semaphore	 cl_sem;
 	struct obd_uuid		 cl_target_uuid;
@@ -243,6 +253,11 @@ struct client_obd {
 	atomic_t		cl_pending_r_pages;
 	__u32			cl_max_pages_per_rpc;
 	__u32			cl_max_rpcs_in_flight;
+	/* max # of objects in a write RPC, see OBD_CONNECT_MULTIOBJ_BRW */
+	__u32			cl_max_brw_objs;
+	/* stats: # of write RPCs with several objects, # of objects in them */
+	__u64			cl_w_multiobj_rpcs;
+	__u64			cl_w_multiobj_objs;
 	struct obd_histogram	cl_read_rpc_hist;
 	struct obd_histogram	cl_write_rpc_hist;
 	struct obd_histogram	cl_read_page_hist;
@@ -254,10 +269,6 @@ struct client_obd {
 	struct cl_client_cache  *cl_cache;
 	/** member of cl_cache->ccc_lru */
 	struct list_head         cl_lru_osc;
-	/** # of available LRU slots left in the per-OSC cache.
-	 * Available LRU slots are shared by all OSCs of the same file system,
-	 * therefore this is a pointer to cl_client_cache::ccc_lru_left. */
-	atomic_long_t           *cl_lru_left;
 	/** # of busy LRU pages. A page is considered busy if it's in writeback
 	 * queue, or in transfer. Busy pages can't be discarded so they are not
 	 * in LRU cache. */
@@ -274,10 +285,11 @@ struct client_obd {
 	 * reclaim is sync, initiated by IO thread when the LRU slots are
 	 * in shortage. */
 	__u64                    cl_lru_reclaim;
-	/** List of LRU pages for this client_obd */
-	struct list_head         cl_lru_list;
-	/** Lock for LRU page list */
-	spinlock_t		 cl_lru_list_lock;
+	/** Lists of LRU pages for this client_obd, one per NUMA node, indexed
+	 * by the node of the page (nr_node_ids entries). Available LRU slots
+	 * are shared by all OSCs of the same file system, see
+	 * cl_client_cache::ccc_nodes. */
+	struct client_lru_node	*cl_lru_nodes;
 	/** # of unstable pages in this client_obd.
 	 * An unstable page is a page state that WRITE RPC has finished but
 	 * the transaction has NOT yet committed. */
@@ -390,6 +402,9 @@ struct lov_obd {
 	struct cl_client_cache *lov_cache;
 
 	struct rw_semaphore	lov_notify_lock;
+	/* max number of sub-lock enqueues (e.g. glimpses) kept in flight
+	 * by one top-lock enqueue, 0 means unlimited */
+	unsigned int		lov_glimpse_window;
 };
 
 struct lmv_tgt_desc {
@@ -430,6 +445,9 @@ struct lmv_obd {
 	struct obd_connect_data	conn_data;
 };
 
+/* maximum number of T10 guard tags per page, for 512-byte sectors */
+#define LNB_GUARDS_MAX	(PAGE_CACHE_SIZE >> 9)
+
 struct niobuf_local {
 	__u64		lnb_file_offset;
 	__u32		lnb_page_offset;
@@ -438,6 +456,12 @@ struct niobuf_local {
 	int		lnb_rc;
 	struct page	*lnb_page;
 	void		*lnb_data;
+	/* the bulk checksum type is the T10 type the OSD stores, so guard
+	 * tags can be exchanged with the OSD instead of being recomputed */
+	unsigned int	lnb_guard_want:1,
+	/* lnb_guards[] holds the guard tag of every sector of the page */
+			lnb_guard_valid:1;
+	__u16		lnb_guards[LNB_GUARDS_MAX];
 };
 
 #define LUSTRE_FLD_NAME         "fld"
@@ -1106,6 +1130,12 @@ struct md_ops {
 			       union ldlm_policy_data *, enum ldlm_mode,
 			       enum ldlm_cancel_flags flags, void *opaque);
 
+	int (*m_cancel_unused_local)(struct obd_export *,
+				     const struct lu_fid *,
+				     union ldlm_policy_data *, enum ldlm_mode,
+				     enum ldlm_cancel_flags flags,
+				     struct list_head *cancels);
+
 	int (*m_get_remote_perm)(struct obd_export *, const struct lu_fid *,
 				 u32, struct ptlrpc_request **);
 
@@ -49,6 +49,12 @@ static inline unsigned char cksum_obd2cfs(cksum_type_t cksum_type)
 		return CFS_HASH_ALG_ADLER32;
 	case OBD_CKSUM_CRC32C:
 		return CFS_HASH_ALG_CRC32C;
+	/* T10 types hash the per-sector guard tags with crc32 */
+	case OBD_CKSUM_T10IP512:
+	case OBD_CKSUM_T10IP4K:
+	case OBD_CKSUM_T10CRC512:
+	case OBD_CKSUM_T10CRC4K:
+		return CFS_HASH_ALG_CRC32;
 	default:
 		CERROR("Unknown checksum type (%x)!!!\n", cksum_type);
 		LBUG();
@@ -56,6 +62,72 @@ static inline unsigned char cksum_obd2cfs(cksum_type_t cksum_type)
 	return 0;
 }
 
+/* obdclass/integrity.c */
+struct obd_t10_cksum_desc;
+
+/* a page fragment of the bulk, see obd_t10_cksum_update_guards() */
+struct obd_t10_frag {
+	struct page	*otf_page;
+	unsigned int	 otf_offset;
+	unsigned int	 otf_len;
+	__u16		*otf_guards;
+	bool		 otf_reuse;
+};
+
+typedef void (*obd_t10_frag_get_t)(void *data, int idx,
+				   struct obd_t10_frag *frag);
+
+struct obd_t10_cksum_desc *obd_t10_cksum_init(cksum_type_t cksum_type);
+int obd_t10_cksum_update_page(struct obd_t10_cksum_desc *desc,
+			      struct page *page, unsigned int offset,
+			      unsigned int len);
+int obd_t10_cksum_update_guards(struct obd_t10_cksum_desc *desc,
+				struct page *page, unsigned int offset,
+				unsigned int len, __u16 *guards, bool reuse);
+int obd_t10_cksum_update_frags(struct obd_t10_cksum_desc *desc, int count,
+			       obd_t10_frag_get_t get, void *data);
+int obd_t10_cksum_final(struct obd_t10_cksum_desc *desc, __u32 *cksum);
+void obd_t10_cksum_speed_init(void);
+int obd_t10_cksum_speed(cksum_type_t cksum_type);
+bool obd_t10_cksum_available(cksum_type_t cksum_type);
+void obd_t10_cksum_fini(void);
+
+static inline bool cksum_type_is_t10(cksum_type_t cksum_type)
+{
+	return (cksum_type & OBD_CKSUM_T10_ALL) != 0;
+}
+
+static inline unsigned int cksum_type_t10_sector_size(cksum_type_t cksum_type)
+{
+	if (cksum_type & (OBD_CKSUM_T10IP512 | OBD_CKSUM_T10CRC512))
+		return 512;
+	return 4096;
+}
+
+/* Speed of a single checksum type in MB/s, negative if unavailable */
+static inline int obd_cksum_type_speed(cksum_type_t cksum_type)
+{
+	if (cksum_type_is_t10(cksum_type))
+		return obd_t10_cksum_speed(cksum_type);
+	return cfs_crypto_hash_speed(cksum_obd2cfs(cksum_type));
+}
+
+static inline u32 cksum_type_t10_flag(cksum_type_t cksum_type)
+{
+	switch (cksum_type) {
+	case OBD_CKSUM_T10IP512:
+		return OBD_FL_CKSUM_T10IP512;
+	case OBD_CKSUM_T10IP4K:
+		return OBD_FL_CKSUM_T10IP4K;
+	case OBD_CKSUM_T10CRC512:
+		return OBD_FL_CKSUM_T10CRC512;
+	case OBD_CKSUM_T10CRC4K:
+		return OBD_FL_CKSUM_T10CRC4K;
+	default:
+		return OBD_FL_CKSUM_ADLER;
+	}
+}
+
 /* The OBD_FL_CKSUM_* flags is packed into 5 bits of o_flags, since there can
  * only be a single checksum type per RPC.
  *
@@ -71,6 +143,7 @@ static inline u32 cksum_type_pack(cksum_type_t cksum_type)
 {
 	unsigned int    performance = 0, tmp;
 	u32		flag = OBD_FL_CKSUM_ADLER;
+	cksum_type_t	t10;
 
 	if (cksum_type & OBD_CKSUM_CRC32) {
 		tmp = cfs_crypto_hash_speed(cksum_obd2cfs(OBD_CKSUM_CRC32));
@@ -93,9 +166,21 @@ static inline u32 cksum_type_pack(cksum_type_t cksum_type)
 			flag = OBD_FL_CKSUM_ADLER;
 		}
 	}
+	for (t10 = OBD_CKSUM_T10IP512; t10 <= OBD_CKSUM_T10CRC4K; t10 <<= 1) {
+		int speed;
+
+		if (!(cksum_type & t10))
+			continue;
+		speed = obd_t10_cksum_speed(t10);
+		if (speed > 0 && speed > performance) {
+			performance = speed;
+			flag = cksum_type_t10_flag(t10);
+		}
+	}
 	if (unlikely(cksum_type && !(cksum_type & (OBD_CKSUM_CRC32C |
 						   OBD_CKSUM_CRC32 |
-						   OBD_CKSUM_ADLER))))
+						   OBD_CKSUM_ADLER |
+						   OBD_CKSUM_T10_ALL))))
 		CWARN("unknown cksum type %x\n", cksum_type);
 
 	return flag;
@@ -108,6 +193,14 @@ static inline cksum_type_t cksum_type_unpack(u32 o_flags)
 		return OBD_CKSUM_CRC32C;
 	case OBD_FL_CKSUM_CRC32:
 		return OBD_CKSUM_CRC32;
+	case OBD_FL_CKSUM_T10IP512:
+		return OBD_CKSUM_T10IP512;
+	case OBD_FL_CKSUM_T10IP4K:
+		return OBD_CKSUM_T10IP4K;
+	case OBD_FL_CKSUM_T10CRC512:
+		return OBD_CKSUM_T10CRC512;
+	case OBD_FL_CKSUM_T10CRC4K:
+		return OBD_CKSUM_T10CRC4K;
 	default:
 		break;
 	}
@@ -122,6 +215,7 @@ static inline cksum_type_t cksum_type_unpack(u32 o_flags)
 static inline cksum_type_t cksum_types_supported_client(void)
 {
 	cksum_type_t ret = OBD_CKSUM_ADLER;
+	cksum_type_t t10;
 
 	CDEBUG(D_INFO, "Crypto hash speed: crc %d, crc32c %d, adler %d\n",
 	       cfs_crypto_hash_speed(cksum_obd2cfs(OBD_CKSUM_CRC32)),
@@ -132,15 +226,20 @@ static inline cksum_type_t cksum_types_supported_client(void)
 		ret |= OBD_CKSUM_CRC32C;
 	if (cfs_crypto_hash_speed(cksum_obd2cfs(OBD_CKSUM_CRC32)) > 0)
 		ret |= OBD_CKSUM_CRC32;
+	for (t10 = OBD_CKSUM_T10IP512; t10 <= OBD_CKSUM_T10CRC4K; t10 <<= 1)
+		if (obd_t10_cksum_available(t10))
+			ret |= t10;
 
 	return ret;
 }
 
-/* Server uses algos that perform at 50% or better of the Adler */
+/* Server uses algos that perform at 50% or better of the Adler, T10 types
+ * still being measured after obdclass was loaded are left out */
 static inline cksum_type_t cksum_types_supported_server(void)
 {
 	int	     base_speed;
 	cksum_type_t    ret = OBD_CKSUM_ADLER;
+	cksum_type_t    t10;
 
 	CDEBUG(D_INFO, "Crypto hash speed: crc %d, crc32c %d, adler %d\n",
 	       cfs_crypto_hash_speed(cksum_obd2cfs(OBD_CKSUM_CRC32)),
@@ -155,6 +254,9 @@ static inline cksum_type_t cksum_types_supported_server(void)
 	if (cfs_crypto_hash_speed(cksum_obd2cfs(OBD_CKSUM_CRC32)) >=
 	    base_speed)
 		ret |= OBD_CKSUM_CRC32;
+	for (t10 = OBD_CKSUM_T10IP512; t10 <= OBD_CKSUM_T10CRC4K; t10 <<= 1)
+		if (obd_t10_cksum_speed(t10) >= base_speed)
+			ret |= t10;
 
 	return ret;
 }
@@ -174,6 +276,8 @@ static inline cksum_type_t cksum_type_select(cksum_type_t cksum_types)
 
 /* Checksum algorithm names. Must be defined in the same order as the
  * OBD_CKSUM_* flags. */
-#define DECLARE_CKSUM_NAME char *cksum_name[] = {"crc32", "adler", "crc32c"}
+#define DECLARE_CKSUM_NAME char *cksum_name[] = {"crc32", "adler", "crc32c", \
+						"t10ip512", "t10ip4k", \
+						"t10crc512", "t10crc4k"}
 
 #endif /* __OBD_H */
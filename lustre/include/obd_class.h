@@ -1551,6 +1551,26 @@ int md_cancel_unused(struct obd_export *exp, const struct lu_fid *fid,
 	RETURN(rc);
 }
 
+/**
+ * Cancel locally the unused locks on \a fid and collect them into
+ * \a cancels, for the caller to send with ldlm_cli_cancel_list().
+ *
+ * \retval	number of locks added to \a cancels
+ * \retval	negative errno on failure
+ */
+static inline
+int md_cancel_unused_local(struct obd_export *exp, const struct lu_fid *fid,
+			   union ldlm_policy_data *policy, enum ldlm_mode mode,
+			   enum ldlm_cancel_flags cancel_flags,
+			   struct list_head *cancels)
+{
+	ENTRY;
+	EXP_CHECK_MD_OP(exp, cancel_unused_local);
+	EXP_MD_COUNTER_INCREMENT(exp, cancel_unused_local);
+	RETURN(MDP(exp->exp_obd, cancel_unused_local)(exp, fid, policy, mode,
+						      cancel_flags, cancels));
+}
+
 static inline enum ldlm_mode md_lock_match(struct obd_export *exp, __u64 flags,
 					   const struct lu_fid *fid,
 					   enum ldlm_type type,
@@ -126,6 +126,102 @@ extern struct kmem_cache *ldlm_interval_tree_slab;
 void ldlm_resource_insert_lock_after(struct ldlm_lock *original,
                                      struct ldlm_lock *new);
 
+/**
+ * Per-resource lock statistics, collected on server namespaces with
+ * ns_lockstat set and shown by the "lockstat" proc file of the namespace.
+ * Protected by lr_lock.
+ */
+struct ldlm_res_stat {
+	/** number of enqueue requests */
+	__u64			lrs_enqueue;
+	/** number of enqueue requests which had to wait for a conflict */
+	__u64			lrs_conflict;
+	/** total time spent by the locks in the waiting queue */
+	__u64			lrs_wait_us;
+	/** number of blocking ASTs answered by a cancel */
+	__u64			lrs_ast_count;
+	/** total time between blocking AST and cancel */
+	__u64			lrs_ast_us;
+	/** extent of the last conflicting extent lock */
+	struct ldlm_extent	lrs_extent;
+};
+
+/* Lock statistics helpers, all called with the resource locked. */
+static inline struct ldlm_res_stat *
+ldlm_resource_stat(struct ldlm_resource *res)
+{
+	if (likely(!ldlm_res_to_ns(res)->ns_lockstat))
+		return NULL;
+	return res->lr_stat;
+}
+
+static inline void ldlm_resource_stat_enqueue(struct ldlm_resource *res,
+					      struct ldlm_lock *lock)
+{
+	struct ldlm_res_stat *stat;
+
+	if (likely(!ldlm_res_to_ns(res)->ns_lockstat))
+		return;
+
+	/* allocated on first use so that resources which existed before
+	 * lockstat was enabled are sampled too. Statistics are best
+	 * effort, go on without them on ENOMEM. */
+	if (res->lr_stat == NULL)
+		OBD_ALLOC_GFP(res->lr_stat, sizeof(*res->lr_stat), GFP_ATOMIC);
+	stat = res->lr_stat;
+	if (stat == NULL)
+		return;
+
+	stat->lrs_enqueue++;
+	if (lock->l_req_mode != lock->l_granted_mode) {
+		stat->lrs_conflict++;
+		if (res->lr_type == LDLM_EXTENT)
+			stat->lrs_extent = lock->l_policy_data.l_extent;
+		lock->l_stat_time = ktime_get();
+	}
+}
+
+static inline void ldlm_resource_stat_grant(struct ldlm_resource *res,
+					    struct ldlm_lock *lock)
+{
+	struct ldlm_res_stat *stat;
+
+	if (likely(ktime_to_ns(lock->l_stat_time) == 0))
+		return;
+
+	stat = ldlm_resource_stat(res);
+	if (stat != NULL)
+		stat->lrs_wait_us += ktime_us_delta(ktime_get(),
+						    lock->l_stat_time);
+	lock->l_stat_time = ktime_set(0, 0);
+}
+
+static inline void ldlm_resource_stat_ast_sent(struct ldlm_resource *res,
+					       struct ldlm_lock *lock)
+{
+	if (likely(ldlm_resource_stat(res) == NULL))
+		return;
+
+	lock->l_stat_time = ktime_get();
+}
+
+static inline void ldlm_resource_stat_cancel(struct ldlm_resource *res,
+					     struct ldlm_lock *lock)
+{
+	struct ldlm_res_stat *stat;
+
+	if (likely(ktime_to_ns(lock->l_stat_time) == 0))
+		return;
+
+	stat = ldlm_resource_stat(res);
+	if (stat != NULL) {
+		stat->lrs_ast_count++;
+		stat->lrs_ast_us += ktime_us_delta(ktime_get(),
+						   lock->l_stat_time);
+	}
+	lock->l_stat_time = ktime_set(0, 0);
+}
+
 /* ldlm_lock.c */
 
 struct ldlm_cb_set_arg {
@@ -348,6 +444,8 @@ extern __u64 ldlm_reclaim_threshold;
 extern __u64 ldlm_lock_limit;
 extern __u64 ldlm_reclaim_threshold_mb;
 extern __u64 ldlm_lock_limit_mb;
+extern unsigned int ldlm_export_lock_soft_limit;
+extern unsigned int ldlm_export_lock_hard_limit;
 extern struct percpu_counter ldlm_granted_total;
 #endif
 int ldlm_reclaim_setup(void);
@@ -355,3 +453,4 @@ void ldlm_reclaim_cleanup(void);
 void ldlm_reclaim_add(struct ldlm_lock *lock);
 void ldlm_reclaim_del(struct ldlm_lock *lock);
 bool ldlm_reclaim_full(void);
+bool ldlm_reclaim_export_full(struct obd_export *exp);
@@ -268,6 +268,7 @@ int client_obd_setup(struct obd_device *obddev, struct lustre_cfg *lcfg)
 	enum ldlm_ns_type ns_type = LDLM_NS_TYPE_UNKNOWN;
 	char *cli_name = lustre_cfg_buf(lcfg, 0);
 	int rc;
+	int i;
 	ENTRY;
 
 	/* In a more perfect world, we would hang a ptlrpc_client off of
@@ -378,8 +379,14 @@ int client_obd_setup(struct obd_device *obddev, struct lustre_cfg *lcfg)
 	atomic_set(&cli->cl_lru_shrinkers, 0);
 	atomic_long_set(&cli->cl_lru_busy, 0);
 	atomic_long_set(&cli->cl_lru_in_list, 0);
-	INIT_LIST_HEAD(&cli->cl_lru_list);
-	spin_lock_init(&cli->cl_lru_list_lock);
+	OBD_ALLOC(cli->cl_lru_nodes, nr_node_ids * sizeof(*cli->cl_lru_nodes));
+	if (cli->cl_lru_nodes == NULL)
+		GOTO(err, rc = -ENOMEM);
+	for (i = 0; i < nr_node_ids; i++) {
+		spin_lock_init(&cli->cl_lru_nodes[i].cln_lock);
+		INIT_LIST_HEAD(&cli->cl_lru_nodes[i].cln_list);
+		atomic_long_set(&cli->cl_lru_nodes[i].cln_in_list, 0);
+	}
 	atomic_long_set(&cli->cl_unstable_count, 0);
 	INIT_LIST_HEAD(&cli->cl_shrink_list);
 
@@ -400,6 +407,8 @@ int client_obd_setup(struct obd_device *obddev, struct lustre_cfg *lcfg)
 	/* Set it to possible maximum size. It may be reduced by ocd_brw_size
 	 * from OFD after connecting. */
 	cli->cl_max_pages_per_rpc = PTLRPC_MAX_BRW_PAGES;
+	/* only used if the OST supports OBD_CONNECT_MULTIOBJ_BRW */
+	cli->cl_max_brw_objs = PTLRPC_MAX_BRW_OBJS / 2;
 
 	/* set cl_chunkbits default value to PAGE_CACHE_SHIFT,
 	 * it will be updated at OSC connection time. */
@@ -496,6 +505,10 @@ err:
 		OBD_FREE(cli->cl_mod_tag_bitmap,
 			 BITS_TO_LONGS(OBD_MAX_RIF_MAX) * sizeof(long));
 	cli->cl_mod_tag_bitmap = NULL;
+	if (cli->cl_lru_nodes != NULL)
+		OBD_FREE(cli->cl_lru_nodes,
+			 nr_node_ids * sizeof(*cli->cl_lru_nodes));
+	cli->cl_lru_nodes = NULL;
         RETURN(rc);
 
 }
@@ -519,6 +532,11 @@ int client_obd_cleanup(struct obd_device *obddev)
 			 BITS_TO_LONGS(OBD_MAX_RIF_MAX) * sizeof(long));
 	cli->cl_mod_tag_bitmap = NULL;
 
+	if (cli->cl_lru_nodes != NULL)
+		OBD_FREE(cli->cl_lru_nodes,
+			 nr_node_ids * sizeof(*cli->cl_lru_nodes));
+	cli->cl_lru_nodes = NULL;
+
 	RETURN(0);
 }
 EXPORT_SYMBOL(client_obd_cleanup);
@@ -1106,6 +1106,7 @@ void ldlm_grant_lock(struct ldlm_lock *lock, struct list_head *work_list)
         check_res_locked(res);
 
         lock->l_granted_mode = lock->l_req_mode;
+	ldlm_resource_stat_grant(res, lock);
 
 	if (work_list && lock->l_completion_ast != NULL)
 		ldlm_add_ast_work_item(lock, NULL, work_list);
@@ -1840,6 +1841,7 @@ enum ldlm_error ldlm_lock_enqueue(struct ldlm_namespace *ns,
 
         policy = ldlm_processing_policy_table[res->lr_type];
         policy(lock, flags, 1, &rc, NULL);
+	ldlm_resource_stat_enqueue(res, lock);
         GOTO(out, rc);
 #else
         } else {
@@ -912,6 +912,7 @@ int ldlm_server_blocking_ast(struct ldlm_lock *lock,
 	} else {
 		LASSERT(lock->l_granted_mode == lock->l_req_mode);
 		ldlm_add_waiting_lock(lock);
+		ldlm_resource_stat_ast_sent(lock->l_resource, lock);
 		unlock_res_and_lock(lock);
 
 		/* Do not resend after lock callback timeout */
@@ -1304,6 +1305,13 @@ int ldlm_handle_enqueue0(struct ldlm_namespace *ns,
 				  "client retry later.\n");
 			GOTO(out, rc = -EINPROGRESS);
 		}
+
+		if (ldlm_reclaim_export_full(req->rq_export)) {
+			DEBUG_REQ(D_DLMTRACE, req, "Too many locks granted to "
+				  "this client, reject current enqueue request "
+				  "and let the client retry later.\n");
+			GOTO(out, rc = -EINPROGRESS);
+		}
 	}
 
 	/* The lock's callback data might be set in the policy function */
@@ -1703,6 +1711,12 @@ int ldlm_request_cancel(struct ptlrpc_request *req,
 			LDLM_DEBUG(lock, "server cancels blocked lock after "
 				   CFS_DURATION_T"s", delay);
 			at_measured(&lock->l_export->exp_bl_lock_at, delay);
+
+			if (ktime_to_ns(lock->l_stat_time) != 0) {
+				lock_res_and_lock(lock);
+				ldlm_resource_stat_cancel(res, lock);
+				unlock_res_and_lock(lock);
+			}
 		}
                 ldlm_lock_cancel(lock);
                 LDLM_LOCK_PUT(lock);
@@ -3204,11 +3218,11 @@ void ldlm_exit(void)
 {
 	if (ldlm_refcount)
 		CERROR("ldlm_refcount is %d in ldlm_exit!\n", ldlm_refcount);
+	/* ldlm_lock_put() and ldlm_resource_putref() use RCU to free locks
+	 * and resources, so wait for all pending callbacks to run before
+	 * the slabs are destroyed. */
+	rcu_barrier();
 	kmem_cache_destroy(ldlm_resource_slab);
-	/* ldlm_lock_put() use RCU to call ldlm_lock_free, so need call
-	 * synchronize_rcu() to wait a grace period elapsed, so that
-	 * ldlm_lock_free() get a chance to be called. */
-	synchronize_rcu();
 	kmem_cache_destroy(ldlm_lock_slab);
 	kmem_cache_destroy(ldlm_interval_slab);
 	kmem_cache_destroy(ldlm_interval_tree_slab);
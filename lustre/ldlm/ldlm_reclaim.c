@@ -48,6 +48,24 @@
  * ldlm_reclaim_threshold & ldlm_lock_limit is set to 20% & 30% of the
  * total memory by default. It is tunable via proc entry, when it's set
  * to 0, the feature is disabled.
+ *
+ * Two per-export parameters are used to keep one client (or one runaway
+ * job on it) from driving the whole server to the global limits:
+ *
+ * ldlm_export_lock_soft_limit: When a client holds more locks than this,
+ * its oldest locks are revoked on its next enqueue, locks of the other
+ * clients are left alone. The locks of one client are scanned at most once
+ * per LDLM_RECLAIM_EXP_INTERVAL. If only the hard limit is set, the soft
+ * limit is 3/4 of it.
+ *
+ * ldlm_export_lock_hard_limit: When a client holds more locks than this,
+ * server will return -EINPROGRESS to its enqueue requests until its lock
+ * count is shrunk below the limit again.
+ *
+ * Both are 0 (disabled) by default. Besides, the global reclaim revokes
+ * locks of the clients holding more than LDLM_RECLAIM_HEAVY_FACTOR times
+ * of the average lock count first, and touches the others only if not
+ * enough locks are found.
  */
 
 #ifdef HAVE_SERVER_SUPPORT
@@ -61,6 +79,10 @@ __u64 ldlm_lock_limit;
 __u64 ldlm_reclaim_threshold_mb;
 __u64 ldlm_lock_limit_mb;
 
+/* Per-export lock count limits, 0 means disabled. */
+unsigned int ldlm_export_lock_soft_limit;
+unsigned int ldlm_export_lock_hard_limit;
+
 struct percpu_counter		ldlm_granted_total;
 static atomic_t			ldlm_nr_reclaimer;
 static cfs_duration_t		ldlm_last_reclaim_age;
@@ -73,6 +95,7 @@ struct ldlm_reclaim_cb_data {
 	int			 rcd_cursor;
 	int			 rcd_start;
 	bool			 rcd_skip;
+	bool			 rcd_heavy_only;
 	cfs_duration_t		 rcd_age;
 	struct cfs_hash_bd	*rcd_prev_bd;
 };
@@ -92,6 +115,31 @@ static inline bool ldlm_lock_reclaimable(struct ldlm_lock *lock)
 	return false;
 }
 
+#define LDLM_RECLAIM_HEAVY_FACTOR	2
+
+/**
+ * Check if the client owning \a lock holds disproportionate number of
+ * locks in namespace \a ns, i.e. more than LDLM_RECLAIM_HEAVY_FACTOR
+ * times of the average lock count per export.
+ */
+static bool ldlm_lock_export_heavy(struct ldlm_namespace *ns,
+				   struct ldlm_lock *lock)
+{
+	struct obd_export	*exp = lock->l_export;
+	int			 nr_exp;
+
+	if (exp == NULL || ns->ns_obd == NULL)
+		return true;
+
+	nr_exp = ns->ns_obd->obd_num_exports;
+	if (nr_exp <= 1)
+		return true;
+
+	return (__u64)atomic_read(&exp->exp_locks_count) * nr_exp >
+	       (__u64)atomic_read(&ns->ns_pool.pl_granted) *
+	       LDLM_RECLAIM_HEAVY_FACTOR;
+}
+
 /**
  * Callback function for revoking locks from certain resource.
  *
@@ -148,6 +196,10 @@ static int ldlm_reclaim_lock_cb(struct cfs_hash *hs, struct cfs_hash_bd *bd,
 						 data->rcd_age)))
 			continue;
 
+		if (data->rcd_heavy_only &&
+		    !ldlm_lock_export_heavy(ldlm_res_to_ns(res), lock))
+			continue;
+
 		if (!ldlm_is_ast_sent(lock)) {
 			ldlm_set_ast_sent(lock);
 			LASSERT(list_empty(&lock->l_rk_ast));
@@ -174,10 +226,12 @@ static int ldlm_reclaim_lock_cb(struct cfs_hash *hs, struct cfs_hash_bd *bd,
  * \param[in] skip	scan from the first lock on resource if the
  *			'skip' is false, otherwise, continue scan
  *			from the last scanned position
+ * \param[in] heavy_only	only revoke locks of the clients holding
+ *			disproportionate number of locks
  * \param[out] count	count of lock still to be revoked
  */
 static void ldlm_reclaim_res(struct ldlm_namespace *ns, int *count,
-			     cfs_duration_t age, bool skip)
+			     cfs_duration_t age, bool skip, bool heavy_only)
 {
 	struct ldlm_reclaim_cb_data	data;
 	int				idx, type, start;
@@ -203,6 +257,7 @@ static void ldlm_reclaim_res(struct ldlm_namespace *ns, int *count,
 	data.rcd_total = *count;
 	data.rcd_age = age;
 	data.rcd_skip = skip;
+	data.rcd_heavy_only = heavy_only;
 	data.rcd_prev_bd = NULL;
 	start = ns->ns_reclaim_start % CFS_HASH_NBKT(ns->ns_rs_hash);
 
@@ -241,7 +296,8 @@ static inline cfs_duration_t ldlm_reclaim_age(void)
 /**
  * Revoke certain amount of locks from all the server namespaces
  * in a roundrobin manner. Lock age is used to avoid reclaim on
- * the non-aged locks.
+ * the non-aged locks, and the clients holding disproportionate
+ * number of locks are asked to give up their locks first.
  */
 static void ldlm_reclaim_ns(void)
 {
@@ -251,6 +307,7 @@ static void ldlm_reclaim_ns(void)
 	enum ldlm_side		 ns_cli = LDLM_NAMESPACE_SERVER;
 	cfs_duration_t		 age;
 	bool			 skip = true;
+	bool			 heavy_only = true;
 	ENTRY;
 
 	if (!atomic_add_unless(&ldlm_nr_reclaimer, 1, 1)) {
@@ -274,11 +331,17 @@ again:
 		ldlm_namespace_move_to_active_locked(ns, ns_cli);
 		mutex_unlock(ldlm_namespace_lock(ns_cli));
 
-		ldlm_reclaim_res(ns, &count, age, skip);
+		ldlm_reclaim_res(ns, &count, age, skip, heavy_only);
 		ldlm_namespace_put(ns);
 		nr_processed++;
 	}
 
+	/* not enough locks from the heavy clients, take from everyone */
+	if (count > 0 && heavy_only) {
+		heavy_only = false;
+		goto again;
+	}
+
 	if (count > 0 && age > LDLM_RECLAIM_AGE_MIN) {
 		age >>= 1;
 		if (age < (LDLM_RECLAIM_AGE_MIN * 2))
@@ -294,6 +357,158 @@ out:
 	EXIT;
 }
 
+#define LDLM_RECLAIM_EXP_BATCH	128
+/* minimal interval between two reclaims of the locks of an export */
+#define LDLM_RECLAIM_EXP_INTERVAL	(cfs_time_seconds(1) / 10)
+
+struct ldlm_reclaim_exp_data {
+	struct ldlm_lock	**red_locks;
+	int			  red_added;
+	int			  red_total;
+	cfs_duration_t		  red_age;
+};
+
+/**
+ * Callback function for collecting aged locks of an export.
+ *
+ * It's called with exp_lock_hash bucket lock held, so only a lock
+ * reference is taken here, the resource lock is taken later by
+ * ldlm_reclaim_export().
+ */
+static int ldlm_reclaim_export_cb(struct cfs_hash *hs, struct cfs_hash_bd *bd,
+				  struct hlist_node *hnode, void *arg)
+{
+	struct ldlm_reclaim_exp_data	*data = arg;
+	struct ldlm_lock		*lock = cfs_hash_object(hs, hnode);
+
+	if (!ldlm_lock_reclaimable(lock) || ldlm_is_ast_sent(lock))
+		return 0;
+
+	if (!OBD_FAIL_CHECK(OBD_FAIL_LDLM_WATERMARK_LOW) &&
+	    cfs_time_before(cfs_time_current(),
+			    cfs_time_add(lock->l_last_used, data->red_age)))
+		return 0;
+
+	data->red_locks[data->red_added] = LDLM_LOCK_GET(lock);
+	return ++data->red_added == data->red_total;
+}
+
+/**
+ * Revoke at most \a count aged locks granted to export \a exp.
+ */
+static void ldlm_reclaim_export(struct obd_export *exp, int count)
+{
+	struct ldlm_reclaim_exp_data	data;
+	struct list_head		rpc_list;
+	struct ldlm_lock		*lock;
+	int				i;
+	ENTRY;
+
+	if (exp->exp_lock_hash == NULL || exp->exp_obd->obd_namespace == NULL) {
+		EXIT;
+		return;
+	}
+
+	if (!atomic_add_unless(&ldlm_nr_reclaimer, 1, 1)) {
+		EXIT;
+		return;
+	}
+
+	data.red_total = min(count, LDLM_RECLAIM_EXP_BATCH);
+	OBD_ALLOC(data.red_locks, data.red_total * sizeof(*data.red_locks));
+	if (data.red_locks == NULL)
+		GOTO(out, 0);
+
+	data.red_added = 0;
+	data.red_age = ldlm_reclaim_age();
+	cfs_hash_for_each(exp->exp_lock_hash, ldlm_reclaim_export_cb, &data);
+	if (data.red_added < data.red_total) {
+		/* retry with the minimal age for the rest */
+		for (i = 0; i < data.red_added; i++)
+			LDLM_LOCK_RELEASE(data.red_locks[i]);
+		data.red_added = 0;
+		data.red_age = LDLM_RECLAIM_AGE_MIN;
+		cfs_hash_for_each(exp->exp_lock_hash, ldlm_reclaim_export_cb,
+				  &data);
+	}
+
+	INIT_LIST_HEAD(&rpc_list);
+	for (i = 0; i < data.red_added; i++) {
+		bool revoke = false;
+
+		lock = data.red_locks[i];
+		lock_res_and_lock(lock);
+		if (lock->l_req_mode == lock->l_granted_mode &&
+		    !ldlm_is_ast_sent(lock) && !ldlm_is_destroyed(lock)) {
+			ldlm_set_ast_sent(lock);
+			LASSERT(list_empty(&lock->l_rk_ast));
+			/* the reference is passed to the rpc list */
+			list_add(&lock->l_rk_ast, &rpc_list);
+			revoke = true;
+		}
+		unlock_res_and_lock(lock);
+		if (!revoke)
+			LDLM_LOCK_RELEASE(lock);
+	}
+
+	CDEBUG(D_DLMTRACE, "%s: export %s holds %d locks, %d to be reclaimed, "
+	       "found %d locks.\n", exp->exp_obd->obd_name,
+	       obd_uuid2str(&exp->exp_client_uuid),
+	       atomic_read(&exp->exp_locks_count), count, data.red_added);
+
+	ldlm_run_ast_work(exp->exp_obd->obd_namespace, &rpc_list,
+			  LDLM_WORK_REVOKE_AST);
+	OBD_FREE(data.red_locks, data.red_total * sizeof(*data.red_locks));
+out:
+	atomic_add_unless(&ldlm_nr_reclaimer, -1, 0);
+	EXIT;
+}
+
+/**
+ * Check on the locks held by export \a exp: return true if it exceeds
+ * the per-export hard limit, otherwise return false. It also revokes
+ * aged locks from this export if the soft limit is exceeded.
+ *
+ * \retval true		hard limit exceeded.
+ * \retval false	hard limit not exceeded.
+ */
+bool ldlm_reclaim_export_full(struct obd_export *exp)
+{
+	unsigned int	soft = ldlm_export_lock_soft_limit;
+	unsigned int	hard = ldlm_export_lock_hard_limit;
+	int		nr = atomic_read(&exp->exp_locks_count);
+	cfs_time_t	now;
+	bool		reclaim = false;
+
+	/* start revoking before the hard limit is hit, otherwise the client
+	 * is refused until it cancels enough locks on its own */
+	if (hard != 0 && (soft == 0 || soft >= hard))
+		soft = hard - hard / 4;
+
+	if (soft == 0 || nr <= soft)
+		goto check_hard;
+
+	/* each walk of exp_lock_hash and the revoke ASTs are done in the
+	 * service thread, don't do that on every enqueue of the client */
+	now = cfs_time_current();
+	spin_lock(&exp->exp_lock);
+	if (cfs_time_aftereq(now, cfs_time_add(exp->exp_reclaim_time,
+					       LDLM_RECLAIM_EXP_INTERVAL))) {
+		exp->exp_reclaim_time = now;
+		reclaim = true;
+	}
+	spin_unlock(&exp->exp_lock);
+
+	if (reclaim)
+		ldlm_reclaim_export(exp, nr - soft);
+check_hard:
+
+	if (hard != 0 && nr > hard)
+		return true;
+
+	return false;
+}
+
 void ldlm_reclaim_add(struct ldlm_lock *lock)
 {
 	if (!ldlm_lock_reclaimable(lock))
@@ -389,6 +604,11 @@ bool ldlm_reclaim_full(void)
 	return false;
 }
 
+bool ldlm_reclaim_export_full(struct obd_export *exp)
+{
+	return false;
+}
+
 void ldlm_reclaim_add(struct ldlm_lock *lock)
 {
 }
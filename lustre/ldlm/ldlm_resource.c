@@ -40,6 +40,7 @@
  */
 
 #define DEBUG_SUBSYSTEM S_LDLM
+#include <linux/rculist.h>
 #include <lustre_dlm.h>
 #include <lustre_fid.h>
 #include <obd_class.h>
@@ -205,6 +206,12 @@ int ldlm_proc_setup(void)
 		{ .name =	"lock_granted_count",
 		  .fops =	&ldlm_granted_fops,
 		  .data =	&ldlm_granted_total },
+		{ .name =	"lock_export_soft_limit",
+		  .fops =	&ldlm_rw_uint_fops,
+		  .data =	&ldlm_export_lock_soft_limit },
+		{ .name =	"lock_export_hard_limit",
+		  .fops =	&ldlm_rw_uint_fops,
+		  .data =	&ldlm_export_lock_hard_limit },
 #endif
 		{ NULL }};
 	ENTRY;
@@ -420,6 +427,134 @@ static ssize_t lprocfs_elc_seq_write(struct file *file,
 }
 LPROC_SEQ_FOPS(lprocfs_elc);
 
+#ifdef HAVE_SERVER_SUPPORT
+/* Number of the hottest resources shown by lockstat proc file */
+#define LDLM_LOCKSTAT_TOP	32
+
+struct ldlm_lockstat_entry {
+	struct ldlm_res_id	lse_name;
+	enum ldlm_type		lse_type;
+	struct ldlm_res_stat	lse_stat;
+};
+
+struct ldlm_lockstat_data {
+	struct ldlm_lockstat_entry	*lsd_top;
+	int				 lsd_count;
+};
+
+/* Resources are ranked by conflict count, then by total wait time. */
+static inline bool ldlm_lockstat_hotter(struct ldlm_res_stat *a,
+					struct ldlm_res_stat *b)
+{
+	if (a->lrs_conflict != b->lrs_conflict)
+		return a->lrs_conflict > b->lrs_conflict;
+	return a->lrs_wait_us > b->lrs_wait_us;
+}
+
+static int ldlm_lockstat_cb(struct cfs_hash *hs, struct cfs_hash_bd *bd,
+			    struct hlist_node *hnode, void *arg)
+{
+	struct ldlm_resource		*res = cfs_hash_object(hs, hnode);
+	struct ldlm_lockstat_data	*data = arg;
+	struct ldlm_lockstat_entry	 entry;
+	int				 i;
+
+	if (res->lr_stat == NULL)
+		return 0;
+
+	lock_res(res);
+	entry.lse_stat = *res->lr_stat;
+	unlock_res(res);
+	if (entry.lse_stat.lrs_enqueue == 0)
+		return 0;
+
+	entry.lse_name = res->lr_name;
+	entry.lse_type = res->lr_type;
+
+	/* insertion into the sorted top table */
+	for (i = data->lsd_count; i > 0; i--) {
+		if (!ldlm_lockstat_hotter(&entry.lse_stat,
+					  &data->lsd_top[i - 1].lse_stat))
+			break;
+		if (i < LDLM_LOCKSTAT_TOP)
+			data->lsd_top[i] = data->lsd_top[i - 1];
+	}
+	if (i < LDLM_LOCKSTAT_TOP) {
+		data->lsd_top[i] = entry;
+		if (data->lsd_count < LDLM_LOCKSTAT_TOP)
+			data->lsd_count++;
+	}
+	return 0;
+}
+
+static int lprocfs_ns_lockstat_seq_show(struct seq_file *m, void *v)
+{
+	struct ldlm_namespace		*ns = m->private;
+	struct ldlm_lockstat_data	 data;
+	struct ldlm_lockstat_entry	*entry;
+	struct lu_fid			 fid;
+	int				 i;
+
+	OBD_ALLOC_LARGE(data.lsd_top,
+			LDLM_LOCKSTAT_TOP * sizeof(*data.lsd_top));
+	if (data.lsd_top == NULL)
+		return -ENOMEM;
+	data.lsd_count = 0;
+
+	cfs_hash_for_each_nolock(ns->ns_rs_hash, ldlm_lockstat_cb, &data, 0);
+
+	seq_printf(m, "enabled: %u\n", ns->ns_lockstat);
+	seq_printf(m, "resources:\n");
+	for (i = 0; i < data.lsd_count; i++) {
+		entry = &data.lsd_top[i];
+		fid_extract_from_res_name(&fid, &entry->lse_name);
+		seq_printf(m, "  - { resource: "DLDLMRES", fid: "DFID", "
+			   "type: %s, enqueue: "LPU64", conflict: "LPU64", "
+			   "wait_us: "LPU64", ast_count: "LPU64", "
+			   "ast_us: "LPU64,
+			   (unsigned long long)entry->lse_name.name[0],
+			   (unsigned long long)entry->lse_name.name[1],
+			   (unsigned long long)entry->lse_name.name[2],
+			   (unsigned long long)entry->lse_name.name[3],
+			   PFID(&fid),
+			   ldlm_typename[entry->lse_type],
+			   entry->lse_stat.lrs_enqueue,
+			   entry->lse_stat.lrs_conflict,
+			   entry->lse_stat.lrs_wait_us,
+			   entry->lse_stat.lrs_ast_count,
+			   entry->lse_stat.lrs_ast_us);
+		if (entry->lse_type == LDLM_EXTENT &&
+		    entry->lse_stat.lrs_conflict != 0)
+			seq_printf(m, ", extent: ["LPU64", "LPU64"]",
+				   entry->lse_stat.lrs_extent.start,
+				   entry->lse_stat.lrs_extent.end);
+		seq_printf(m, " }\n");
+	}
+
+	OBD_FREE_LARGE(data.lsd_top,
+		       LDLM_LOCKSTAT_TOP * sizeof(*data.lsd_top));
+	return 0;
+}
+
+static ssize_t lprocfs_ns_lockstat_seq_write(struct file *file,
+					     const char __user *buffer,
+					     size_t count, loff_t *off)
+{
+	struct seq_file		*m = file->private_data;
+	struct ldlm_namespace	*ns = m->private;
+	unsigned int		 val;
+	int			 rc;
+
+	rc = lprocfs_wr_uint(file, buffer, count, &val);
+	if (rc < 0)
+		return rc;
+
+	ns->ns_lockstat = !!val;
+	return count;
+}
+LPROC_SEQ_FOPS(lprocfs_ns_lockstat);
+#endif /* HAVE_SERVER_SUPPORT */
+
 static void ldlm_namespace_proc_unregister(struct ldlm_namespace *ns)
 {
 	if (ns->ns_proc_dir_entry == NULL)
@@ -489,6 +624,10 @@ static int ldlm_namespace_proc_register(struct ldlm_namespace *ns)
 			     &ns->ns_contended_locks, &ldlm_rw_uint_fops);
 		ldlm_add_var(&lock_vars[0], ns_pde, "max_parallel_ast",
 			     &ns->ns_max_parallel_ast, &ldlm_rw_uint_fops);
+#ifdef HAVE_SERVER_SUPPORT
+		ldlm_add_var(&lock_vars[0], ns_pde, "lockstat",
+			     ns, &lprocfs_ns_lockstat_fops);
+#endif
 	}
 	return 0;
 }
@@ -702,7 +841,8 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
                                          CFS_HASH_DEPTH |
                                          CFS_HASH_BIGNAME |
                                          CFS_HASH_SPIN_BKTLOCK |
-                                         CFS_HASH_NO_ITEMREF);
+                                         CFS_HASH_NO_ITEMREF |
+					 CFS_HASH_RCU_LOOKUP);
         if (ns->ns_rs_hash == NULL)
                 GOTO(out_ns, NULL);
 
@@ -1168,6 +1308,53 @@ static struct ldlm_resource *ldlm_resource_new(enum ldlm_type ldlm_type)
 	return res;
 }
 
+static void ldlm_resource_free(struct ldlm_resource *res)
+{
+	if (res->lr_stat != NULL)
+		OBD_FREE_PTR(res->lr_stat);
+	if (res->lr_itree != NULL)
+		OBD_SLAB_FREE(res->lr_itree, ldlm_interval_tree_slab,
+			      sizeof(*res->lr_itree) * LCK_MODE_NUM);
+	OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof(*res));
+}
+
+static void ldlm_resource_free_rcu(struct rcu_head *head)
+{
+	ldlm_resource_free(container_of(head, struct ldlm_resource, lr_rcu));
+}
+
+/**
+ * Lockless lookup of resource \a name in \a ns.
+ *
+ * Resources are freed after RCU grace period, so it is safe to walk the
+ * hash chain and compare names without the bucket lock, we only need to
+ * make sure the resource found is not being freed right now.
+ */
+static struct ldlm_resource *
+ldlm_resource_lookup_rcu(struct ldlm_namespace *ns,
+			 const struct ldlm_res_id *name)
+{
+	struct hlist_node	__maybe_unused *pos;
+	struct hlist_head	*hhead;
+	struct ldlm_resource	*res;
+	struct ldlm_resource	*found = NULL;
+
+	rcu_read_lock();
+	hhead = cfs_hash_hhead_rcu(ns->ns_rs_hash, (void *)name);
+	cfs_hlist_for_each_entry_rcu(res, pos, hhead, lr_hash) {
+		if (!ldlm_res_eq(name, &res->lr_name))
+			continue;
+		/* refcount dropped to zero, the resource is being removed
+		 * from hash under the bucket lock, take the slow path. */
+		if (atomic_inc_not_zero(&res->lr_refcount))
+			found = res;
+		break;
+	}
+	rcu_read_unlock();
+
+	return found;
+}
+
 /**
  * Return a reference to resource with given name, creating it if necessary.
  * Args: namespace with ns_lock unlocked
@@ -1190,6 +1377,10 @@ ldlm_resource_get(struct ldlm_namespace *ns, struct ldlm_resource *parent,
         LASSERT(ns->ns_rs_hash != NULL);
         LASSERT(name->name[0] != 0);
 
+	res = ldlm_resource_lookup_rcu(ns, name);
+	if (res != NULL)
+		return res;
+
         cfs_hash_bd_get_and_lock(ns->ns_rs_hash, (void *)name, &bd, 0);
         hnode = cfs_hash_bd_lookup_locked(ns->ns_rs_hash, &bd, (void *)name);
         if (hnode != NULL) {
@@ -1222,10 +1413,8 @@ ldlm_resource_get(struct ldlm_namespace *ns, struct ldlm_resource *parent,
 		cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 1);
 		/* Clean lu_ref for failed resource. */
 		lu_ref_fini(&res->lr_reference);
-		if (res->lr_itree != NULL)
-			OBD_SLAB_FREE(res->lr_itree, ldlm_interval_tree_slab,
-				      sizeof(*res->lr_itree) * LCK_MODE_NUM);
-		OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
+		/* It was never visible in the hash, free it right away. */
+		ldlm_resource_free(res);
 found:
 		res = hlist_entry(hnode, struct ldlm_resource, lr_hash);
 		return res;
@@ -1306,10 +1495,8 @@ int ldlm_resource_putref(struct ldlm_resource *res)
 		cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 1);
 		if (ns->ns_lvbo && ns->ns_lvbo->lvbo_free)
 			ns->ns_lvbo->lvbo_free(res);
-		if (res->lr_itree != NULL)
-			OBD_SLAB_FREE(res->lr_itree, ldlm_interval_tree_slab,
-				      sizeof(*res->lr_itree) * LCK_MODE_NUM);
-		OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
+		/* lockless lookups may still be comparing its name */
+		call_rcu(&res->lr_rcu, ldlm_resource_free_rcu);
 		return 1;
 	}
 	return 0;
@@ -0,0 +1,282 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * lustre/ldlm/ldlm_test.c
+ *
+ * Concurrent lookup/put stress of namespace resources.
+ *
+ * Setting up a "ldlm_test" device creates a private namespace and runs
+ * ldlm_resource_get()/ldlm_resource_putref() from 1, 2, 4 ... up to
+ * \a ldlm_test_threads threads. Most resources are pinned and hit the
+ * lockless lookup, the others are created and freed all the time so that
+ * lookups race with resource teardown. The lookup rate of every round is
+ * printed to the console, and setup fails if a lookup returned a wrong
+ * or dead resource.
+ */
+
+#define DEBUG_SUBSYSTEM S_LDLM
+
+#include <linux/kthread.h>
+#include <linux/module.h>
+#include <linux/init.h>
+
+#include <lustre_dlm.h>
+#include <obd_class.h>
+
+static int ldlm_test_threads;
+module_param(ldlm_test_threads, int, 0444);
+MODULE_PARM_DESC(ldlm_test_threads,
+		 "max lookup threads, default is the online CPU count");
+
+static int ldlm_test_seconds = 2;
+module_param(ldlm_test_seconds, int, 0444);
+MODULE_PARM_DESC(ldlm_test_seconds, "duration of each round in seconds");
+
+/* resources in the namespace */
+#define LDLM_TEST_NRES		1024
+/* one resource in LDLM_TEST_COLD is not pinned, it's freed on last put */
+#define LDLM_TEST_COLD		16
+
+struct ldlm_test_run {
+	struct ldlm_namespace	*ltr_ns;
+	cfs_time_t		 ltr_deadline;
+	atomic_t		 ltr_running;
+	struct completion	 ltr_start;
+	struct completion	 ltr_done;
+};
+
+struct ldlm_test_thread {
+	struct ldlm_test_run	*ltt_run;
+	unsigned int		 ltt_seed;
+	__u64			 ltt_ops;
+	int			 ltt_errors;
+};
+
+static void ldlm_test_name(struct ldlm_res_id *name, int idx)
+{
+	memset(name, 0, sizeof(*name));
+	name->name[LUSTRE_RES_ID_SEQ_OFF] = FID_SEQ_NORMAL;
+	name->name[LUSTRE_RES_ID_VER_OID_OFF] = idx + 1;
+}
+
+static int ldlm_test_thread_main(void *arg)
+{
+	struct ldlm_test_thread	*ltt = arg;
+	struct ldlm_test_run	*ltr = ltt->ltt_run;
+	struct ldlm_resource	*res;
+	struct ldlm_res_id	 name;
+	int			 idx;
+
+	wait_for_completion(&ltr->ltr_start);
+
+	while (cfs_time_before(cfs_time_current(), ltr->ltr_deadline)) {
+		ltt->ltt_seed = ltt->ltt_seed * 1103515245 + 12345;
+		idx = (ltt->ltt_seed >> 16) % LDLM_TEST_NRES;
+		ldlm_test_name(&name, idx);
+
+		res = ldlm_resource_get(ltr->ltr_ns, NULL, &name, LDLM_PLAIN,
+					1);
+		if (IS_ERR(res)) {
+			CERROR("resource %d get failed: rc = %ld\n", idx,
+			       PTR_ERR(res));
+			ltt->ltt_errors++;
+			break;
+		}
+
+		if (!ldlm_res_eq(&name, &res->lr_name) ||
+		    atomic_read(&res->lr_refcount) <= 0) {
+			CERROR("resource %d lookup got "DLDLMRES" ref %d\n",
+			       idx, PLDLMRES(res),
+			       atomic_read(&res->lr_refcount));
+			ltt->ltt_errors++;
+		}
+		ldlm_resource_putref(res);
+
+		ltt->ltt_ops++;
+		if ((ltt->ltt_ops & 1023) == 0)
+			cond_resched();
+	}
+
+	if (atomic_dec_and_test(&ltr->ltr_running))
+		complete(&ltr->ltr_done);
+	return 0;
+}
+
+/**
+ * Run \a nthreads lookup threads for ldlm_test_seconds, return the lookup
+ * rate in \a rate.
+ */
+static int ldlm_test_round(struct ldlm_namespace *ns, int nthreads,
+			   __u64 *rate)
+{
+	struct ldlm_test_run	 ltr;
+	struct ldlm_test_thread	*ltt;
+	struct task_struct	*task;
+	__u64			 ops = 0;
+	int			 errors = 0;
+	int			 started;
+	int			 i;
+	ENTRY;
+
+	OBD_ALLOC(ltt, sizeof(*ltt) * nthreads);
+	if (ltt == NULL)
+		RETURN(-ENOMEM);
+
+	ltr.ltr_ns = ns;
+	atomic_set(&ltr.ltr_running, 1);
+	init_completion(&ltr.ltr_start);
+	init_completion(&ltr.ltr_done);
+
+	for (started = 0; started < nthreads; started++) {
+		ltt[started].ltt_run = &ltr;
+		ltt[started].ltt_seed = started * 7919 + 1;
+		atomic_inc(&ltr.ltr_running);
+		task = kthread_run(ldlm_test_thread_main, &ltt[started],
+				   "ldlm_test_%02d", started);
+		if (IS_ERR(task)) {
+			atomic_dec(&ltr.ltr_running);
+			CERROR("cannot start thread %d: rc = %ld\n", started,
+			       PTR_ERR(task));
+			break;
+		}
+	}
+
+	ltr.ltr_deadline = cfs_time_shift(ldlm_test_seconds);
+	complete_all(&ltr.ltr_start);
+	if (!atomic_dec_and_test(&ltr.ltr_running))
+		wait_for_completion(&ltr.ltr_done);
+
+	for (i = 0; i < started; i++) {
+		ops += ltt[i].ltt_ops;
+		errors += ltt[i].ltt_errors;
+	}
+	OBD_FREE(ltt, sizeof(*ltt) * nthreads);
+
+	if (started < nthreads)
+		RETURN(-ENOMEM);
+	if (errors > 0)
+		RETURN(-EIO);
+
+	*rate = ops;
+	do_div(*rate, ldlm_test_seconds);
+	RETURN(0);
+}
+
+static int ldlm_test_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
+{
+	struct ldlm_resource	**pinned;
+	struct ldlm_namespace	 *ns;
+	struct ldlm_res_id	  name;
+	__u64			  base = 0;
+	__u64			  rate;
+	__u64			  scale;
+	int			  max = ldlm_test_threads;
+	int			  nthreads;
+	int			  rc = 0;
+	int			  i;
+	ENTRY;
+
+	if (max <= 0)
+		max = num_online_cpus();
+	if (ldlm_test_seconds <= 0)
+		ldlm_test_seconds = 1;
+
+	OBD_ALLOC(pinned, sizeof(*pinned) * LDLM_TEST_NRES);
+	if (pinned == NULL)
+		RETURN(-ENOMEM);
+
+	ns = ldlm_namespace_new(obd, obd->obd_name, LDLM_NAMESPACE_SERVER,
+				LDLM_NAMESPACE_MODEST, LDLM_NS_TYPE_MDT);
+	if (ns == NULL)
+		GOTO(out_pinned, rc = -ENOMEM);
+
+	for (i = 0; i < LDLM_TEST_NRES; i++) {
+		if (i % LDLM_TEST_COLD == 0)
+			continue;
+
+		ldlm_test_name(&name, i);
+		pinned[i] = ldlm_resource_get(ns, NULL, &name, LDLM_PLAIN, 1);
+		if (IS_ERR(pinned[i])) {
+			rc = PTR_ERR(pinned[i]);
+			pinned[i] = NULL;
+			GOTO(out_ns, rc);
+		}
+	}
+
+	for (nthreads = 1; ; nthreads = min(nthreads * 2, max)) {
+		rc = ldlm_test_round(ns, nthreads, &rate);
+		if (rc != 0) {
+			CERROR("%s: %d threads failed: rc = %d\n",
+			       obd->obd_name, nthreads, rc);
+			break;
+		}
+
+		if (base == 0)
+			base = max_t(__u64, rate, 1);
+		scale = rate * 100;
+		do_div(scale, base);
+		LCONSOLE_INFO("%s: %d threads: "LPU64" lookups/s, "LPU64
+			      "%% of 1 thread\n", obd->obd_name, nthreads,
+			      rate, scale);
+		if (nthreads == max)
+			break;
+	}
+
+out_ns:
+	for (i = 0; i < LDLM_TEST_NRES; i++)
+		if (pinned[i] != NULL)
+			ldlm_resource_putref(pinned[i]);
+	ldlm_namespace_free(ns, NULL, 1);
+out_pinned:
+	OBD_FREE(pinned, sizeof(*pinned) * LDLM_TEST_NRES);
+	RETURN(rc);
+}
+
+static int ldlm_test_cleanup(struct obd_device *obd)
+{
+	return 0;
+}
+
+static struct obd_ops ldlm_test_obd_ops = {
+	.o_owner	= THIS_MODULE,
+	.o_setup	= ldlm_test_setup,
+	.o_cleanup	= ldlm_test_cleanup,
+};
+
+static int __init ldlm_test_init(void)
+{
+	return class_register_type(&ldlm_test_obd_ops, NULL, true, NULL,
+				   "ldlm_test", NULL);
+}
+
+static void __exit ldlm_test_exit(void)
+{
+	class_unregister_type("ldlm_test");
+}
+
+MODULE_AUTHOR("OpenSFS, Inc. <http://www.lustre.org/>");
+MODULE_DESCRIPTION("Lustre DLM resource lookup test module");
+MODULE_VERSION(LUSTRE_VERSION_STRING);
+MODULE_LICENSE("GPL");
+
+module_init(ldlm_test_init);
+module_exit(ldlm_test_exit);
@@ -1542,6 +1542,34 @@ out_rmdir:
 		RETURN(ll_fid2path(inode, (void __user *)arg));
 	case LL_IOC_GETPARENT:
 		RETURN(ll_getparent(file, (void __user *)arg));
+	case LL_IOC_STATAHEAD: {
+		struct ll_statahead_names lsn;
+		char *names;
+
+		if (copy_from_user(&lsn, (void __user *)arg, sizeof(lsn)))
+			RETURN(-EFAULT);
+
+		if (lsn.lsn_count == 0 || lsn.lsn_count > LL_SA_NAMES_BATCH ||
+		    lsn.lsn_size == 0 ||
+		    lsn.lsn_size > lsn.lsn_count * (NAME_MAX + 1))
+			RETURN(-EINVAL);
+
+		OBD_ALLOC_LARGE(names, lsn.lsn_size);
+		if (names == NULL)
+			RETURN(-ENOMEM);
+
+		if (copy_from_user(names, (char __user *)arg + sizeof(lsn),
+				   lsn.lsn_size))
+			GOTO(out_names, rc = -EFAULT);
+
+		rc = ll_statahead_names(file, names, lsn.lsn_size,
+					lsn.lsn_count, lsn.lsn_flags);
+		if (rc == 0)
+			RETURN(0);
+out_names:
+		OBD_FREE_LARGE(names, lsn.lsn_size);
+		RETURN(rc);
+	}
 	case LL_IOC_FID2MDTIDX: {
 		struct obd_export *exp = ll_i2mdexp(inode);
 		struct lu_fid	  fid;
@@ -451,6 +451,7 @@ static int ll_local_open(struct file *file, struct lookup_intent *it,
 			 struct ll_file_data *fd, struct obd_client_handle *och)
 {
 	struct inode *inode = file->f_path.dentry->d_inode;
+	int i;
 	ENTRY;
 
 	LASSERT(!LUSTRE_FPRIVATE(file));
@@ -466,7 +467,8 @@ static int ll_local_open(struct file *file, struct lookup_intent *it,
 	}
 
 	LUSTRE_FPRIVATE(file) = fd;
-	ll_readahead_init(inode, &fd->fd_ras);
+	for (i = 0; i < LL_RA_STREAMS; i++)
+		ll_readahead_init(inode, &fd->fd_ras[i]);
 	fd->fd_omode = it->it_flags & (FMODE_READ | FMODE_WRITE | FMODE_EXEC);
 
 	/* ll_cl_context initialize */
@@ -1010,7 +1012,7 @@ static bool file_is_noatime(const struct file *file)
 	return false;
 }
 
-static void ll_io_init(struct cl_io *io, const struct file *file, int write)
+void ll_io_init(struct cl_io *io, const struct file *file, int write)
 {
 	struct inode *inode = file->f_path.dentry->d_inode;
 
@@ -1166,23 +1168,74 @@ out:
 /*
  * Read from a file (through the page cache).
  */
+/*
+ * Read from the page cache without building a cl_io.
+ *
+ * Pages that are uptodate in the page cache are covered by a DLM lock, since
+ * lock cancellation discards them, so they can be copied out directly by the
+ * generic read code. ll_readpage() fails with -ENODATA for anything which
+ * needs the IO stack (a page not in cache, or readahead to be issued), and
+ * the remainder of the request is then done by the normal read path.
+ */
+static ssize_t ll_do_fast_read(const struct lu_env *env, struct kiocb *iocb,
+			       struct iov_iter *iter)
+{
+#ifdef HAVE_FILE_OPERATIONS_READ_WRITE_ITER
+	struct file *file = iocb->ki_filp;
+	struct inode *inode = file->f_path.dentry->d_inode;
+	ssize_t result;
+
+	if (!(ll_i2sbi(inode)->ll_flags & LL_SBI_FAST_READ))
+		return 0;
+
+	/* direct IO and lockless IO need the IO stack */
+	if (file->f_flags & O_DIRECT || ll_file_nolock(file))
+		return 0;
+
+	ll_cl_add(file, env, NULL);
+	result = generic_file_read_iter(iocb, iter);
+	ll_cl_remove(file, env);
+
+	/* the first page was not in cache, see ll_fast_readpage() */
+	if (result == -ENODATA)
+		result = 0;
+
+	if (result > 0)
+		ll_stats_ops_tally(ll_i2sbi(inode), LPROC_LL_READ_BYTES,
+				   result);
+	return result;
+#else
+	return 0;
+#endif
+}
+
 static ssize_t ll_file_read_iter(struct kiocb *iocb, struct iov_iter *to)
 {
 	struct vvp_io_args *args;
 	struct lu_env *env;
 	ssize_t result;
+	ssize_t rc2;
 	__u16 refcheck;
 
 	env = cl_env_get(&refcheck);
 	if (IS_ERR(env))
 		return PTR_ERR(env);
 
+	result = ll_do_fast_read(env, iocb, to);
+	if (result < 0 || iov_iter_count(to) == 0)
+		GOTO(out, result);
+
 	args = ll_env_args(env, IO_NORMAL);
 	args->u.normal.via_iter = to;
 	args->u.normal.via_iocb = iocb;
 
-	result = ll_file_io_generic(env, args, iocb->ki_filp, CIT_READ,
-				    &iocb->ki_pos, iov_iter_count(to));
+	rc2 = ll_file_io_generic(env, args, iocb->ki_filp, CIT_READ,
+				 &iocb->ki_pos, iov_iter_count(to));
+	if (rc2 > 0)
+		result += rc2;
+	else if (result == 0)
+		result = rc2;
+out:
 	cl_env_put(env, &refcheck);
 	return result;
 }
@@ -3322,7 +3375,7 @@ static int ll_inode_revalidate_fini(struct inode *inode, int rc)
 	return rc;
 }
 
-static int __ll_inode_revalidate(struct dentry *dentry, __u64 ibits)
+int __ll_inode_revalidate(struct dentry *dentry, __u64 ibits)
 {
         struct inode *inode = dentry->d_inode;
         struct ptlrpc_request *req = NULL;
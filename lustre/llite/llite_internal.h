@@ -187,6 +187,8 @@ struct ll_inode_info {
 			unsigned int			lli_sa_enabled:1;
 			/* generation for statahead */
 			unsigned int			lli_sa_generation;
+			/* negative lookups without UPDATE lock on dir */
+			unsigned int			lli_neg_lookups;
 			/* directory stripe information */
 			struct lmv_stripe_md		*lli_lsm_md;
 			/* default directory stripe offset.  This is extracted
@@ -340,6 +342,12 @@ static inline struct ll_inode_info *ll_i2info(struct inode *inode)
 /* default to read-ahead full files smaller than 2MB on the second read */
 #define SBI_DEFAULT_READAHEAD_WHOLE_MAX	(2UL << (20 - PAGE_CACHE_SHIFT))
 
+/* read ahead from a worker thread once a stream's window reaches 4MB */
+#define SBI_DEFAULT_READAHEAD_ASYNC_THRESHOLD	(4UL << (20 - PAGE_CACHE_SHIFT))
+
+/* default number of queued or running async read-ahead requests */
+#define SBI_DEFAULT_READAHEAD_ASYNC_ACTIVE	16
+
 enum ra_stat {
         RA_STAT_HIT = 0,
         RA_STAT_MISS,
@@ -354,6 +362,8 @@ enum ra_stat {
         RA_STAT_MAX_IN_FLIGHT,
         RA_STAT_WRONG_GRAB_PAGE,
 	RA_STAT_FAILED_REACH_END,
+	RA_STAT_ASYNC,
+	RA_STAT_ASYNC_LATE,
 	_NR_RA_STAT,
 };
 
@@ -362,6 +372,12 @@ struct ll_ra_info {
 	unsigned long	ra_max_pages;
 	unsigned long	ra_max_pages_per_file;
 	unsigned long	ra_max_read_ahead_whole_pages;
+	/* window size from which a stream is read ahead by a worker */
+	unsigned long	ra_async_pages_per_file_threshold;
+	/* maximum number of queued or running async read-ahead requests,
+	 * 0 disables async read-ahead */
+	unsigned int	ra_async_max_active;
+	atomic_t	ra_async_inflight;
 };
 
 /* ra_io_arg will be filled in the beginning of ll_readahead with
@@ -445,6 +461,7 @@ enum stats_track_type {
 #define LL_SBI_NOROOTSQUASH  0x100000 /* do not apply root squash */
 #define LL_SBI_ALWAYS_PING   0x200000 /* always ping even if server
 				       * suppress_pings */
+#define LL_SBI_FAST_READ     0x400000 /* fast read support */
 
 #define LL_SBI_FLAGS { 	\
 	"nolck",	\
@@ -469,6 +486,7 @@ enum stats_track_type {
 	"xattr_cache",	\
 	"norootsquash",	\
 	"always_ping",	\
+	"fast_read",	\
 }
 
 #define RCE_HASHES      32
@@ -568,13 +586,23 @@ struct ll_sb_info {
 
 	/* metadata stat-ahead */
 	unsigned int		  ll_sa_max;     /* max statahead RPCs */
+	unsigned int		  ll_sa_running_max; /* max concurrent
+						      * statahead threads */
 	atomic_t		  ll_sa_total;   /* statahead thread started
 						  * count */
 	atomic_t		  ll_sa_wrong;   /* statahead thread stopped for
 						  * low hit ratio */
 	atomic_t		  ll_sa_running; /* running statahead thread
 						  * count */
-	atomic_t		  ll_agl_total;  /* AGL thread started count */
+	atomic_t		  ll_agl_total;  /* statahead with AGL count */
+	atomic_t		  ll_sa_pattern; /* statahead of name pattern
+						  * count */
+	atomic_t		  ll_sa_list;	 /* name list batches
+						  * stat'ed ahead */
+	atomic_t		  ll_sa_hit;	 /* lookups served by
+						  * statahead */
+	atomic_t		  ll_sa_miss;	 /* lookups missed by
+						  * statahead */
 
 	dev_t			  ll_sdev_orig; /* save s_dev before assign for
 						 * clustred nfs */
@@ -586,10 +614,22 @@ struct ll_sb_info {
 };
 
 /*
- * per file-descriptor read-ahead data.
+ * Number of independent read-ahead streams tracked per file descriptor, so
+ * that several threads reading different parts of a file through the same
+ * descriptor don't reset each other's read-ahead window.
+ */
+#define LL_RA_STREAMS	4
+
+/*
+ * per file-descriptor read-ahead data, one for each stream.
  */
 struct ll_readahead_state {
 	spinlock_t  ras_lock;
+	/*
+	 * jiffies of the last request assigned to this stream, used to
+	 * recycle the least recently used stream, see ll_ras_find().
+	 */
+	unsigned long	ras_last_used;
         /*
          * index of the last page that read(2) needed and that wasn't in the
          * cache. Used by ras_update() to detect seeks.
@@ -668,12 +708,23 @@ struct ll_readahead_state {
          * stride read-ahead will be enable
          */
         unsigned long   ras_consecutive_stride_requests;
+	/*
+	 * Pages [ras_async_start, ras_async_end] are being read ahead by a
+	 * worker thread while ras_async_pending is set. A reader reaching
+	 * them first means read-ahead is issued too late, and the window is
+	 * grown faster, see ras_update(). ras_async_late is set once this
+	 * happened for the pending range.
+	 */
+	pgoff_t		ras_async_start;
+	pgoff_t		ras_async_end;
+	bool		ras_async_pending;
+	bool		ras_async_late;
 };
 
 extern struct kmem_cache *ll_file_data_slab;
 struct lustre_handle;
 struct ll_file_data {
-	struct ll_readahead_state fd_ras;
+	struct ll_readahead_state fd_ras[LL_RA_STREAMS];
 	struct ll_grouplock fd_grouplock;
 	__u64 lfd_pos;
 	__u32 fd_flags;
@@ -714,7 +765,9 @@ static inline int ll_need_32bit_api(struct ll_sb_info *sbi)
 #endif
 }
 
-void ll_ras_enter(struct file *f);
+struct ll_readahead_state *ll_ras_enter(struct file *f, pgoff_t index);
+struct ll_readahead_state *ll_ras_find(struct ll_file_data *fd,
+				       pgoff_t index);
 
 /* llite/lcommon_misc.c */
 int cl_ocd_update(struct obd_device *host, struct obd_device *watched,
@@ -822,6 +875,8 @@ int vvp_io_write_commit(const struct lu_env *env, struct cl_io *io);
 struct ll_cl_context *ll_cl_find(struct file *file);
 void ll_cl_add(struct file *file, const struct lu_env *env, struct cl_io *io);
 void ll_cl_remove(struct file *file, const struct lu_env *env);
+int ll_readahead_sched_init(void);
+void ll_readahead_sched_fini(void);
 
 #ifndef MS_HAS_NEW_AOPS
 extern const struct address_space_operations ll_aops;
@@ -840,6 +895,7 @@ extern enum ldlm_mode ll_take_md_lock(struct inode *inode, __u64 bits,
 				      struct lustre_handle *lockh, __u64 flags,
 				      enum ldlm_mode mode);
 
+void ll_io_init(struct cl_io *io, const struct file *file, int write);
 int ll_file_open(struct inode *inode, struct file *file);
 int ll_file_release(struct inode *inode, struct file *file);
 int ll_release_openhandle(struct dentry *, struct lookup_intent *);
@@ -848,6 +904,7 @@ extern void ll_rw_stats_tally(struct ll_sb_info *sbi, pid_t pid,
                               struct ll_file_data *file, loff_t pos,
                               size_t count, int rw);
 int ll_getattr(struct vfsmount *mnt, struct dentry *de, struct kstat *stat);
+int __ll_inode_revalidate(struct dentry *dentry, __u64 ibits);
 struct posix_acl *ll_get_acl(struct inode *inode, int type);
 int ll_migrate(struct inode *parent, struct file *file, int mdtidx,
 	       const char *name, int namelen);
@@ -1180,7 +1237,15 @@ void et_fini(struct eacl_table *et);
 #define LL_SA_RPC_DEF           32
 #define LL_SA_RPC_MAX           8192
 
-#define LL_SA_CACHE_BIT         5
+/* negative lookups in a dir before its UPDATE lock is fetched to cache them */
+#define LL_NEG_LOOKUP_LOCK	4
+
+/* statahead threads running at a time per client */
+#define LL_SA_RUNNING_DEF	16
+#define LL_SA_RUNNING_MAX	256
+
+/* sized for a full LL_SA_RPC_MAX window, ~32 entries per bucket */
+#define LL_SA_CACHE_BIT         8
 #define LL_SA_CACHE_SIZE        (1 << LL_SA_CACHE_BIT)
 #define LL_SA_CACHE_MASK        (LL_SA_CACHE_SIZE - 1)
 
@@ -1213,10 +1278,10 @@ struct ll_statahead_info {
 	unsigned int            sai_ls_all:1,   /* "ls -al", do stat-ahead for
 						 * hidden entries */
 				sai_agl_valid:1,/* AGL is valid for the dir */
-				sai_in_readpage:1;/* statahead is in readdir()*/
+				sai_in_readpage:1,/* statahead is in readdir()*/
+				sai_pattern_eof:1;/* pattern name not found */
 	wait_queue_head_t	sai_waitq;	/* stat-ahead wait queue */
-	struct ptlrpc_thread	sai_thread;	/* stat-ahead thread */
-	struct ptlrpc_thread	sai_agl_thread;	/* AGL thread */
+	struct ptlrpc_thread	sai_thread;	/* stat-ahead and AGL thread */
 	struct list_head	sai_interim_entries; /* entries which got async
 						      * stat reply, but not
 						      * instantiated */
@@ -1225,9 +1290,25 @@ struct ll_statahead_info {
 	struct list_head	sai_cache[LL_SA_CACHE_SIZE];
 	spinlock_t		sai_cache_lock[LL_SA_CACHE_SIZE];
 	atomic_t		sai_cache_count; /* entry count in cache */
+	struct list_head	sai_names;	/* name batches from
+						 * LL_IOC_STATAHEAD to stat
+						 * instead of readdir, under
+						 * lli_sa_lock */
+	__u32			sai_names_queued;/* names in sai_names */
+	bool			sai_names_replaced;/* LL_SA_NAMES_REPLACE
+						    * dropped the batch being
+						    * stat'ed */
+	__u64			sai_pattern_next;/* next "<prefix><number>"
+						  * name to stat */
+	unsigned int		sai_pattern_len;/* prefix length */
+	unsigned int		sai_pattern_width;/* number width, 0 if no
+						   * pattern is followed */
+	char			sai_pattern[NAME_MAX + 1];/* name prefix */
 };
 
 int ll_statahead(struct inode *dir, struct dentry **dentry, bool unplug);
+int ll_statahead_names(struct file *file, char *names, __u32 size,
+		       __u32 count, __u32 flags);
 void ll_authorize_statahead(struct inode *dir, void *key);
 void ll_deauthorize_statahead(struct inode *dir, void *key);
 
@@ -104,6 +104,11 @@ static struct ll_sb_info *ll_init_sbi(void)
 	sbi->ll_ra_info.ra_max_pages = sbi->ll_ra_info.ra_max_pages_per_file;
 	sbi->ll_ra_info.ra_max_read_ahead_whole_pages =
 					   SBI_DEFAULT_READAHEAD_WHOLE_MAX;
+	sbi->ll_ra_info.ra_async_pages_per_file_threshold =
+					   SBI_DEFAULT_READAHEAD_ASYNC_THRESHOLD;
+	sbi->ll_ra_info.ra_async_max_active =
+					   SBI_DEFAULT_READAHEAD_ASYNC_ACTIVE;
+	atomic_set(&sbi->ll_ra_info.ra_async_inflight, 0);
 	INIT_LIST_HEAD(&sbi->ll_conn_chain);
 	INIT_LIST_HEAD(&sbi->ll_orphan_dentry_list);
 
@@ -129,11 +134,17 @@ static struct ll_sb_info *ll_init_sbi(void)
 
 	/* metadata statahead is enabled by default */
 	sbi->ll_sa_max = LL_SA_RPC_DEF;
+	sbi->ll_sa_running_max = LL_SA_RUNNING_DEF;
 	atomic_set(&sbi->ll_sa_total, 0);
 	atomic_set(&sbi->ll_sa_wrong, 0);
 	atomic_set(&sbi->ll_sa_running, 0);
 	atomic_set(&sbi->ll_agl_total, 0);
+	atomic_set(&sbi->ll_sa_pattern, 0);
+	atomic_set(&sbi->ll_sa_list, 0);
+	atomic_set(&sbi->ll_sa_hit, 0);
+	atomic_set(&sbi->ll_sa_miss, 0);
 	sbi->ll_flags |= LL_SBI_AGL_ENABLED;
+	sbi->ll_flags |= LL_SBI_FAST_READ;
 
 	/* root squash */
 	sbi->ll_squash.rsi_uid = 0;
@@ -407,7 +418,8 @@ static int client_common_fill_super(struct super_block *sb, char *md, char *dt,
 				  OBD_CONNECT_JOBSTATS | OBD_CONNECT_LVB_TYPE |
 				  OBD_CONNECT_LAYOUTLOCK |
 				  OBD_CONNECT_PINGLESS | OBD_CONNECT_LFSCK |
-				  OBD_CONNECT_BULK_MBITS;
+				  OBD_CONNECT_BULK_MBITS |
+				  OBD_CONNECT_MULTIOBJ_BRW;
 
 	if (!OBD_FAIL_CHECK(OBD_FAIL_OSC_CONNECT_GRANT_PARAM))
 		data->ocd_connect_flags |= OBD_CONNECT_GRANT_PARAM;
@@ -238,6 +238,37 @@ static ssize_t ll_xattr_cache_seq_write(struct file *file,
 }
 LPROC_SEQ_FOPS(ll_xattr_cache);
 
+static int ll_fast_read_seq_show(struct seq_file *m, void *v)
+{
+	struct ll_sb_info *sbi = ll_s2sbi((struct super_block *)m->private);
+
+	seq_printf(m, "%u\n", !!(sbi->ll_flags & LL_SBI_FAST_READ));
+	return 0;
+}
+
+static ssize_t ll_fast_read_seq_write(struct file *file,
+				      const char __user *buffer,
+				      size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct ll_sb_info *sbi = ll_s2sbi((struct super_block *)m->private);
+	int val, rc;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	spin_lock(&sbi->ll_lock);
+	if (val)
+		sbi->ll_flags |= LL_SBI_FAST_READ;
+	else
+		sbi->ll_flags &= ~LL_SBI_FAST_READ;
+	spin_unlock(&sbi->ll_lock);
+
+	return count;
+}
+LPROC_SEQ_FOPS(ll_fast_read);
+
 static int ll_site_stats_seq_show(struct seq_file *m, void *v)
 {
 	struct super_block *sb = m->private;
@@ -398,6 +429,91 @@ ll_max_read_ahead_whole_mb_seq_write(struct file *file,
 }
 LPROC_SEQ_FOPS(ll_max_read_ahead_whole_mb);
 
+static int ll_max_read_ahead_async_active_seq_show(struct seq_file *m,
+						   void *v)
+{
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+
+	seq_printf(m, "%u\n", sbi->ll_ra_info.ra_async_max_active);
+	return 0;
+}
+
+static ssize_t
+ll_max_read_ahead_async_active_seq_write(struct file *file,
+					 const char __user *buffer,
+					 size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+	int rc, val;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	if (val < 0) {
+		CERROR("%s: can't set max_read_ahead_async_active=%d < 0\n",
+		       ll_get_fsname(sb, NULL, 0), val);
+		return -ERANGE;
+	}
+
+	sbi->ll_ra_info.ra_async_max_active = val;
+	return count;
+}
+LPROC_SEQ_FOPS(ll_max_read_ahead_async_active);
+
+static int ll_read_ahead_async_file_threshold_mb_seq_show(struct seq_file *m,
+							  void *v)
+{
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+	long pages_number;
+	int mult;
+
+	spin_lock(&sbi->ll_lock);
+	pages_number = sbi->ll_ra_info.ra_async_pages_per_file_threshold;
+	spin_unlock(&sbi->ll_lock);
+
+	mult = 1 << (20 - PAGE_CACHE_SHIFT);
+	return lprocfs_seq_read_frac_helper(m, pages_number, mult);
+}
+
+static ssize_t
+ll_read_ahead_async_file_threshold_mb_seq_write(struct file *file,
+						const char __user *buffer,
+						size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+	int pages_shift, rc, pages_number;
+
+	pages_shift = 20 - PAGE_CACHE_SHIFT;
+	rc = lprocfs_write_frac_helper(buffer, count, &pages_number,
+				       1 << pages_shift);
+	if (rc)
+		return rc;
+
+	/* a stream never gets a larger window than this */
+	if (pages_number < 0 ||
+	    pages_number > sbi->ll_ra_info.ra_max_pages_per_file) {
+		CERROR("%s: can't set read_ahead_async_file_threshold_mb=%u > "
+		       "max_read_ahead_per_file_mb=%lu\n",
+		       ll_get_fsname(sb, NULL, 0),
+		       pages_number >> pages_shift,
+		       sbi->ll_ra_info.ra_max_pages_per_file >> pages_shift);
+		return -ERANGE;
+	}
+
+	spin_lock(&sbi->ll_lock);
+	sbi->ll_ra_info.ra_async_pages_per_file_threshold = pages_number;
+	spin_unlock(&sbi->ll_lock);
+	return count;
+}
+LPROC_SEQ_FOPS(ll_read_ahead_async_file_threshold_mb);
+
 static int ll_max_cached_mb_seq_show(struct seq_file *m, void *v)
 {
 	struct super_block     *sb    = m->private;
@@ -408,7 +524,7 @@ static int ll_max_cached_mb_seq_show(struct seq_file *m, void *v)
 	long unused_mb;
 
 	max_cached_mb = cache->ccc_lru_max >> shift;
-	unused_mb = atomic_long_read(&cache->ccc_lru_left) >> shift;
+	unused_mb = cl_cache_lru_left(cache) >> shift;
 	seq_printf(m, "users: %d\n"
 		   "max_cached_mb: %ld\n"
 		   "used_mb: %ld\n"
@@ -474,7 +590,7 @@ ll_max_cached_mb_seq_write(struct file *file, const char __user *buffer,
 
 	/* easy - add more LRU slots. */
 	if (diff >= 0) {
-		atomic_long_add(diff, &cache->ccc_lru_left);
+		cl_cache_lru_give(cache, NUMA_NO_NODE, diff);
 		GOTO(out, rc = 0);
 	}
 
@@ -486,22 +602,10 @@ ll_max_cached_mb_seq_write(struct file *file, const char __user *buffer,
 	while (diff > 0) {
 		long tmp;
 
-		/* reduce LRU budget from free slots. */
-		do {
-			long ov, nv;
-
-			ov = atomic_long_read(&cache->ccc_lru_left);
-			if (ov == 0)
-				break;
-
-			nv = ov > diff ? ov - diff : 0;
-			rc = atomic_long_cmpxchg(&cache->ccc_lru_left, ov, nv);
-			if (likely(ov == rc)) {
-				diff -= ov - nv;
-				nrpages += ov - nv;
-				break;
-			}
-		} while (1);
+		/* reduce LRU budget from free slots of all nodes. */
+		tmp = cl_cache_lru_shrink(cache, diff);
+		diff -= tmp;
+		nrpages += tmp;
 
 		if (diff <= 0)
 			break;
@@ -529,12 +633,34 @@ out:
 		spin_unlock(&sbi->ll_lock);
 		rc = count;
 	} else {
-		atomic_long_add(nrpages, &cache->ccc_lru_left);
+		cl_cache_lru_give(cache, NUMA_NO_NODE, nrpages);
 	}
 	return rc;
 }
 LPROC_SEQ_FOPS(ll_max_cached_mb);
 
+static int ll_cache_node_stats_seq_show(struct seq_file *m, void *v)
+{
+	struct super_block     *sb    = m->private;
+	struct ll_sb_info      *sbi   = ll_s2sbi(sb);
+	struct cl_client_cache *cache = sbi->ll_cache;
+	int shift = 20 - PAGE_CACHE_SHIFT;
+	int nid;
+
+	seq_printf(m, "%-6s %12s %12s %12s\n",
+		   "node", "unused_mb", "borrowed", "reclaimed");
+	for_each_online_node(nid) {
+		struct cl_cache_node *ccn = &cache->ccc_nodes[nid];
+
+		seq_printf(m, "%-6d %12ld %12ld %12ld\n", nid,
+			   atomic_long_read(&ccn->ccn_lru_left) >> shift,
+			   atomic_long_read(&ccn->ccn_borrowed),
+			   atomic_long_read(&ccn->ccn_reclaimed));
+	}
+	return 0;
+}
+LPROC_SEQ_FOPS_RO(ll_cache_node_stats);
+
 static int ll_checksum_seq_show(struct seq_file *m, void *v)
 {
 	struct super_block *sb = m->private;
@@ -710,6 +836,40 @@ static ssize_t ll_statahead_agl_seq_write(struct file *file,
 }
 LPROC_SEQ_FOPS(ll_statahead_agl);
 
+static int ll_statahead_running_max_seq_show(struct seq_file *m, void *v)
+{
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+
+	seq_printf(m, "%u\n", sbi->ll_sa_running_max);
+	return 0;
+}
+
+static ssize_t ll_statahead_running_max_seq_write(struct file *file,
+						  const char __user *buffer,
+						  size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+	int val, rc;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	if (val < 0 || val > LL_SA_RUNNING_MAX) {
+		CERROR("%s: bad statahead_running_max value %d. Valid values "
+		       "are in the range [0, %d]\n", ll_get_fsname(sb, NULL, 0),
+		       val, LL_SA_RUNNING_MAX);
+		return -ERANGE;
+	}
+
+	sbi->ll_sa_running_max = val;
+	return count;
+}
+LPROC_SEQ_FOPS(ll_statahead_running_max);
+
 static int ll_statahead_stats_seq_show(struct seq_file *m, void *v)
 {
 	struct super_block *sb = m->private;
@@ -717,10 +877,20 @@ static int ll_statahead_stats_seq_show(struct seq_file *m, void *v)
 
 	seq_printf(m, "statahead total: %u\n"
 		    "statahead wrong: %u\n"
-		    "agl total: %u\n",
+		    "agl total: %u\n"
+		    "statahead pattern: %u\n"
+		    "statahead list: %u\n"
+		    "statahead hit: %u\n"
+		    "statahead miss: %u\n"
+		    "statahead running: %u\n",
 		    atomic_read(&sbi->ll_sa_total),
 		    atomic_read(&sbi->ll_sa_wrong),
-		    atomic_read(&sbi->ll_agl_total));
+		    atomic_read(&sbi->ll_agl_total),
+		    atomic_read(&sbi->ll_sa_pattern),
+		    atomic_read(&sbi->ll_sa_list),
+		    atomic_read(&sbi->ll_sa_hit),
+		    atomic_read(&sbi->ll_sa_miss),
+		    atomic_read(&sbi->ll_sa_running));
 	return 0;
 }
 LPROC_SEQ_FOPS_RO(ll_statahead_stats);
@@ -1007,8 +1177,14 @@ struct lprocfs_vars lprocfs_llite_obd_vars[] = {
 	  .fops	=	&ll_max_readahead_per_file_mb_fops	},
 	{ .name	=	"max_read_ahead_whole_mb",
 	  .fops	=	&ll_max_read_ahead_whole_mb_fops	},
+	{ .name	=	"max_read_ahead_async_active",
+	  .fops	=	&ll_max_read_ahead_async_active_fops	},
+	{ .name	=	"read_ahead_async_file_threshold_mb",
+	  .fops	=	&ll_read_ahead_async_file_threshold_mb_fops },
 	{ .name	=	"max_cached_mb",
 	  .fops	=	&ll_max_cached_mb_fops			},
+	{ .name	=	"cache_node_stats",
+	  .fops	=	&ll_cache_node_stats_fops		},
 	{ .name	=	"checksum_pages",
 	  .fops	=	&ll_checksum_fops			},
 	{ .name	=	"stats_track_pid",
@@ -1021,6 +1197,8 @@ struct lprocfs_vars lprocfs_llite_obd_vars[] = {
 	  .fops	=	&ll_statahead_max_fops			},
 	{ .name	=	"statahead_agl",
 	  .fops	=	&ll_statahead_agl_fops			},
+	{ .name	=	"statahead_running_max",
+	  .fops	=	&ll_statahead_running_max_fops		},
 	{ .name	=	"statahead_stats",
 	  .fops	=	&ll_statahead_stats_fops		},
 	{ .name	=	"lazystatfs",
@@ -1033,6 +1211,8 @@ struct lprocfs_vars lprocfs_llite_obd_vars[] = {
 	  .fops	=	&ll_sbi_flags_fops			},
 	{ .name	=	"xattr_cache",
 	  .fops	=	&ll_xattr_cache_fops			},
+	{ .name	=	"fast_read",
+	  .fops	=	&ll_fast_read_fops			},
 	{ .name	=	"unstable_stats",
 	  .fops	=	&ll_unstable_stats_fops			},
 	{ .name	=	"root_squash",
@@ -1124,7 +1304,9 @@ static const char *ra_stat_string[] = {
 	[RA_STAT_EOF] = "read-ahead to EOF",
 	[RA_STAT_MAX_IN_FLIGHT] = "hit max r-a issue",
 	[RA_STAT_WRONG_GRAB_PAGE] = "wrong page from grab_cache_page",
-	[RA_STAT_FAILED_REACH_END] = "failed to reach end"
+	[RA_STAT_FAILED_REACH_END] = "failed to reach end",
+	[RA_STAT_ASYNC] = "async readahead",
+	[RA_STAT_ASYNC_LATE] = "async readahead late",
 };
 
 LPROC_SEQ_FOPS_RO_TYPE(llite, name);
@@ -536,6 +536,19 @@ static int ll_lookup_it_finish(struct ptlrpc_request *request,
 				       NULL)) {
 			d_lustre_revalidate(*de);
 			ll_intent_release(&parent_it);
+		} else if (ll_i2info(parent)->lli_lsm_md == NULL &&
+			   ++ll_i2info(parent)->lli_neg_lookups >=
+			   LL_NEG_LOOKUP_LOCK) {
+			/* Names keep missing in this directory, e.g. PATH or
+			 * module search, fetch its UPDATE lock so that the
+			 * following negative dentries are cached until it
+			 * changes. This dentry stays hidden, the name might
+			 * be created before the lock is granted. */
+			ll_i2info(parent)->lli_neg_lookups = 0;
+			rc = __ll_inode_revalidate((*de)->d_parent,
+						   MDS_INODELOCK_UPDATE);
+			CDEBUG(D_DENTRY, "fetch UPDATE lock of "DFID
+			       ": rc = %d\n", PFID(ll_inode2fid(parent)), rc);
 		}
 	}
 
@@ -63,6 +63,21 @@
 
 static void ll_ra_stats_inc_sbi(struct ll_sb_info *sbi, enum ra_stat which);
 
+/* maximum number of async read-ahead threads */
+#define LL_RA_ASYNC_THREADS	8
+
+/* threads reading ahead on behalf of readers, shared by all mounts */
+static struct cfs_wi_sched *ll_ra_sched;
+
+/* read-ahead of a stream handed to a worker thread */
+struct ll_ra_work {
+	struct cfs_workitem		 lrw_wi;
+	struct file			*lrw_file;
+	struct ll_readahead_state	*lrw_ras;
+	pgoff_t				 lrw_start;
+	pgoff_t				 lrw_end;
+};
+
 /**
  * Get readahead pages from the filesystem readahead pool of the client for a
  * thread.
@@ -155,16 +170,75 @@ static int index_in_window(unsigned long index, unsigned long point,
         return start <= index && index <= end;
 }
 
-void ll_ras_enter(struct file *f)
+static inline int stride_io_mode(struct ll_readahead_state *ras);
+static int index_in_stride_window(struct ll_readahead_state *ras,
+				  unsigned long index);
+
+/* Does an access to \a index continue the stream tracked by \a ras? */
+static bool ras_stream_match(struct ll_readahead_state *ras,
+			     unsigned long index)
+{
+	if (index_in_window(index, ras->ras_last_readpage, 8,
+			    max(8UL, ras->ras_window_len + ras->ras_rpc_size)))
+		return true;
+
+	return stride_io_mode(ras) && index_in_stride_window(ras, index);
+}
+
+/**
+ * Find the read-ahead stream of \a fd an access to \a index belongs to.
+ *
+ * If no stream matches, the most recently used stream is taken over unless
+ * it is actively reading ahead, in which case the least recently used one
+ * is recycled. This keeps the seek and stride detection of a single reader
+ * working as before, while concurrent sequential readers sharing the file
+ * descriptor each keep their own window.
+ *
+ * Stream fields are read without ras_lock: a stale value only leads to a
+ * suboptimal choice, and each stream is updated under its own lock.
+ */
+struct ll_readahead_state *ll_ras_find(struct ll_file_data *fd, pgoff_t index)
+{
+	struct ll_readahead_state *ras;
+	struct ll_readahead_state *mru = NULL;
+	struct ll_readahead_state *lru = NULL;
+	int i;
+
+	for (i = 0; i < LL_RA_STREAMS; i++) {
+		ras = &fd->fd_ras[i];
+		if (ras_stream_match(ras, index))
+			goto found;
+
+		if (mru == NULL ||
+		    time_after(ras->ras_last_used, mru->ras_last_used))
+			mru = ras;
+		if (lru == NULL ||
+		    time_before(ras->ras_last_used, lru->ras_last_used))
+			lru = ras;
+	}
+
+	ras = mru->ras_window_len > 0 ? lru : mru;
+found:
+	ras->ras_last_used = jiffies;
+	return ras;
+}
+
+/**
+ * Account a new read request starting at \a index and return the stream it
+ * belongs to.
+ */
+struct ll_readahead_state *ll_ras_enter(struct file *f, pgoff_t index)
 {
 	struct ll_file_data *fd = LUSTRE_FPRIVATE(f);
-	struct ll_readahead_state *ras = &fd->fd_ras;
+	struct ll_readahead_state *ras = ll_ras_find(fd, index);
 
 	spin_lock(&ras->ras_lock);
 	ras->ras_requests++;
 	ras->ras_request_index = 0;
 	ras->ras_consecutive_requests++;
 	spin_unlock(&ras->ras_lock);
+
+	return ras;
 }
 
 /**
@@ -425,6 +499,291 @@ ll_read_ahead_pages(const struct lu_env *env, struct cl_io *io,
 	return ra_end;
 }
 
+/* Can the read-ahead window of \a ras be moved forward by a worker thread? */
+static bool ras_async_allowed(struct ll_sb_info *sbi,
+			      struct ll_readahead_state *ras)
+{
+	struct ll_ra_info *ra = &sbi->ll_ra_info;
+
+	return ll_ra_sched != NULL && ra->ra_async_max_active > 0 &&
+	       ra->ra_max_pages > 0 && ra->ra_max_pages_per_file > 0 &&
+	       !ras->ras_async_pending && !stride_io_mode(ras) &&
+	       ras->ras_window_len > 0 &&
+	       ras->ras_window_len >= min(ra->ra_async_pages_per_file_threshold,
+					  ra->ra_max_pages_per_file);
+}
+
+/* called with the ras_lock held */
+static void ras_async_set(struct ll_readahead_state *ras, pgoff_t start,
+			  pgoff_t end)
+{
+	ras->ras_async_pending = true;
+	ras->ras_async_late = false;
+	ras->ras_async_start = start;
+	ras->ras_async_end = end;
+	ras->ras_next_readahead = end + 1;
+}
+
+/**
+ * Read ahead the pages of the chunk \a io is currently locked for, and
+ * return the last page queued in \a ra_end.
+ */
+static int ll_readahead_work_pages(const struct lu_env *env, struct cl_io *io,
+				   struct ll_readahead_state *ras,
+				   pgoff_t *ra_end)
+{
+	struct cl_object *clob = io->ci_obj;
+	struct ll_sb_info *sbi = ll_i2sbi(vvp_object_inode(clob));
+	struct cl_attr *attr = vvp_env_thread_attr(env);
+	struct ra_io_arg *ria = &ll_env_info(env)->lti_ria;
+	struct cl_2queue *queue = &io->ci_queue;
+	struct cl_io_rw_common *rd = &io->u.ci_rd.rd;
+	unsigned long len;
+	pgoff_t end;
+	int rc;
+	ENTRY;
+
+	memset(ria, 0, sizeof(*ria));
+	ria->ria_start = cl_index(clob, rd->crw_pos);
+	ria->ria_end = cl_index(clob, rd->crw_pos + rd->crw_count - 1);
+
+	/* the file may have been truncated since the work was queued */
+	cl_object_attr_lock(clob);
+	rc = cl_object_attr_get(env, clob, attr);
+	cl_object_attr_unlock(clob);
+	if (rc != 0)
+		RETURN(rc);
+
+	if (attr->cat_kms == 0) {
+		ll_ra_stats_inc_sbi(sbi, RA_STAT_ZERO_LEN);
+		io->ci_continue = 0;
+		RETURN(0);
+	}
+
+	end = (attr->cat_kms - 1) >> PAGE_CACHE_SHIFT;
+	if (end <= ria->ria_end) {
+		ria->ria_end = end;
+		ria->ria_eof = true;
+		io->ci_continue = 0;
+	}
+	if (ria->ria_start > ria->ria_end)
+		RETURN(0);
+
+	len = ria->ria_end - ria->ria_start + 1;
+	ria->ria_reserved = ll_ra_count_get(sbi, ria, len, 0);
+	if (ria->ria_reserved < len)
+		ll_ra_stats_inc_sbi(sbi, RA_STAT_MAX_IN_FLIGHT);
+	if (ria->ria_reserved == 0) {
+		io->ci_continue = 0;
+		RETURN(0);
+	}
+
+	cl_2queue_init(queue);
+	end = ll_read_ahead_pages(env, io, &queue->c2_qin, ras, ria);
+	if (ria->ria_reserved != 0)
+		ll_ra_count_put(sbi, ria->ria_reserved);
+	if (end > 0)
+		*ra_end = end;
+
+	if (queue->c2_qin.pl_nr > 0)
+		rc = cl_io_submit_rw(env, io, CRT_READ, queue);
+
+	/* Unlock unsent pages in case of error. */
+	cl_page_list_disown(env, io, &queue->c2_qin);
+	cl_2queue_fini(env, queue);
+
+	RETURN(rc);
+}
+
+/**
+ * Worker side of async read-ahead.
+ *
+ * The worker has no access to the cl_io of the reader, which is finished
+ * long before, so it sets up its own CIT_READ io over the pages to read
+ * ahead, and goes through it stripe by stripe like cl_io_loop() does. Each
+ * chunk is covered by the extent lock the io enqueues, without waiting for
+ * conflicting locks of other clients to be cancelled: read-ahead is given
+ * up rather than revoking the lock of a writer. cl_io_start() only takes
+ * the lli_trunc_sem for this io, see vvp_io_read_start().
+ */
+static int ll_readahead_work(struct cfs_workitem *wi)
+{
+	struct ll_ra_work *work = wi->wi_data;
+	struct file *file = work->lrw_file;
+	struct inode *inode = file->f_path.dentry->d_inode;
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	struct ll_readahead_state *ras = work->lrw_ras;
+	struct cl_object *clob = ll_i2info(inode)->lli_clob;
+	struct lu_env *env;
+	struct cl_io *io;
+	pgoff_t ra_end = 0;
+	__u16 refcheck;
+	int rc;
+	ENTRY;
+
+	env = cl_env_get(&refcheck);
+	if (IS_ERR(env))
+		GOTO(out, rc = PTR_ERR(env));
+
+	io = vvp_env_thread_io(env);
+	ll_io_init(io, file, 0);
+	io->u.ci_rw.crw_nonblock = 1;
+	io->ci_async_readahead = 1;
+	rc = cl_io_rw_init(env, io, CIT_READ, cl_offset(clob, work->lrw_start),
+			   cl_offset(clob, work->lrw_end - work->lrw_start + 1));
+	if (rc == 0) {
+		struct vvp_io *vio = vvp_env_io(env);
+
+		vio->vui_fd = LUSTRE_FPRIVATE(file);
+		vio->vui_io_subtype = IO_NORMAL;
+		vio->vui_iter = NULL;
+		vio->vui_iocb = NULL;
+
+		do {
+			io->ci_continue = 0;
+			rc = cl_io_iter_init(env, io);
+			if (rc == 0) {
+				rc = cl_io_lock(env, io);
+				if (rc == 0) {
+					rc = cl_io_start(env, io);
+					/* layout changed, give up */
+					if (rc == 0 && !io->ci_need_restart)
+						rc = ll_readahead_work_pages(
+							env, io, ras, &ra_end);
+					cl_io_end(env, io);
+					cl_io_unlock(env, io);
+					cl_io_rw_advance(env, io,
+							 io->u.ci_rw.crw_count);
+				}
+			}
+			cl_io_iter_fini(env, io);
+		} while (rc == 0 && io->ci_continue);
+	}
+	cl_io_fini(env, io);
+	cl_env_put(env, &refcheck);
+
+	CDEBUG(D_READA, DFID": async read-ahead %lu-%lu done at %lu: rc = %d\n",
+	       PFID(ll_inode2fid(inode)), work->lrw_start, work->lrw_end,
+	       ra_end, rc);
+out:
+	spin_lock(&ras->ras_lock);
+	/* let the reader read ahead the pages which were not */
+	if (ra_end > 0 && ra_end != work->lrw_end) {
+		ll_ra_stats_inc_sbi(sbi, RA_STAT_FAILED_REACH_END);
+		if (ra_end <= ras->ras_next_readahead &&
+		    index_in_window(ra_end, ras->ras_window_start, 0,
+				    ras->ras_window_len)) {
+			ras->ras_next_readahead = ra_end + 1;
+			RAS_CDEBUG(ras);
+		}
+	}
+	ras->ras_async_pending = false;
+	spin_unlock(&ras->ras_lock);
+
+	atomic_dec(&sbi->ll_ra_info.ra_async_inflight);
+	fput(file);
+
+	cfs_wi_exit(ll_ra_sched, wi);
+	OBD_FREE_PTR(work);
+	RETURN(1);
+}
+
+/**
+ * Queue read-ahead of pages [\a start, \a end] of the stream \a ras to a
+ * worker thread, after ras_async_set() marked them pending.
+ *
+ * \retval 0 if the work is queued
+ * \retval negative if the caller has to read ahead by itself
+ */
+static int ll_readahead_async(struct file *file,
+			      struct ll_readahead_state *ras,
+			      pgoff_t start, pgoff_t end)
+{
+	struct ll_sb_info *sbi = ll_i2sbi(file->f_path.dentry->d_inode);
+	struct ll_ra_info *ra = &sbi->ll_ra_info;
+	struct ll_ra_work *work;
+	int rc;
+
+	if (atomic_inc_return(&ra->ra_async_inflight) >
+	    ra->ra_async_max_active)
+		GOTO(out, rc = -EBUSY);
+
+	OBD_ALLOC_PTR(work);
+	if (work == NULL)
+		GOTO(out, rc = -ENOMEM);
+
+	get_file(file);
+	work->lrw_file = file;
+	work->lrw_ras = ras;
+	work->lrw_start = start;
+	work->lrw_end = end;
+	ll_ra_stats_inc_sbi(sbi, RA_STAT_ASYNC);
+
+	cfs_wi_init(&work->lrw_wi, work, ll_readahead_work);
+	cfs_wi_schedule(ll_ra_sched, &work->lrw_wi);
+	return 0;
+out:
+	atomic_dec(&ra->ra_async_inflight);
+	spin_lock(&ras->ras_lock);
+	ras->ras_async_pending = false;
+	spin_unlock(&ras->ras_lock);
+	return rc;
+}
+
+/**
+ * Move the read-ahead window forward from the fast read path, which has no
+ * cl_io to read ahead with.
+ *
+ * \retval 0 if a worker thread reads the window ahead
+ */
+static int ll_readahead_kick(struct file *file, struct ll_readahead_state *ras)
+{
+	struct ll_sb_info *sbi = ll_i2sbi(file->f_path.dentry->d_inode);
+	pgoff_t start;
+	pgoff_t end;
+	int rc;
+
+	spin_lock(&ras->ras_lock);
+	start = ras->ras_next_readahead;
+	end = ras->ras_window_start + ras->ras_window_len - 1;
+	if (start > end || !ras_async_allowed(sbi, ras)) {
+		spin_unlock(&ras->ras_lock);
+		return -EAGAIN;
+	}
+	ras_async_set(ras, start, end);
+	spin_unlock(&ras->ras_lock);
+
+	rc = ll_readahead_async(file, ras, start, end);
+	if (rc != 0) {
+		/* leave the window to the normal read path */
+		spin_lock(&ras->ras_lock);
+		if (ras->ras_next_readahead == end + 1)
+			ras->ras_next_readahead = start;
+		spin_unlock(&ras->ras_lock);
+	}
+
+	return rc;
+}
+
+int ll_readahead_sched_init(void)
+{
+	int nthrs;
+
+	nthrs = cfs_cpt_weight(cfs_cpt_table, CFS_CPT_ANY) / 2;
+	nthrs = min(max(nthrs, 1), LL_RA_ASYNC_THREADS);
+
+	return cfs_wi_sched_create("ll_ra", cfs_cpt_table, CFS_CPT_ANY, nthrs,
+				   &ll_ra_sched);
+}
+
+void ll_readahead_sched_fini(void)
+{
+	if (ll_ra_sched != NULL) {
+		cfs_wi_sched_destroy(ll_ra_sched);
+		ll_ra_sched = NULL;
+	}
+}
+
 static int ll_readahead(const struct lu_env *env, struct cl_io *io,
 			struct cl_page_list *queue,
 			struct ll_readahead_state *ras, bool hit)
@@ -437,6 +796,7 @@ static int ll_readahead(const struct lu_env *env, struct cl_io *io,
 	struct inode *inode;
 	struct ra_io_arg *ria = &lti->lti_ria;
 	struct cl_object *clob;
+	bool async = false;
 	int ret = 0;
 	__u64 kms;
 	ENTRY;
@@ -501,12 +861,25 @@ static int ll_readahead(const struct lu_env *env, struct cl_io *io,
                 ria->ria_length = ras->ras_stride_length;
                 ria->ria_pages = ras->ras_stride_pages;
         }
+	/* if the current read is served from the cache, the reader doesn't
+	 * need any of these pages right now, leave them to a worker thread */
+	if (hit && vio->vui_ra_valid && end != 0 && start <= end &&
+	    vio->vui_ra_start + vio->vui_ra_count <= start &&
+	    ras_async_allowed(ll_i2sbi(inode), ras)) {
+		ras_async_set(ras, start, end);
+		async = true;
+	}
 	spin_unlock(&ras->ras_lock);
 
 	if (end == 0) {
 		ll_ra_stats_inc(inode, RA_STAT_ZERO_WINDOW);
 		RETURN(0);
 	}
+
+	if (async &&
+	    ll_readahead_async(vio->vui_fd->fd_file, ras, start, end) == 0)
+		RETURN(0);
+
 	len = ria_page_count(ria);
 	if (len == 0) {
 		ll_ra_stats_inc(inode, RA_STAT_ZERO_WINDOW);
@@ -608,6 +981,7 @@ void ll_readahead_init(struct inode *inode, struct ll_readahead_state *ras)
 	ras->ras_rpc_size = PTLRPC_MAX_BRW_PAGES;
 	ras_reset(inode, ras, 0);
 	ras->ras_requests = 0;
+	ras->ras_async_pending = false;
 }
 
 /*
@@ -732,7 +1106,7 @@ static void ras_update(struct ll_sb_info *sbi, struct inode *inode,
 {
 	struct ll_ra_info *ra = &sbi->ll_ra_info;
 	bool hit = flags & LL_RAS_HIT;
-	int zero = 0, stride_detect = 0, ra_miss = 0;
+	int zero = 0, stride_detect = 0, ra_miss = 0, late = 0;
 	ENTRY;
 
 	spin_lock(&ras->ras_lock);
@@ -747,6 +1121,11 @@ static void ras_update(struct ll_sb_info *sbi, struct inode *inode,
         if (!index_in_window(index, ras->ras_last_readpage, 8, 8)) {
                 zero = 1;
                 ll_ra_stats_inc_sbi(sbi, RA_STAT_DISTANT_READPAGE);
+	} else if (ras->ras_async_pending && index >= ras->ras_async_start &&
+		   index <= ras->ras_async_end) {
+		/* The reader reached pages the worker is still busy with,
+		 * a miss here is not a sign of pages being reclaimed. */
+		late = 1;
         } else if (!hit && ras->ras_window_len &&
                    index < ras->ras_next_readahead &&
                    index_in_window(index, ras->ras_window_start, 0,
@@ -844,11 +1223,27 @@ static void ras_update(struct ll_sb_info *sbi, struct inode *inode,
 	} else {
 		if (ras->ras_next_readahead < ras->ras_window_start)
 			ras->ras_next_readahead = ras->ras_window_start;
-		if (!hit)
+		/* the worker reads the rest of its range */
+		if (late)
+			ras->ras_next_readahead = max(ras->ras_next_readahead,
+						      ras->ras_async_end + 1);
+		else if (!hit)
 			ras->ras_next_readahead = index + 1;
 	}
 	RAS_CDEBUG(ras);
 
+	/* Read-ahead is issued too late to hide its latency from the reader:
+	 * double the window once per async read-ahead that was caught up
+	 * with, instead of growing it by a single RPC per request. */
+	if (late && !ras->ras_async_late) {
+		unsigned long wlen;
+
+		ras->ras_async_late = true;
+		ll_ra_stats_inc_sbi(sbi, RA_STAT_ASYNC_LATE);
+		wlen = min(ras->ras_window_len * 2, ra->ra_max_pages_per_file);
+		ras->ras_window_len = ras_align(ras, wlen, NULL);
+	}
+
 	/* Trigger RA in the mmap case where ras_consecutive_requests
 	 * is not incremented and thus can't be used to trigger RA */
 	if (ras->ras_consecutive_pages >= 4 && flags & LL_RAS_MMAP) {
@@ -1079,8 +1474,8 @@ static int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
 {
 	struct inode              *inode  = vvp_object_inode(page->cp_obj);
 	struct ll_sb_info         *sbi    = ll_i2sbi(inode);
-	struct ll_file_data       *fd     = vvp_env_io(env)->vui_fd;
-	struct ll_readahead_state *ras    = &fd->fd_ras;
+	struct vvp_io             *vio    = vvp_env_io(env);
+	struct ll_readahead_state *ras;
 	struct cl_2queue          *queue  = &io->ci_queue;
 	struct vvp_page           *vpg;
 	int			   rc = 0;
@@ -1090,9 +1485,14 @@ static int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
 	vpg = cl2vvp_page(cl_object_page_slice(page->cp_obj, page));
 	uptodate = vpg->vpg_defer_uptodate;
 
+	/* mmap reads have no stream chosen by ll_ras_enter() */
+	if (vio->vui_ra_valid && vio->vui_ras != NULL)
+		ras = vio->vui_ras;
+	else
+		ras = ll_ras_find(vio->vui_fd, vvp_index(vpg));
+
 	if (sbi->ll_ra_info.ra_max_pages_per_file > 0 &&
-	    sbi->ll_ra_info.ra_max_pages > 0) {
-		struct vvp_io *vio = vvp_env_io(env);
+	    sbi->ll_ra_info.ra_max_pages > 0 && !vpg->vpg_ra_updated) {
 		enum ras_update_flags flags = 0;
 
 		if (uptodate)
@@ -1101,6 +1501,7 @@ static int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
 			flags |= LL_RAS_MMAP;
 		ras_update(sbi, inode, ras, vvp_index(vpg), flags);
 	}
+	vpg->vpg_ra_updated = 0;
 
 	cl_2queue_init(queue);
 	if (uptodate) {
@@ -1133,6 +1534,60 @@ static int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
 	RETURN(rc);
 }
 
+/**
+ * ->readpage() called from the fast read path without any cl_io.
+ *
+ * Only a page already read ahead into the cache can be handled here: it is
+ * covered by a DLM lock since lock cancellation discards cached pages.
+ * Anything else, or a hit that should trigger more readahead which can't be
+ * handed to a worker thread, needs a cl_io and is left to the normal read
+ * path by returning -ENODATA.
+ */
+static int ll_fast_readpage(const struct lu_env *env, struct file *file,
+			    struct page *vmpage)
+{
+	struct inode *inode = file->f_path.dentry->d_inode;
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	struct ll_readahead_state *ras;
+	struct cl_object *clob = ll_i2info(inode)->lli_clob;
+	struct vvp_page *vpg;
+	struct cl_page *page;
+	int result = -ENODATA;
+	ENTRY;
+
+	page = cl_vmpage_page(vmpage, clob);
+	if (page == NULL) {
+		unlock_page(vmpage);
+		RETURN(result);
+	}
+
+	vpg = cl2vvp_page(cl_object_page_slice(page->cp_obj, page));
+	if (vpg->vpg_defer_uptodate) {
+		ras = ll_ras_find(LUSTRE_FPRIVATE(file), vvp_index(vpg));
+		/* only a hit is accounted here, a miss is handled by the
+		 * normal read path later */
+		ras_update(sbi, inode, ras, vvp_index(vpg), LL_RAS_HIT);
+		/* avoid duplicate ras_update() in ll_io_read_page() */
+		vpg->vpg_ra_updated = 1;
+
+		/* If the readahead window has to move forward, an RPC has to
+		 * be issued, which needs a cl_io. Only complete the page here
+		 * while the window does not reach past the next RPC yet, or
+		 * if a worker thread moves the window. */
+		if (ras->ras_window_start + ras->ras_window_len <
+		    ras->ras_next_readahead + ras->ras_rpc_size ||
+		    ll_readahead_kick(file, ras) == 0) {
+			vpg->vpg_ra_used = 1;
+			cl_page_export(env, page, 1);
+			result = 0;
+		}
+	}
+
+	unlock_page(vmpage);
+	cl_page_put(env, page);
+	RETURN(result);
+}
+
 int ll_readpage(struct file *file, struct page *vmpage)
 {
 	struct inode *inode = file->f_path.dentry->d_inode;
@@ -1152,7 +1607,8 @@ int ll_readpage(struct file *file, struct page *vmpage)
 
 	env = lcc->lcc_env;
 	io  = lcc->lcc_io;
-	LASSERT(io != NULL);
+	if (io == NULL) /* fast read, see ll_do_fast_read() */
+		RETURN(ll_fast_readpage(env, file, vmpage));
 	LASSERT(io->ci_state == CIS_IO_GOING);
 	page = cl_page_find(env, clob, vmpage->index, vmpage, CPT_CACHEABLE);
 	if (!IS_ERR(page)) {
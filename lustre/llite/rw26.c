@@ -186,15 +186,25 @@ static int ll_releasepage(struct page *vmpage, RELEASEPAGE_ARG_TYPE gfp_mask)
 
 #define MAX_DIRECTIO_SIZE 2*1024*1024*1024UL
 
-ssize_t ll_direct_rw_pages(const struct lu_env *env, struct cl_io *io,
-                           int rw, struct inode *inode,
-                           struct ll_dio_pages *pv)
+/**
+ * Queue the pages of \a pv for direct transfer without waiting for it.
+ *
+ * The pages are added to \a queue and accounted in \a anchor, which the
+ * caller initialized with one reference of its own. The transfer is
+ * finished by ll_dio_pages_wait().
+ *
+ * \retval 0		pages submitted
+ * \retval negative	error, nothing has been sent
+ */
+static int ll_dio_pages_submit(const struct lu_env *env, struct cl_io *io,
+			       int rw, struct ll_dio_pages *pv,
+			       struct cl_2queue *queue,
+			       struct cl_sync_io *anchor)
 {
 	struct cl_page    *clp;
-	struct cl_2queue  *queue;
 	struct cl_object  *obj = io->ci_obj;
 	int i;
-	ssize_t rc = 0;
+	int rc = 0;
 	loff_t file_offset  = pv->ldp_start_offset;
 	size_t size         = pv->ldp_size;
 	int page_count      = pv->ldp_nr;
@@ -204,8 +214,6 @@ ssize_t ll_direct_rw_pages(const struct lu_env *env, struct cl_io *io,
 	int  io_pages       = 0;
 	ENTRY;
 
-        queue = &io->ci_queue;
-        cl_2queue_init(queue);
         for (i = 0; i < page_count; i++) {
                 if (pv->ldp_offsets)
                     file_offset = pv->ldp_offsets[i];
@@ -277,35 +285,77 @@ ssize_t ll_direct_rw_pages(const struct lu_env *env, struct cl_io *io,
                 file_offset += page_size;
         }
 
-        if (rc == 0 && io_pages) {
-                rc = cl_io_submit_sync(env, io,
-                                       rw == READ ? CRT_READ : CRT_WRITE,
-				       queue, 0);
-        }
-        if (rc == 0)
-                rc = pv->ldp_size;
+	if (rc == 0 && io_pages) {
+		cl_page_list_for_each(clp, &queue->c2_qin) {
+			LASSERT(clp->cp_sync_io == NULL);
+			clp->cp_sync_io = anchor;
+		}
+		atomic_add(queue->c2_qin.pl_nr, &anchor->csi_sync_nr);
+
+		rc = cl_io_submit_rw(env, io, rw == READ ? CRT_READ : CRT_WRITE,
+				     queue);
+		if (rc == 0) {
+			/* pages that weren't sent are completed right away,
+			 * see cl_io_submit_sync() */
+			cl_page_list_for_each(clp, &queue->c2_qin) {
+				clp->cp_sync_io = NULL;
+				cl_sync_io_note(env, anchor, 1);
+			}
+		} else {
+			LASSERT(list_empty(&queue->c2_qout.pl_pages));
+			cl_page_list_for_each(clp, &queue->c2_qin)
+				clp->cp_sync_io = NULL;
+			atomic_sub(queue->c2_qin.pl_nr, &anchor->csi_sync_nr);
+		}
+	}
+	RETURN(rc);
+}
+
+/**
+ * Wait for the transfer started by ll_dio_pages_submit() and release
+ * the pages of \a queue.
+ *
+ * \param[in] rc	result of ll_dio_pages_submit()
+ * \param[in] size	number of bytes submitted
+ *
+ * \retval \a size on success, negative error otherwise
+ */
+static ssize_t ll_dio_pages_wait(const struct lu_env *env, struct cl_io *io,
+				 struct cl_2queue *queue,
+				 struct cl_sync_io *anchor, int rc, size_t size)
+{
+	int rc2;
 
-        cl_2queue_discard(env, io, queue);
-        cl_2queue_disown(env, io, queue);
-        cl_2queue_fini(env, queue);
-        RETURN(rc);
+	/* drop the submitter's reference */
+	cl_sync_io_note(env, anchor, 0);
+	rc2 = cl_sync_io_wait(env, anchor, 0);
+	if (rc == 0)
+		rc = rc2;
+	cl_page_list_assume(env, io, &queue->c2_qout);
+
+	cl_2queue_discard(env, io, queue);
+	cl_2queue_disown(env, io, queue);
+	cl_2queue_fini(env, queue);
+
+	return rc == 0 ? size : rc;
 }
-EXPORT_SYMBOL(ll_direct_rw_pages);
 
-static ssize_t
-ll_direct_IO_seg(const struct lu_env *env, struct cl_io *io, int rw,
-		 struct inode *inode, size_t size, loff_t file_offset,
-		 struct page **pages, int page_count)
+ssize_t ll_direct_rw_pages(const struct lu_env *env, struct cl_io *io,
+                           int rw, struct inode *inode,
+                           struct ll_dio_pages *pv)
 {
-	struct ll_dio_pages pvec = { .ldp_pages		= pages,
-				     .ldp_nr		= page_count,
-				     .ldp_size		= size,
-				     .ldp_offsets	= NULL,
-				     .ldp_start_offset	= file_offset
-				   };
+	struct cl_2queue  *queue = &io->ci_queue;
+	struct cl_sync_io  anchor;
+	int rc;
+	ENTRY;
 
-	return ll_direct_rw_pages(env, io, rw, inode, &pvec);
+	cl_2queue_init(queue);
+	cl_sync_io_init(&anchor, 1, &cl_sync_io_end);
+	rc = ll_dio_pages_submit(env, io, rw, pv, queue, &anchor);
+
+	RETURN(ll_dio_pages_wait(env, io, queue, &anchor, rc, pv->ldp_size));
 }
+EXPORT_SYMBOL(ll_direct_rw_pages);
 
 /*  ll_free_user_pages - tear down page struct array
  *  @pages: array of page struct pointers underlying target buffer */
@@ -328,6 +378,122 @@ static void ll_free_user_pages(struct page **pages, int npages, int do_dirty)
 #endif
 }
 
+/**
+ * One MAX_DIO_SIZE piece of a direct IO request.
+ *
+ * All chunks of a request are submitted before waiting on any of them, so
+ * that a large O_DIRECT read or write keeps RPCs to all stripes in flight
+ * instead of finishing one chunk before building the next.
+ */
+struct ll_dio_chunk {
+	struct list_head	 ldc_list;
+	struct cl_2queue	 ldc_queue;
+	struct cl_sync_io	 ldc_anchor;
+	/* user pages pinned for this chunk */
+	struct page		**ldc_pages;
+	int			 ldc_npages;
+	size_t			 ldc_bytes;
+	int			 ldc_rw;
+};
+
+/* Max number of chunks of one request in flight at the same time. */
+#define LL_DIO_CHUNKS_MAX	8
+
+/**
+ * Wait for \a chunk, unpin its user pages and free it.
+ *
+ * \param[in] rc	result of submitting the chunk
+ *
+ * \retval number of bytes transferred, or negative error
+ */
+static ssize_t ll_dio_chunk_wait(const struct lu_env *env, struct cl_io *io,
+				 struct ll_dio_chunk *chunk, int rc)
+{
+	ssize_t result;
+
+	list_del(&chunk->ldc_list);
+	result = ll_dio_pages_wait(env, io, &chunk->ldc_queue,
+				   &chunk->ldc_anchor, rc, chunk->ldc_bytes);
+	ll_free_user_pages(chunk->ldc_pages, chunk->ldc_npages,
+			   chunk->ldc_rw == READ);
+	OBD_FREE_PTR(chunk);
+
+	return result;
+}
+
+/**
+ * Submit \a bytes at \a file_offset described by user \a pages and add
+ * the chunk to \a chunks. The user pages are released by
+ * ll_dio_chunk_wait(), or here on error.
+ *
+ * \retval \a bytes if the chunk is in flight, negative error otherwise
+ */
+static ssize_t ll_dio_chunk_submit(const struct lu_env *env, struct cl_io *io,
+				   int rw, struct list_head *chunks,
+				   size_t bytes, loff_t file_offset,
+				   struct page **pages, int page_count,
+				   int npages)
+{
+	struct ll_dio_pages pvec = { .ldp_pages		= pages,
+				     .ldp_nr		= page_count,
+				     .ldp_size		= bytes,
+				     .ldp_offsets	= NULL,
+				     .ldp_start_offset	= file_offset
+				   };
+	struct ll_dio_chunk *chunk;
+	int rc;
+
+	OBD_ALLOC_PTR(chunk);
+	if (chunk == NULL) {
+		ll_free_user_pages(pages, npages, 0);
+		return -ENOMEM;
+	}
+
+	chunk->ldc_pages = pages;
+	chunk->ldc_npages = npages;
+	chunk->ldc_bytes = bytes;
+	chunk->ldc_rw = rw;
+	list_add_tail(&chunk->ldc_list, chunks);
+	cl_2queue_init(&chunk->ldc_queue);
+	cl_sync_io_init(&chunk->ldc_anchor, 1, &cl_sync_io_end);
+
+	rc = ll_dio_pages_submit(env, io, rw, &pvec, &chunk->ldc_queue,
+				 &chunk->ldc_anchor);
+	if (rc < 0)
+		return ll_dio_chunk_wait(env, io, chunk, rc);
+
+	return bytes;
+}
+
+/**
+ * Wait for the oldest chunks of \a chunks until at most \a keep of them
+ * remain in flight. Only the bytes of the chunks before the first failed
+ * one are accounted in \a tot_bytes, the error is stored in \a result.
+ */
+static void ll_dio_chunks_wait(const struct lu_env *env, struct cl_io *io,
+			       struct list_head *chunks, int keep,
+			       ssize_t *tot_bytes, ssize_t *result)
+{
+	struct ll_dio_chunk *chunk;
+	int nr = 0;
+	ssize_t rc;
+
+	list_for_each_entry(chunk, chunks, ldc_list)
+		nr++;
+
+	while (nr-- > keep) {
+		chunk = list_entry(chunks->next, struct ll_dio_chunk,
+				   ldc_list);
+		rc = ll_dio_chunk_wait(env, io, chunk, 0);
+		if (*result < 0)
+			continue;
+		if (rc < 0)
+			*result = rc;
+		else
+			*tot_bytes += rc;
+	}
+}
+
 #ifdef KMALLOC_MAX_SIZE
 #define MAX_MALLOC KMALLOC_MAX_SIZE
 #else
@@ -360,8 +526,9 @@ ll_direct_IO(
 	struct file *file = iocb->ki_filp;
 	struct inode *inode = file->f_mapping->host;
 	ssize_t count = iov_iter_count(iter);
-	ssize_t tot_bytes = 0, result = 0;
+	ssize_t tot_bytes = 0, result = 0, dio_rc = 0;
 	size_t size = MAX_DIO_SIZE;
+	struct list_head chunks = LIST_HEAD_INIT(chunks);
 	__u16 refcheck;
 
 	/* FIXME: io smaller than PAGE_SIZE is broken on ia64 ??? */
@@ -407,12 +574,9 @@ ll_direct_IO(
 		if (likely(result > 0)) {
 			int n = DIV_ROUND_UP(result + offs, PAGE_SIZE);
 
-			result = ll_direct_IO_seg(env, io, iov_iter_rw(iter),
-						  inode, result, file_offset,
-						  pages, n);
-			ll_free_user_pages(pages, n,
-					   iov_iter_rw(iter) == READ);
-
+			result = ll_dio_chunk_submit(env, io, iov_iter_rw(iter),
+						     &chunks, result,
+						     file_offset, pages, n, n);
 		}
 		if (unlikely(result <= 0)) {
 			/* If we can't allocate a large enough buffer
@@ -434,10 +598,18 @@ ll_direct_IO(
 		}
 
 		iov_iter_advance(iter, result);
-		tot_bytes += result;
 		file_offset += result;
+
+		ll_dio_chunks_wait(env, io, &chunks, LL_DIO_CHUNKS_MAX - 1,
+				   &tot_bytes, &dio_rc);
+		if (dio_rc < 0)
+			break;
 	}
 out:
+	ll_dio_chunks_wait(env, io, &chunks, 0, &tot_bytes, &dio_rc);
+	if (dio_rc < 0)
+		result = dio_rc;
+
 	if (iov_iter_rw(iter) == READ)
 		mutex_unlock(&inode->i_mutex);
 
@@ -492,9 +664,10 @@ ll_direct_IO(int rw, struct kiocb *iocb, const struct iovec *iov,
 	struct file *file = iocb->ki_filp;
 	struct inode *inode = file->f_mapping->host;
 	ssize_t count = iov_length(iov, nr_segs);
-	ssize_t tot_bytes = 0, result = 0;
+	ssize_t tot_bytes = 0, result = 0, dio_rc = 0;
 	unsigned long seg = 0;
 	size_t size = MAX_DIO_SIZE;
+	struct list_head chunks = LIST_HEAD_INIT(chunks);
 	__u16 refcheck;
 	ENTRY;
 
@@ -542,10 +715,11 @@ ll_direct_IO(int rw, struct kiocb *iocb, const struct iovec *iov,
                         if (likely(page_count > 0)) {
                                 if (unlikely(page_count <  max_pages))
 					bytes = page_count << PAGE_CACHE_SHIFT;
-				result = ll_direct_IO_seg(env, io, rw, inode,
-							  bytes, file_offset,
-							  pages, page_count);
-                                ll_free_user_pages(pages, max_pages, rw==READ);
+				result = ll_dio_chunk_submit(env, io, rw,
+							     &chunks, bytes,
+							     file_offset, pages,
+							     page_count,
+							     max_pages);
                         } else if (page_count == 0) {
                                 GOTO(out, result = -EFAULT);
                         } else {
@@ -571,13 +745,22 @@ ll_direct_IO(int rw, struct kiocb *iocb, const struct iovec *iov,
                                 GOTO(out, result);
                         }
 
-                        tot_bytes += result;
                         file_offset += result;
                         iov_left -= result;
                         user_addr += result;
+
+			ll_dio_chunks_wait(env, io, &chunks,
+					   LL_DIO_CHUNKS_MAX - 1, &tot_bytes,
+					   &dio_rc);
+			if (dio_rc < 0)
+				GOTO(out, result = dio_rc);
                 }
         }
 out:
+	ll_dio_chunks_wait(env, io, &chunks, 0, &tot_bytes, &dio_rc);
+	if (dio_rc < 0)
+		result = dio_rc;
+
         if (tot_bytes > 0) {
 		struct vvp_io *vio = vvp_env_io(env);
 
@@ -36,7 +36,9 @@
 
 #include <linux/fs.h>
 #include <linux/sched.h>
+#include <linux/ctype.h>
 #include <linux/kthread.h>
+#include <linux/hash.h>
 #include <linux/mm.h>
 #include <linux/highmem.h>
 #include <linux/pagemap.h>
@@ -86,6 +88,16 @@ struct sa_entry {
 	struct lu_fid		se_fid;
 };
 
+/* a batch of names from LL_IOC_STATAHEAD, queued on sai_names until the
+ * statahead thread takes it, then owned by the thread */
+struct sa_names {
+	struct list_head	sn_list;
+	/* NUL-terminated names back to back */
+	char		       *sn_names;
+	__u32			sn_size;
+	__u32			sn_count;
+};
+
 static unsigned int sai_generation = 0;
 static DEFINE_SPINLOCK(sai_generation_lock);
 
@@ -101,10 +113,10 @@ static inline int sa_ready(struct sa_entry *entry)
 	return (entry->se_state != SA_ENTRY_INIT);
 }
 
-/* hash value to put in sai_cache */
+/* hash value to put in sai_cache, name hashes are weak in the low bits */
 static inline int sa_hash(int val)
 {
-	return val & LL_SA_CACHE_MASK;
+	return hash_32(val, LL_SA_CACHE_BIT);
 }
 
 /* hash entry into sai_cache */
@@ -159,6 +171,18 @@ static inline int agl_list_empty(struct ll_statahead_info *sai)
 	return list_empty(&sai->sai_agls);
 }
 
+/* got names from LL_IOC_STATAHEAD to stat ahead */
+static inline bool sa_has_names(struct ll_statahead_info *sai)
+{
+	return !list_empty(&sai->sai_names);
+}
+
+static void sa_names_free(struct sa_names *batch)
+{
+	OBD_FREE_LARGE(batch->sn_names, batch->sn_size);
+	OBD_FREE_PTR(batch);
+}
+
 /**
  * (1) hit ratio less than 80%
  * or
@@ -210,7 +234,8 @@ sa_alloc(struct ll_statahead_info *sai, __u64 index, const char *name, int len,
 	entry->se_qstr.hash = full_name_hash(name, len);
 	entry->se_qstr.len = len;
 	entry->se_qstr.name = dname;
-	entry->se_fid = *fid;
+	if (fid != NULL)
+		entry->se_fid = *fid;
 
 	lli = ll_i2info(sai->sai_dentry->d_inode);
 
@@ -283,17 +308,18 @@ sa_kill(struct ll_statahead_info *sai, struct sa_entry *entry)
 static void
 sa_put(struct ll_statahead_info *sai, struct sa_entry *entry)
 {
+	struct ll_sb_info *sbi = ll_i2sbi(sai->sai_dentry->d_inode);
 	struct sa_entry *tmp, *next;
 
 	if (entry != NULL && entry->se_state == SA_ENTRY_SUCC) {
-		struct ll_sb_info *sbi = ll_i2sbi(sai->sai_dentry->d_inode);
-
 		sai->sai_hit++;
 		sai->sai_consecutive_miss = 0;
 		sai->sai_max = min(2 * sai->sai_max, sbi->ll_sa_max);
+		atomic_inc(&sbi->ll_sa_hit);
 	} else {
 		sai->sai_miss++;
 		sai->sai_consecutive_miss++;
+		atomic_inc(&sbi->ll_sa_miss);
 	}
 
 	if (entry != NULL)
@@ -393,7 +419,7 @@ static void ll_agl_add(struct ll_statahead_info *sai,
 	}
 
 	if (added > 0)
-		wake_up(&sai->sai_agl_thread.t_ctl_waitq);
+		wake_up(&sai->sai_thread.t_ctl_waitq);
 }
 
 /* allocate sai */
@@ -404,7 +430,7 @@ static struct ll_statahead_info *ll_sai_alloc(struct dentry *dentry)
 	int i;
 	ENTRY;
 
-	OBD_ALLOC_PTR(sai);
+	OBD_ALLOC_LARGE(sai, sizeof(*sai));
 	if (!sai)
 		RETURN(NULL);
 
@@ -414,11 +440,11 @@ static struct ll_statahead_info *ll_sai_alloc(struct dentry *dentry)
 	sai->sai_index = 1;
 	init_waitqueue_head(&sai->sai_waitq);
 	init_waitqueue_head(&sai->sai_thread.t_ctl_waitq);
-	init_waitqueue_head(&sai->sai_agl_thread.t_ctl_waitq);
 
 	INIT_LIST_HEAD(&sai->sai_interim_entries);
 	INIT_LIST_HEAD(&sai->sai_entries);
 	INIT_LIST_HEAD(&sai->sai_agls);
+	INIT_LIST_HEAD(&sai->sai_names);
 
 	for (i = 0; i < LL_SA_CACHE_SIZE; i++) {
 		INIT_LIST_HEAD(&sai->sai_cache[i]);
@@ -438,9 +464,16 @@ static struct ll_statahead_info *ll_sai_alloc(struct dentry *dentry)
 /* free sai */
 static inline void ll_sai_free(struct ll_statahead_info *sai)
 {
+	struct sa_names *batch;
+	struct sa_names *next;
+
 	LASSERT(sai->sai_dentry != NULL);
 	dput(sai->sai_dentry);
-	OBD_FREE_PTR(sai);
+	list_for_each_entry_safe(batch, next, &sai->sai_names, sn_list) {
+		list_del(&batch->sn_list);
+		sa_names_free(batch);
+	}
+	OBD_FREE_LARGE(sai, sizeof(*sai));
 }
 
 /*
@@ -477,7 +510,6 @@ static void ll_sai_put(struct ll_statahead_info *sai)
 		spin_unlock(&lli->lli_sa_lock);
 
 		LASSERT(thread_is_stopped(&sai->sai_thread));
-		LASSERT(thread_is_stopped(&sai->sai_agl_thread));
 		LASSERT(sai->sai_sent == sai->sai_replied);
 		LASSERT(!sa_has_callback(sai));
 
@@ -592,6 +624,11 @@ static void sa_instantiate(struct ll_statahead_info *sai,
 		}
 	}
 
+	/* looked up by name only, and the object is on another MDT, leave it
+	 * to the caller's own lookup */
+	if (unlikely(body->mbo_valid & OBD_MD_MDS))
+		GOTO(out, rc = -EAGAIN);
+
 	it->it_lock_handle = entry->se_handle;
 	rc = md_revalidate_lock(ll_i2mdexp(dir), it, ll_inode2fid(dir), NULL);
         if (rc != 1)
@@ -689,6 +726,9 @@ static int ll_statahead_interpret(struct ptlrpc_request *req,
 
 	spin_lock(&lli->lli_sa_lock);
 	if (rc != 0) {
+		/* the pattern ran past the last existing name */
+		if (rc == -ENOENT && sai->sai_pattern_width != 0)
+			sai->sai_pattern_eof = 1;
 		if (__sa_make_ready(sai, entry, rc))
 			waitq = &sai->sai_waitq;
 	} else {
@@ -864,153 +904,97 @@ static void sa_statahead(struct dentry *parent, const char *name, int len,
 	EXIT;
 }
 
-/* async glimpse (agl) thread main function */
-static int ll_agl_thread(void *arg)
+/* glimpse the first inode in sai_agls, return false if there is none */
+static bool sa_handle_agl(struct ll_statahead_info *sai)
 {
-	struct dentry *parent = (struct dentry *)arg;
-	struct inode *dir = parent->d_inode;
-	struct ll_inode_info *plli = ll_i2info(dir);
+	struct ll_inode_info *lli = ll_i2info(sai->sai_dentry->d_inode);
 	struct ll_inode_info *clli;
-	struct ll_sb_info *sbi = ll_i2sbi(dir);
-	struct ll_statahead_info *sai;
-	struct ptlrpc_thread *thread;
-	struct l_wait_info lwi = { 0 };
-	ENTRY;
 
+	spin_lock(&lli->lli_agl_lock);
+	if (agl_list_empty(sai)) {
+		spin_unlock(&lli->lli_agl_lock);
+		return false;
+	}
 
-	sai = ll_sai_get(dir);
-	thread = &sai->sai_agl_thread;
-	thread->t_pid = current_pid();
-	CDEBUG(D_READA, "agl thread started: sai %p, parent %.*s\n",
-	       sai, parent->d_name.len, parent->d_name.name);
+	clli = agl_first_entry(sai);
+	list_del_init(&clli->lli_agl_list);
+	spin_unlock(&lli->lli_agl_lock);
 
-	atomic_inc(&sbi->ll_agl_total);
-	spin_lock(&plli->lli_agl_lock);
-	sai->sai_agl_valid = 1;
-	if (thread_is_init(thread))
-		/* If someone else has changed the thread state
-		 * (e.g. already changed to SVC_STOPPING), we can't just
-		 * blindly overwrite that setting. */
-		thread_set_flags(thread, SVC_RUNNING);
-	spin_unlock(&plli->lli_agl_lock);
-	wake_up(&thread->t_ctl_waitq);
-
-        while (1) {
-                l_wait_event(thread->t_ctl_waitq,
-                             !agl_list_empty(sai) ||
-                             !thread_is_running(thread),
-                             &lwi);
-
-                if (!thread_is_running(thread))
-                        break;
-
-		spin_lock(&plli->lli_agl_lock);
-		/* The statahead thread maybe help to process AGL entries,
-		 * so check whether list empty again. */
-		if (!agl_list_empty(sai)) {
-			clli = agl_first_entry(sai);
-			list_del_init(&clli->lli_agl_list);
-			spin_unlock(&plli->lli_agl_lock);
-			ll_agl_trigger(&clli->lli_vfs_inode, sai);
-		} else {
-			spin_unlock(&plli->lli_agl_lock);
-		}
-	}
+	ll_agl_trigger(&clli->lli_vfs_inode, sai);
 
-	spin_lock(&plli->lli_agl_lock);
+	return true;
+}
+
+/* drop inodes left in sai_agls, and don't accept more */
+static void sa_fini_agl(struct ll_statahead_info *sai)
+{
+	struct ll_inode_info *lli = ll_i2info(sai->sai_dentry->d_inode);
+	struct ll_inode_info *clli;
+
+	spin_lock(&lli->lli_agl_lock);
 	sai->sai_agl_valid = 0;
 	while (!agl_list_empty(sai)) {
 		clli = agl_first_entry(sai);
 		list_del_init(&clli->lli_agl_list);
-		spin_unlock(&plli->lli_agl_lock);
+		spin_unlock(&lli->lli_agl_lock);
 		clli->lli_agl_index = 0;
 		iput(&clli->lli_vfs_inode);
-		spin_lock(&plli->lli_agl_lock);
+		spin_lock(&lli->lli_agl_lock);
 	}
-	thread_set_flags(thread, SVC_STOPPED);
-	spin_unlock(&plli->lli_agl_lock);
-	wake_up(&thread->t_ctl_waitq);
-	ll_sai_put(sai);
-	CDEBUG(D_READA, "agl thread stopped: sai %p, parent %.*s\n",
-	       sai, parent->d_name.len, parent->d_name.name);
-	RETURN(0);
+	spin_unlock(&lli->lli_agl_lock);
 }
 
-/* start agl thread */
-static void ll_start_agl(struct dentry *parent, struct ll_statahead_info *sai)
+/*
+ * wait for spare statahead window, handle replies and AGLs meanwhile. Glimpses
+ * are async, one is sent for each statahead entry so that AGL keeps pace with
+ * statahead without flooding OSTs, more are sent while the window is full.
+ */
+static void sa_wait_window(struct ll_statahead_info *sai)
 {
-	struct ptlrpc_thread *thread = &sai->sai_agl_thread;
-	struct l_wait_info    lwi    = { 0 };
-	struct ll_inode_info  *plli;
-	struct task_struct	      *task;
-	ENTRY;
+	struct ptlrpc_thread *sa_thread = &sai->sai_thread;
+	struct l_wait_info lwi = { 0 };
 
-	CDEBUG(D_READA, "start agl thread: sai %p, parent %.*s\n",
-	       sai, parent->d_name.len, parent->d_name.name);
+	sa_handle_agl(sai);
+	do {
+		l_wait_event(sa_thread->t_ctl_waitq,
+			     !sa_sent_full(sai) ||
+			     sa_has_callback(sai) ||
+			     !agl_list_empty(sai) ||
+			     !thread_is_running(sa_thread),
+			     &lwi);
 
-	plli = ll_i2info(parent->d_inode);
-	task = kthread_run(ll_agl_thread, parent,
-			       "ll_agl_%u", plli->lli_opendir_pid);
-	if (IS_ERR(task)) {
-		CERROR("can't start ll_agl thread, rc: %ld\n", PTR_ERR(task));
-		thread_set_flags(thread, SVC_STOPPED);
-		RETURN_EXIT;
-	}
+		sa_handle_callback(sai);
 
-	l_wait_event(thread->t_ctl_waitq,
-		     thread_is_running(thread) || thread_is_stopped(thread),
-		     &lwi);
-	EXIT;
+		while (sa_sent_full(sai) && sa_handle_agl(sai))
+			;
+	} while (sa_sent_full(sai) && thread_is_running(sa_thread));
 }
 
-/* statahead thread main function */
-static int ll_statahead_thread(void *arg)
+/* stat ahead entries of @parent in readdir order */
+static int sa_statahead_readdir(struct dentry *parent,
+				struct ll_statahead_info *sai)
 {
-	struct dentry *parent = (struct dentry *)arg;
 	struct inode *dir = parent->d_inode;
 	struct ll_inode_info *lli = ll_i2info(dir);
-	struct ll_sb_info *sbi = ll_i2sbi(dir);
-	struct ll_statahead_info *sai;
-	struct ptlrpc_thread *sa_thread;
-	struct ptlrpc_thread *agl_thread;
+	struct ptlrpc_thread *sa_thread = &sai->sai_thread;
 	int first = 0;
 	struct md_op_data *op_data;
 	struct ll_dir_chain chain;
-	struct l_wait_info lwi = { 0 };
 	struct page *page = NULL;
 	__u64 pos = 0;
 	int rc = 0;
 	ENTRY;
 
-	sai = ll_sai_get(dir);
-	sa_thread = &sai->sai_thread;
-	agl_thread = &sai->sai_agl_thread;
-	sa_thread->t_pid = current_pid();
-	CDEBUG(D_READA, "statahead thread starting: sai %p, parent %.*s\n",
-	       sai, parent->d_name.len, parent->d_name.name);
-
 	op_data = ll_prep_md_op_data(NULL, dir, dir, NULL, 0, 0,
 				     LUSTRE_OPC_ANY, dir);
 	if (IS_ERR(op_data))
-		GOTO(out, rc = PTR_ERR(op_data));
+		RETURN(PTR_ERR(op_data));
 
 	op_data->op_max_pages = ll_i2sbi(dir)->ll_md_brw_pages;
 
-	if (sbi->ll_flags & LL_SBI_AGL_ENABLED)
-		ll_start_agl(parent, sai);
-
-	atomic_inc(&sbi->ll_sa_total);
-	spin_lock(&lli->lli_sa_lock);
-	if (thread_is_init(sa_thread))
-		/* If someone else has changed the thread state
-		 * (e.g. already changed to SVC_STOPPING), we can't just
-		 * blindly overwrite that setting. */
-		thread_set_flags(sa_thread, SVC_RUNNING);
-	spin_unlock(&lli->lli_sa_lock);
-	wake_up(&sa_thread->t_ctl_waitq);
-
 	ll_dir_chain_init(&chain);
-	while (pos != MDS_DIR_END_OFF && thread_is_running(sa_thread)) {
+	while (pos != MDS_DIR_END_OFF && thread_is_running(sa_thread) &&
+	       !sa_has_names(sai)) {
 		struct lu_dirpage *dp;
 		struct lu_dirent  *ent;
 
@@ -1029,7 +1013,7 @@ static int ll_statahead_thread(void *arg)
 		dp = page_address(page);
 		for (ent = lu_dirent_start(dp);
 		     ent != NULL && thread_is_running(sa_thread) &&
-		     !sa_low_hit(sai);
+		     !sa_low_hit(sai) && !sa_has_names(sai);
 		     ent = lu_dirent_next(ent)) {
 			__u64 hash;
 			int namelen;
@@ -1079,43 +1063,191 @@ static int ll_statahead_thread(void *arg)
 
 			fid_le_to_cpu(&fid, &ent->lde_fid);
 
-			/* wait for spare statahead window */
-			do {
-				l_wait_event(sa_thread->t_ctl_waitq,
-					     !sa_sent_full(sai) ||
-					     sa_has_callback(sai) ||
-					     !agl_list_empty(sai) ||
-					     !thread_is_running(sa_thread),
-					     &lwi);
+			sa_wait_window(sai);
+			sa_statahead(parent, name, namelen, &fid);
+		}
 
-				sa_handle_callback(sai);
+		pos = le64_to_cpu(dp->ldp_hash_end);
+		ll_release_page(dir, page,
+				le32_to_cpu(dp->ldp_flags) & LDF_COLLIDE);
 
-				spin_lock(&lli->lli_agl_lock);
-				while (sa_sent_full(sai) &&
-				       !agl_list_empty(sai)) {
-					struct ll_inode_info *clli;
+		if (sa_low_hit(sai))
+			break;
+	}
+	ll_dir_chain_fini(&chain);
+	ll_finish_md_op_data(op_data);
+
+	RETURN(rc);
+}
 
-					clli = agl_first_entry(sai);
-					list_del_init(&clli->lli_agl_list);
-					spin_unlock(&lli->lli_agl_lock);
+/* take the first name batch queued by ll_statahead_names() */
+static struct sa_names *sa_names_next(struct ll_statahead_info *sai)
+{
+	struct ll_inode_info *lli = ll_i2info(sai->sai_dentry->d_inode);
+	struct sa_names *batch = NULL;
 
-					ll_agl_trigger(&clli->lli_vfs_inode,
-							sai);
+	spin_lock(&lli->lli_sa_lock);
+	sai->sai_names_replaced = false;
+	if (sa_has_names(sai)) {
+		batch = list_entry(sai->sai_names.next, struct sa_names,
+				   sn_list);
+		list_del(&batch->sn_list);
+		sai->sai_names_queued -= batch->sn_count;
+	}
+	spin_unlock(&lli->lli_sa_lock);
 
-					spin_lock(&lli->lli_agl_lock);
-				}
-				spin_unlock(&lli->lli_agl_lock);
-			} while (sa_sent_full(sai) &&
-				 thread_is_running(sa_thread));
+	return batch;
+}
 
-			sa_statahead(parent, name, namelen, &fid);
+/*
+ * stat ahead names given by LL_IOC_STATAHEAD, batch by batch in the given
+ * order, until no batch is queued. A batch is dropped half way by
+ * LL_SA_NAMES_REPLACE, or if its hit ratio is too low.
+ */
+static int sa_statahead_names(struct dentry *parent,
+			      struct ll_statahead_info *sai)
+{
+	struct ll_sb_info *sbi = ll_i2sbi(parent->d_inode);
+	struct ptlrpc_thread *sa_thread = &sai->sai_thread;
+	struct sa_names *batch;
+	char *name;
+	char *end;
+	int namelen;
+
+	while (thread_is_running(sa_thread) &&
+	       (batch = sa_names_next(sai)) != NULL) {
+		atomic_inc(&sbi->ll_sa_list);
+		/* the lookups so far followed another list or readdir order,
+		 * judge the new list on its own */
+		sai->sai_hit = 0;
+		sai->sai_miss = 0;
+		sai->sai_consecutive_miss = 0;
+
+		/* names were checked by sa_names_check() */
+		for (name = batch->sn_names, end = name + batch->sn_size;
+		     name < end && thread_is_running(sa_thread) &&
+		     !sai->sai_names_replaced && !sa_low_hit(sai);
+		     name += namelen + 1) {
+			namelen = strlen(name);
+
+			sa_wait_window(sai);
+			sa_statahead(parent, name, namelen, NULL);
 		}
+		sa_names_free(batch);
+	}
 
-		pos = le64_to_cpu(dp->ldp_hash_end);
-		ll_release_page(dir, page,
-				le32_to_cpu(dp->ldp_flags) & LDF_COLLIDE);
+	return 0;
+}
 
-		if (sa_low_hit(sai)) {
+/*
+ * check whether @name ends with a number, like "file_0001", if so save its
+ * prefix and number width in @sai to stat ahead "file_0002" and so on.
+ */
+static bool sa_pattern_init(struct ll_statahead_info *sai,
+			    const struct qstr *name)
+{
+	unsigned int width = 0;
+	__u64 num = 0;
+	int i;
+
+	for (i = name->len - 1; i >= 0 && isdigit(name->name[i]); i--)
+		width++;
+
+	/* no number, or it doesn't fit in __u64 */
+	if (width == 0 || width > 18)
+		return false;
+
+	for (i = name->len - width; i < name->len; i++)
+		num = num * 10 + name->name[i] - '0';
+
+	if (sai != NULL) {
+		sai->sai_pattern_len = name->len - width;
+		memcpy(sai->sai_pattern, name->name, sai->sai_pattern_len);
+		sai->sai_pattern_width = width;
+		sai->sai_pattern_next = num + 1;
+	}
+
+	return true;
+}
+
+/* stat ahead names following the pattern saved by sa_pattern_init() */
+static int sa_statahead_pattern(struct dentry *parent,
+				struct ll_statahead_info *sai)
+{
+	struct ptlrpc_thread *sa_thread = &sai->sai_thread;
+	char name[NAME_MAX + 1];
+	int namelen;
+
+	while (thread_is_running(sa_thread) && !sai->sai_pattern_eof &&
+	       !sa_low_hit(sai) && !sa_has_names(sai)) {
+		namelen = snprintf(name, sizeof(name), "%.*s%0*llu",
+				   (int)sai->sai_pattern_len, sai->sai_pattern,
+				   (int)sai->sai_pattern_width,
+				   (unsigned long long)sai->sai_pattern_next);
+		if (namelen >= sizeof(name))
+			break;
+
+		sai->sai_pattern_next++;
+
+		sa_wait_window(sai);
+		if (sai->sai_pattern_eof)
+			break;
+
+		sa_statahead(parent, name, namelen, NULL);
+	}
+
+	return 0;
+}
+
+/* statahead thread main function */
+static int ll_statahead_thread(void *arg)
+{
+	struct dentry *parent = (struct dentry *)arg;
+	struct inode *dir = parent->d_inode;
+	struct ll_inode_info *lli = ll_i2info(dir);
+	struct ll_sb_info *sbi = ll_i2sbi(dir);
+	struct ll_statahead_info *sai;
+	struct ptlrpc_thread *sa_thread;
+	struct l_wait_info lwi = { 0 };
+	int rc = 0;
+	ENTRY;
+
+	sai = ll_sai_get(dir);
+	sa_thread = &sai->sai_thread;
+	sa_thread->t_pid = current_pid();
+	CDEBUG(D_READA, "statahead thread starting: sai %p, parent %.*s\n",
+	       sai, parent->d_name.len, parent->d_name.name);
+
+	if (sbi->ll_flags & LL_SBI_AGL_ENABLED) {
+		spin_lock(&lli->lli_agl_lock);
+		sai->sai_agl_valid = 1;
+		spin_unlock(&lli->lli_agl_lock);
+		atomic_inc(&sbi->ll_agl_total);
+	}
+
+	atomic_inc(&sbi->ll_sa_total);
+	spin_lock(&lli->lli_sa_lock);
+	if (thread_is_init(sa_thread))
+		/* If someone else has changed the thread state
+		 * (e.g. already changed to SVC_STOPPING), we can't just
+		 * blindly overwrite that setting. */
+		thread_set_flags(sa_thread, SVC_RUNNING);
+	spin_unlock(&lli->lli_sa_lock);
+	wake_up(&sa_thread->t_ctl_waitq);
+
+	/* readdir and pattern statahead give way to names queued meanwhile */
+	if (sa_has_names(sai)) {
+		rc = sa_statahead_names(parent, sai);
+	} else if (sai->sai_pattern_width != 0) {
+		atomic_inc(&sbi->ll_sa_pattern);
+		rc = sa_statahead_pattern(parent, sai);
+	} else {
+		rc = sa_statahead_readdir(parent, sai);
+	}
+
+	while (1) {
+		/* a queued batch is judged on its own hit ratio */
+		if (rc == 0 && sa_low_hit(sai) && !sa_has_names(sai)) {
 			rc = -EFAULT;
 			atomic_inc(&sbi->ll_sa_wrong);
 			CDEBUG(D_READA, "Statahead for dir "DFID" hit "
@@ -1125,47 +1257,40 @@ static int ll_statahead_thread(void *arg)
 			       PFID(&lli->lli_fid), sai->sai_hit,
 			       sai->sai_miss, sai->sai_sent,
 			       sai->sai_replied, current_pid());
-			break;
 		}
-	}
-	ll_dir_chain_fini(&chain);
-	ll_finish_md_op_data(op_data);
 
-	if (rc < 0) {
-		spin_lock(&lli->lli_sa_lock);
-		thread_set_flags(sa_thread, SVC_STOPPING);
-		lli->lli_sa_enabled = 0;
-		spin_unlock(&lli->lli_sa_lock);
-	}
+		if (rc < 0) {
+			spin_lock(&lli->lli_sa_lock);
+			thread_set_flags(sa_thread, SVC_STOPPING);
+			lli->lli_sa_enabled = 0;
+			spin_unlock(&lli->lli_sa_lock);
+		}
 
-	/* statahead is finished, but statahead entries need to be cached, wait
-	 * for file release to stop me. */
-	while (thread_is_running(sa_thread)) {
-		l_wait_event(sa_thread->t_ctl_waitq,
-			     sa_has_callback(sai) ||
-			     !thread_is_running(sa_thread),
-			     &lwi);
+		/* statahead is finished, but statahead entries need to be
+		 * cached, wait for file release to stop me, or for more names
+		 * to stat ahead. */
+		while (thread_is_running(sa_thread) && !sa_has_names(sai)) {
+			l_wait_event(sa_thread->t_ctl_waitq,
+				     sa_has_callback(sai) ||
+				     !agl_list_empty(sai) ||
+				     sa_has_names(sai) ||
+				     !thread_is_running(sa_thread),
+				     &lwi);
+
+			sa_handle_callback(sai);
+			while (thread_is_running(sa_thread) &&
+			       sa_handle_agl(sai))
+				;
+		}
 
-		sa_handle_callback(sai);
-	}
+		if (!thread_is_running(sa_thread))
+			break;
 
+		rc = sa_statahead_names(parent, sai);
+	}
 	EXIT;
-out:
-	if (sai->sai_agl_valid) {
-		spin_lock(&lli->lli_agl_lock);
-		thread_set_flags(agl_thread, SVC_STOPPING);
-		spin_unlock(&lli->lli_agl_lock);
-		wake_up(&agl_thread->t_ctl_waitq);
 
-		CDEBUG(D_READA, "stop agl thread: sai %p pid %u\n",
-		       sai, (unsigned int)agl_thread->t_pid);
-		l_wait_event(agl_thread->t_ctl_waitq,
-			     thread_is_stopped(agl_thread),
-			     &lwi);
-	} else {
-		/* Set agl_thread flags anyway. */
-		thread_set_flags(agl_thread, SVC_STOPPED);
-	}
+	sa_fini_agl(sai);
 
 	/* wait for inflight statahead RPCs to finish, and then we can free sai
 	 * safely because statahead RPC will access sai data */
@@ -1519,66 +1644,64 @@ out:
 	RETURN(rc);
 }
 
-/**
- * start statahead thread
- *
- * \param[in] dir	parent directory
- * \param[in] dentry	dentry that triggers statahead, normally the first
- *			dirent under @dir
- * \retval		-EAGAIN on success, because when this function is
- *			called, it's already in lookup call, so client should
- *			do it itself instead of waiting for statahead thread
- *			to do it asynchronously.
- * \retval		negative number upon error
+/*
+ * install @sai on @dir and start its statahead thread, only the process which
+ * opened @dir, through handle @key if it's given, can do this.
  */
-static int start_statahead_thread(struct inode *dir, struct dentry *dentry)
+static int sa_start_thread(struct inode *dir, struct ll_statahead_info *sai,
+			   void *key)
 {
 	struct ll_inode_info *lli = ll_i2info(dir);
-	struct ll_statahead_info *sai = NULL;
-	struct dentry *parent = dentry->d_parent;
-	struct ptlrpc_thread *thread;
+	struct ll_sb_info *sbi = ll_i2sbi(dir);
+	struct dentry *parent = sai->sai_dentry;
+	struct ptlrpc_thread *thread = &sai->sai_thread;
 	struct l_wait_info lwi = { 0 };
 	struct task_struct *task;
 	int rc;
 	ENTRY;
 
-	/* I am the "lli_opendir_pid" owner, only me can set "lli_sai". */
-	rc = is_first_dirent(dir, dentry);
-	if (rc == LS_NOT_FIRST_DE)
-		/* It is not "ls -{a}l" operation, no need statahead for it. */
-		GOTO(out, rc = -EFAULT);
-
-	sai = ll_sai_alloc(parent);
-	if (sai == NULL)
-		GOTO(out, rc = -ENOMEM);
-
-	sai->sai_ls_all = (rc == LS_FIRST_DOT_DE);
-
 	/* if current lli_opendir_key was deauthorized, or dir re-opened by
 	 * another process, don't start statahead, otherwise the newly spawned
 	 * statahead thread won't be notified to quit. */
 	spin_lock(&lli->lli_sa_lock);
-	if (unlikely(lli->lli_sai != NULL ||
-		     lli->lli_opendir_key == NULL ||
+	if (unlikely(lli->lli_sai != NULL)) {
+		spin_unlock(&lli->lli_sa_lock);
+		RETURN(-EBUSY);
+	}
+	if (unlikely(lli->lli_opendir_key == NULL ||
+		     (key != NULL && lli->lli_opendir_key != key) ||
 		     lli->lli_opendir_pid != current->pid)) {
 		spin_unlock(&lli->lli_sa_lock);
-		GOTO(out, rc = -EPERM);
+		RETURN(-EPERM);
+	}
+	/* bound concurrent statahead, e.g. parallel find in many dirs. This
+	 * must be the last check: the slot is only released by the statahead
+	 * thread or on its start failure below. */
+	if (atomic_inc_return(&sbi->ll_sa_running) > sbi->ll_sa_running_max) {
+		atomic_dec(&sbi->ll_sa_running);
+		spin_unlock(&lli->lli_sa_lock);
+		CDEBUG(D_READA, "%s: %u statahead threads running\n",
+		       ll_get_fsname(dir->i_sb, NULL, 0),
+		       sbi->ll_sa_running_max);
+		RETURN(-EMFILE);
 	}
 	lli->lli_sai = sai;
+	lli->lli_sa_enabled = 1;
 	spin_unlock(&lli->lli_sa_lock);
 
-	atomic_inc(&ll_i2sbi(parent->d_inode)->ll_sa_running);
-
 	CDEBUG(D_READA, "start statahead thread: [pid %d] [parent %.*s]\n",
 	       current_pid(), parent->d_name.len, parent->d_name.name);
 
 	task = kthread_run(ll_statahead_thread, parent, "ll_sa_%u",
 			   lli->lli_opendir_pid);
-	thread = &sai->sai_thread;
 	if (IS_ERR(task)) {
 		rc = PTR_ERR(task);
 		CERROR("can't start ll_sa thread, rc: %d\n", rc);
-		GOTO(out, rc);
+		spin_lock(&lli->lli_sa_lock);
+		lli->lli_sai = NULL;
+		spin_unlock(&lli->lli_sa_lock);
+		atomic_dec(&sbi->ll_sa_running);
+		RETURN(rc);
 	}
 
 	l_wait_event(thread->t_ctl_waitq,
@@ -1586,6 +1709,52 @@ static int start_statahead_thread(struct inode *dir, struct dentry *dentry)
 		     &lwi);
 	ll_sai_put(sai);
 
+	RETURN(0);
+}
+
+/**
+ * start statahead thread
+ *
+ * \param[in] dir	parent directory
+ * \param[in] dentry	dentry that triggers statahead, normally the first
+ *			dirent under @dir, or a name ending with a number
+ * \retval		-EAGAIN on success, because when this function is
+ *			called, it's already in lookup call, so client should
+ *			do it itself instead of waiting for statahead thread
+ *			to do it asynchronously.
+ * \retval		negative number upon error
+ */
+static int start_statahead_thread(struct inode *dir, struct dentry *dentry)
+{
+	struct ll_inode_info *lli = ll_i2info(dir);
+	struct ll_statahead_info *sai = NULL;
+	struct dentry *parent = dentry->d_parent;
+	int rc;
+	ENTRY;
+
+	/* I am the "lli_opendir_pid" owner, only me can set "lli_sai". */
+	rc = is_first_dirent(dir, dentry);
+	if (rc == LS_NOT_FIRST_DE &&
+	    !sa_pattern_init(NULL, &dentry->d_name))
+		/* It is not "ls -{a}l" operation, nor does it stat names like
+		 * "file_0001", "file_0002", no need statahead for it. */
+		GOTO(out, rc = -EFAULT);
+
+	sai = ll_sai_alloc(parent);
+	if (sai == NULL)
+		GOTO(out, rc = -ENOMEM);
+
+	if (rc == LS_NOT_FIRST_DE) {
+		sa_pattern_init(sai, &dentry->d_name);
+		sai->sai_ls_all = 1;
+	} else {
+		sai->sai_ls_all = (rc == LS_FIRST_DOT_DE);
+	}
+
+	rc = sa_start_thread(dir, sai, NULL);
+	if (rc < 0)
+		GOTO(out, rc);
+
 	/*
 	 * We don't stat-ahead for the first dirent since we are already in
 	 * lookup.
@@ -1597,7 +1766,6 @@ out:
 	 * subsequent stat won't waste time to try it. */
 	spin_lock(&lli->lli_sa_lock);
 	lli->lli_sa_enabled = 0;
-	lli->lli_sai = NULL;
 	spin_unlock(&lli->lli_sa_lock);
 
 	if (sai != NULL)
@@ -1637,3 +1805,169 @@ int ll_statahead(struct inode *dir, struct dentry **dentryp, bool unplug)
 	}
 	return start_statahead_thread(dir, *dentryp);
 }
+
+/* check @names from LL_IOC_STATAHEAD are @count valid entry names */
+static int sa_names_check(const char *names, __u32 size, __u32 count)
+{
+	const char *name = names;
+	const char *end = names + size;
+	__u32 i;
+	int namelen;
+
+	if (end[-1] != '\0')
+		return -EINVAL;
+
+	for (i = 0; name < end; i++, name += namelen + 1) {
+		namelen = strlen(name);
+		if (namelen == 0 || namelen > NAME_MAX ||
+		    memchr(name, '/', namelen) != NULL)
+			return -EINVAL;
+
+		if (name[0] == '.' &&
+		    (namelen == 1 || (namelen == 2 && name[1] == '.')))
+			return -EINVAL;
+	}
+
+	return i == count ? 0 : -EINVAL;
+}
+
+/*
+ * queue @batch on the statahead thread of @dir, which the current process
+ * started through handle @key, and wake the thread up.
+ *
+ * \retval		0 on success
+ * \retval		-ENOENT if no statahead is running on @dir
+ * \retval		-EPERM if another handle of @dir owns statahead
+ * \retval		-EAGAIN if the statahead thread is stopping
+ * \retval		-ENOSPC if LL_SA_NAMES_QUEUED names would be exceeded
+ */
+static int sa_names_add(struct inode *dir, struct sa_names *batch,
+			__u32 flags, void *key)
+{
+	struct ll_inode_info *lli = ll_i2info(dir);
+	struct ll_statahead_info *sai;
+	struct sa_names *tmp;
+	struct sa_names *next;
+	struct list_head dropped;
+	int rc = 0;
+
+	INIT_LIST_HEAD(&dropped);
+
+	spin_lock(&lli->lli_sa_lock);
+	sai = lli->lli_sai;
+	if (lli->lli_opendir_key != key ||
+	    lli->lli_opendir_pid != current->pid)
+		GOTO(out, rc = -EPERM);
+	if (sai == NULL)
+		GOTO(out, rc = -ENOENT);
+	if (!thread_is_running(&sai->sai_thread))
+		GOTO(out, rc = -EAGAIN);
+
+	if (flags & LL_SA_NAMES_REPLACE) {
+		list_splice_init(&sai->sai_names, &dropped);
+		sai->sai_names_queued = 0;
+		sai->sai_names_replaced = true;
+	} else if (sai->sai_names_queued + batch->sn_count >
+		   LL_SA_NAMES_QUEUED) {
+		GOTO(out, rc = -ENOSPC);
+	}
+
+	list_add_tail(&batch->sn_list, &sai->sai_names);
+	sai->sai_names_queued += batch->sn_count;
+	wake_up(&sai->sai_thread.t_ctl_waitq);
+out:
+	spin_unlock(&lli->lli_sa_lock);
+
+	list_for_each_entry_safe(tmp, next, &dropped, sn_list) {
+		list_del(&tmp->sn_list);
+		sa_names_free(tmp);
+	}
+
+	return rc;
+}
+
+/**
+ * stat ahead @names under directory @file, for access patterns which don't
+ * follow readdir order, e.g. data movers working from a file list. The names
+ * are stat'ed ahead in the given order, and served to the lookups of the
+ * process which opened @file like readdir driven statahead.
+ *
+ * If statahead already runs on @file, because of an earlier batch or a stat
+ * which started readdir or pattern statahead, @names is queued after the
+ * names not stat'ed yet, or replaces them with LL_SA_NAMES_REPLACE. Readdir
+ * and pattern statahead stop once names are queued. The statahead thread
+ * stays until @file is closed, or until the hit ratio of a batch is too low.
+ *
+ * \param[in] file	opened directory
+ * \param[in] names	@count NUL-terminated names back to back, at most
+ *			LL_SA_NAMES_BATCH; it's freed by statahead on success
+ * \param[in] size	size of @names
+ * \param[in] count	name count
+ * \param[in] flags	LL_SA_NAMES_* flags
+ *
+ * \retval		0 on success
+ * \retval		-EPERM if another handle of @dir owns statahead
+ * \retval		-EAGAIN if statahead of @dir is stopping for a low hit
+ *			ratio, a new one can be started shortly
+ * \retval		-ENOSPC if more than LL_SA_NAMES_QUEUED names would be
+ *			waiting to be stat'ed ahead
+ * \retval		-EMFILE if llite.*.statahead_running_max threads run
+ * \retval		negative number on other errors
+ */
+int ll_statahead_names(struct file *file, char *names, __u32 size,
+		       __u32 count, __u32 flags)
+{
+	struct dentry *parent = file->f_path.dentry;
+	struct inode *dir = parent->d_inode;
+	void *key = LUSTRE_FPRIVATE(file);
+	struct ll_statahead_info *sai;
+	struct sa_names *batch;
+	int rc;
+	ENTRY;
+
+	if (ll_i2sbi(dir)->ll_sa_max == 0)
+		RETURN(-EOPNOTSUPP);
+
+	if (flags & ~LL_SA_NAMES_REPLACE)
+		RETURN(-EINVAL);
+
+	rc = sa_names_check(names, size, count);
+	if (rc < 0)
+		RETURN(rc);
+
+	OBD_ALLOC_PTR(batch);
+	if (batch == NULL)
+		RETURN(-ENOMEM);
+
+	batch->sn_names = names;
+	batch->sn_size = size;
+	batch->sn_count = count;
+
+	/* @file may be a second handle of @dir, opened while another one owned
+	 * statahead; take the ownership over if that one has been closed. */
+	ll_authorize_statahead(dir, key);
+
+	rc = sa_names_add(dir, batch, flags, key);
+	if (rc != -ENOENT)
+		GOTO(out, rc);
+
+	sai = ll_sai_alloc(parent);
+	if (sai == NULL)
+		GOTO(out, rc = -ENOMEM);
+
+	sai->sai_ls_all = 1;
+	list_add_tail(&batch->sn_list, &sai->sai_names);
+	sai->sai_names_queued = count;
+
+	rc = sa_start_thread(dir, sai, key);
+	if (rc < 0) {
+		list_del(&batch->sn_list);
+		ll_sai_free(sai);
+	}
+out:
+	/* @names is freed by caller on error */
+	if (rc < 0)
+		OBD_FREE_PTR(batch);
+
+	RETURN(rc);
+}
@@ -138,6 +138,8 @@ struct vvp_io {
 	pgoff_t	vui_ra_count;
 	/* Set when vui_ra_{start,count} have been initialized. */
 	bool		vui_ra_valid;
+	/* Read-ahead stream of vui_fd used by this IO. */
+	struct ll_readahead_state *vui_ras;
 };
 
 extern struct lu_device_type vvp_device_type;
@@ -251,7 +253,9 @@ struct vvp_object {
 struct vvp_page {
 	struct cl_page_slice vpg_cl;
 	unsigned	vpg_defer_uptodate:1,
-			vpg_ra_used:1;
+			vpg_ra_used:1,
+			/* ras_update() already done by fast read */
+			vpg_ra_updated:1;
 	/** VM page */
 	struct page	*vpg_page;
 };
@@ -492,7 +492,8 @@ static void vvp_io_advance(const struct lu_env *env,
 #endif
 	CLOBINVRNT(env, obj, vvp_object_invariant(obj));
 
-	if (!cl_is_normalio(env, io))
+	/* no user buffer for async read-ahead */
+	if (!cl_is_normalio(env, io) || vio->vui_iter == NULL)
 		return;
 
 #ifdef HAVE_FILE_OPERATIONS_READ_WRITE_ITER
@@ -805,6 +806,11 @@ static int vvp_io_read_start(const struct lu_env *env,
 	if (!can_populate_pages(env, io, inode))
 		return 0;
 
+	/* the read-ahead worker queues its pages by itself, holding the
+	 * extent lock and lli_trunc_sem, see ll_readahead_work() */
+	if (io->ci_async_readahead)
+		return 0;
+
 	result = vvp_prep_size(env, obj, io, pos, tot, &exceed);
 	if (result != 0)
 		return result;
@@ -823,7 +829,7 @@ static int vvp_io_read_start(const struct lu_env *env,
 		vio->vui_ra_valid = true;
 		vio->vui_ra_start = cl_index(obj, pos);
 		vio->vui_ra_count = cl_index(obj, tot + PAGE_CACHE_SIZE - 1);
-		ll_ras_enter(file);
+		vio->vui_ras = ll_ras_enter(file, vio->vui_ra_start);
 	}
 
 	/* BUG: 5972 */
@@ -1485,9 +1491,10 @@ int vvp_io_init(const struct lu_env *env, struct cl_object *obj,
 		 * it'll be fetched by osc when building RPC.
 		 *
 		 * it's not accurate if the file is shared by different
-		 * jobs.
+		 * jobs. Async read-ahead keeps the jobid of the reader.
 		 */
-		lustre_get_jobid(lli->lli_jobid);
+		if (!io->ci_async_readahead)
+			lustre_get_jobid(lli->lli_jobid);
 	} else if (io->ci_type == CIT_SETATTR) {
 		if (!cl_io_is_trunc(io))
 			io->ci_lockreq = CILR_MANDATORY;
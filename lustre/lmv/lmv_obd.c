@@ -1896,9 +1896,100 @@ lmv_getattr_name(struct obd_export *exp,struct md_op_data *op_data,
          fl == MF_MDC_CANCEL_FID4 ? &op_data->op_fid4 : \
          NULL)
 
+/* Max number of MDTs whose locks are cancelled by one metadata operation. */
+#define LMV_ELC_BATCH_MAX	4
+
+/**
+ * Unused locks collected on MDTs other than the one an operation is sent to.
+ *
+ * Instead of one cancel RPC per FID, locks are gathered per target and sent
+ * by lmv_elc_batch_flush() in a single asynchronous cancel RPC for each MDT,
+ * in parallel with the operation itself.
+ */
+struct lmv_elc_batch {
+	int	leb_nr;
+	struct {
+		struct lmv_tgt_desc	*lee_tgt;
+		struct list_head	 lee_cancels;
+		int			 lee_count;
+	} leb_ent[LMV_ELC_BATCH_MAX];
+};
+
+static inline void lmv_elc_batch_init(struct lmv_elc_batch *batch)
+{
+	batch->leb_nr = 0;
+}
+
+/**
+ * Collect unused locks on \a fid held through \a tgt into \a batch.
+ *
+ * \retval 0		locks collected (possibly none)
+ * \retval -ENOSPC	batch has no room for another target
+ * \retval negative	other errno, locks are not collected
+ */
+static int lmv_elc_batch_add(struct lmv_elc_batch *batch,
+			     struct lmv_tgt_desc *tgt, const struct lu_fid *fid,
+			     union ldlm_policy_data *policy,
+			     enum ldlm_mode mode)
+{
+	int count;
+	int i;
+
+	for (i = 0; i < batch->leb_nr; i++)
+		if (batch->leb_ent[i].lee_tgt == tgt)
+			break;
+
+	if (i == batch->leb_nr) {
+		if (i == LMV_ELC_BATCH_MAX)
+			return -ENOSPC;
+
+		batch->leb_ent[i].lee_tgt = tgt;
+		INIT_LIST_HEAD(&batch->leb_ent[i].lee_cancels);
+		batch->leb_ent[i].lee_count = 0;
+		batch->leb_nr++;
+	}
+
+	count = md_cancel_unused_local(tgt->ltd_exp, fid, policy, mode,
+				       LCF_ASYNC | LCF_BL_AST,
+				       &batch->leb_ent[i].lee_cancels);
+	if (count < 0)
+		return count;
+
+	batch->leb_ent[i].lee_count += count;
+
+	return 0;
+}
+
+/**
+ * Send the locks collected in \a batch, one asynchronous cancel RPC per
+ * MDT, and reset the batch.
+ */
+static void lmv_elc_batch_flush(struct lmv_elc_batch *batch)
+{
+	int i;
+	int rc;
+
+	for (i = 0; i < batch->leb_nr; i++) {
+		if (batch->leb_ent[i].lee_count == 0)
+			continue;
+
+		CDEBUG(D_INODE, "EARLY_CANCEL %d locks on MDT%04x\n",
+		       batch->leb_ent[i].lee_count,
+		       batch->leb_ent[i].lee_tgt->ltd_idx);
+		rc = ldlm_cli_cancel_list(&batch->leb_ent[i].lee_cancels,
+					  batch->leb_ent[i].lee_count, NULL,
+					  LCF_ASYNC);
+		if (rc != ELDLM_OK)
+			CDEBUG(D_INODE, "EARLY_CANCEL on MDT%04x: rc = %d\n",
+			       batch->leb_ent[i].lee_tgt->ltd_idx, rc);
+	}
+	batch->leb_nr = 0;
+}
+
 static int lmv_early_cancel(struct obd_export *exp, struct lmv_tgt_desc *tgt,
 			    struct md_op_data *op_data, __u32 op_tgt,
-			    enum ldlm_mode mode, int bits, int flag)
+			    enum ldlm_mode mode, int bits, int flag,
+			    struct lmv_elc_batch *batch)
 {
 	struct lu_fid *fid = md_op_data_fid(op_data, flag);
 	struct lmv_obd *lmv = &exp->exp_obd->u.lmv;
@@ -1918,6 +2009,10 @@ static int lmv_early_cancel(struct obd_export *exp, struct lmv_tgt_desc *tgt,
 	if (tgt->ltd_idx != op_tgt) {
 		CDEBUG(D_INODE, "EARLY_CANCEL on "DFID"\n", PFID(fid));
 		policy.l_inodebits.bits = bits;
+		if (batch != NULL &&
+		    lmv_elc_batch_add(batch, tgt, fid, &policy, mode) == 0)
+			RETURN(0);
+
 		rc = md_cancel_unused(tgt->ltd_exp, fid, &policy,
 				      mode, LCF_ASYNC, NULL);
 	} else {
@@ -1978,7 +2073,7 @@ static int lmv_link(struct obd_export *exp, struct md_op_data *op_data,
 	 */
 	op_data->op_flags |= MF_MDC_CANCEL_FID2;
 	rc = lmv_early_cancel(exp, NULL, op_data, tgt->ltd_idx, LCK_EX,
-			      MDS_INODELOCK_UPDATE, MF_MDC_CANCEL_FID1);
+			      MDS_INODELOCK_UPDATE, MF_MDC_CANCEL_FID1, NULL);
 	if (rc != 0)
 		RETURN(rc);
 
@@ -1998,6 +2093,7 @@ static int lmv_rename(struct obd_export *exp, struct md_op_data *op_data,
 	struct lmv_tgt_desc     *tgt_tgt;
 	struct obd_export	*target_exp;
 	struct mdt_body		*body;
+	struct lmv_elc_batch	batch;
 	int			rc;
 	ENTRY;
 
@@ -2080,16 +2176,21 @@ static int lmv_rename(struct obd_export *exp, struct md_op_data *op_data,
 	 */
 	op_data->op_flags |= MF_MDC_CANCEL_FID1 | MF_MDC_CANCEL_FID3;
 
+	/*
+	 * Locks on other MDTs are collected in @batch and cancelled by one
+	 * RPC per MDT sent right before the rename itself.
+	 */
+	lmv_elc_batch_init(&batch);
+
 	/*
 	 * Cancel UPDATE locks on tgt parent (fid2), tgt_tgt is its
 	 * own target.
 	 */
 	rc = lmv_early_cancel(exp, NULL, op_data, src_tgt->ltd_idx,
 			      LCK_EX, MDS_INODELOCK_UPDATE,
-			      MF_MDC_CANCEL_FID2);
-
+			      MF_MDC_CANCEL_FID2, &batch);
 	if (rc != 0)
-		RETURN(rc);
+		GOTO(out_cancel, rc);
 	/*
 	 * Cancel LOOKUP locks on source child (fid3) for parent tgt_tgt.
 	 */
@@ -2098,20 +2199,20 @@ static int lmv_rename(struct obd_export *exp, struct md_op_data *op_data,
 
 		tgt = lmv_find_target(lmv, &op_data->op_fid1);
 		if (IS_ERR(tgt))
-			RETURN(PTR_ERR(tgt));
+			GOTO(out_cancel, rc = PTR_ERR(tgt));
 
 		/* Cancel LOOKUP lock on its parent */
 		rc = lmv_early_cancel(exp, tgt, op_data, src_tgt->ltd_idx,
 				      LCK_EX, MDS_INODELOCK_LOOKUP,
-				      MF_MDC_CANCEL_FID3);
+				      MF_MDC_CANCEL_FID3, &batch);
 		if (rc != 0)
-			RETURN(rc);
+			GOTO(out_cancel, rc);
 
 		rc = lmv_early_cancel(exp, NULL, op_data, src_tgt->ltd_idx,
 				      LCK_EX, MDS_INODELOCK_FULL,
-				      MF_MDC_CANCEL_FID3);
+				      MF_MDC_CANCEL_FID3, &batch);
 		if (rc != 0)
-			RETURN(rc);
+			GOTO(out_cancel, rc);
 	}
 
 retry_rename:
@@ -2123,13 +2224,13 @@ retry_rename:
 
 		rc = lmv_early_cancel(exp, NULL, op_data, src_tgt->ltd_idx,
 				      LCK_EX, MDS_INODELOCK_FULL,
-				      MF_MDC_CANCEL_FID4);
+				      MF_MDC_CANCEL_FID4, &batch);
 		if (rc != 0)
-			RETURN(rc);
+			GOTO(out_cancel, rc);
 
 		tgt = lmv_find_target(lmv, &op_data->op_fid4);
 		if (IS_ERR(tgt))
-			RETURN(PTR_ERR(tgt));
+			GOTO(out_cancel, rc = PTR_ERR(tgt));
 
 		/* Since the target child might be destroyed, and it might
 		 * become orphan, and we can only check orphan on the local
@@ -2139,6 +2240,9 @@ retry_rename:
 		target_exp = tgt->ltd_exp;
 	}
 
+	/* cancels go out in parallel with the rename RPC */
+	lmv_elc_batch_flush(&batch);
+
 	rc = md_rename(target_exp, op_data, old, oldlen, new, newlen,
 		       request);
 
@@ -2160,6 +2264,10 @@ retry_rename:
 	ptlrpc_req_finished(*request);
 	*request = NULL;
 	goto retry_rename;
+
+out_cancel:
+	lmv_elc_batch_flush(&batch);
+	RETURN(rc);
 }
 
 static int lmv_setattr(struct obd_export *exp, struct md_op_data *op_data,
@@ -2557,6 +2665,7 @@ static int lmv_unlink(struct obd_export *exp, struct md_op_data *op_data,
 	struct lmv_tgt_desc     *tgt = NULL;
 	struct lmv_tgt_desc     *parent_tgt = NULL;
 	struct mdt_body		*body;
+	struct lmv_elc_batch	batch;
 	int                     rc;
 	int			stripe_index = 0;
 	struct lmv_stripe_md	*lsm = op_data->op_mea1;
@@ -2631,14 +2740,21 @@ try_next_stripe:
 	if (IS_ERR(parent_tgt))
 		RETURN(PTR_ERR(parent_tgt));
 
+	lmv_elc_batch_init(&batch);
 	if (parent_tgt != tgt) {
 		rc = lmv_early_cancel(exp, parent_tgt, op_data, tgt->ltd_idx,
 				      LCK_EX, MDS_INODELOCK_LOOKUP,
-				      MF_MDC_CANCEL_FID3);
+				      MF_MDC_CANCEL_FID3, &batch);
+		if (rc != 0) {
+			lmv_elc_batch_flush(&batch);
+			RETURN(rc);
+		}
 	}
 
 	rc = lmv_early_cancel(exp, NULL, op_data, tgt->ltd_idx, LCK_EX,
-			      MDS_INODELOCK_FULL, MF_MDC_CANCEL_FID3);
+			      MDS_INODELOCK_FULL, MF_MDC_CANCEL_FID3, &batch);
+	/* cancels go out in parallel with the unlink RPC */
+	lmv_elc_batch_flush(&batch);
 	if (rc != 0)
 		RETURN(rc);
 
@@ -3152,9 +3268,6 @@ int lmv_intent_getattr_async(struct obd_export *exp,
 	int                      rc;
 	ENTRY;
 
-	if (!fid_is_sane(&op_data->op_fid2))
-		RETURN(-EINVAL);
-
 	rc = lmv_check_connect(obd);
 	if (rc)
 		RETURN(rc);
@@ -3163,9 +3276,15 @@ int lmv_intent_getattr_async(struct obd_export *exp,
 	if (IS_ERR(ptgt))
 		RETURN(PTR_ERR(ptgt));
 
-	ctgt = lmv_locate_mds(lmv, op_data, &op_data->op_fid2);
-	if (IS_ERR(ctgt))
-		RETURN(PTR_ERR(ctgt));
+	/* statahead by name only doesn't know child FID, let the MDT of the
+	 * parent resolve it, it replies OBD_MD_MDS if the child is remote */
+	if (!fid_is_sane(&op_data->op_fid2)) {
+		ctgt = ptgt;
+	} else {
+		ctgt = lmv_locate_mds(lmv, op_data, &op_data->op_fid2);
+		if (IS_ERR(ctgt))
+			RETURN(PTR_ERR(ctgt));
+	}
 
 	/*
 	 * if child is on remote MDT, we need 2 async RPCs to fetch both LOOKUP
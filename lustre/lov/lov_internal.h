@@ -45,6 +45,12 @@
  * the old maximum object size from ext3. */
 #define LUSTRE_EXT3_STRIPE_MAXBYTES 0x1fffffff000ULL
 
+/* Default number of sub-lock enqueues (glimpses) a single top-lock keeps in
+ * flight, see lov_lock_enqueue(). 0 sends all of them at once, a window only
+ * spreads the RPC load of widely striped files, it never makes stat() faster.
+ */
+#define LOV_GLIMPSE_WINDOW_DEFAULT 0
+
 struct lov_stripe_md {
 	atomic_t	lsm_refc;
 	spinlock_t	lsm_lock;
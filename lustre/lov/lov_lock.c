@@ -238,15 +238,35 @@ static int lov_lock_enqueue(const struct lu_env *env,
 {
 	struct cl_lock          *lock   = slice->cls_lock;
 	struct lov_lock         *lovlck = cl2lov_lock(slice);
+	struct lov_device	*dev;
+	unsigned int		window = 0;
 	int                     i;
 	int                     rc      = 0;
 
 	ENTRY;
 
+	/* Asynchronous sub-lock enqueues (glimpses) complete against \a anchor
+	 * and are all sent in parallel. If the administrator set a glimpse
+	 * window, bound the number of them in flight so that a single stat()
+	 * of a widely striped file does not flood the client's RPC slots and
+	 * every OST at once, at the cost of a longer stat(). */
+	if (anchor != NULL) {
+		dev = lu2lov_dev(lock->cll_descr.cld_obj->co_lu.lo_dev);
+		window = dev->ld_lov->lov_glimpse_window;
+		if (window >= lovlck->lls_nr)
+			window = 0;
+	}
+
 	for (i = 0; i < lovlck->lls_nr; ++i) {
 		struct lov_lock_sub     *lls = &lovlck->lls_sub[i];
 		struct lov_sublock_env  *subenv;
 
+		/* csi_sync_nr also counts the reference held by
+		 * cl_lock_request(), so this leaves at most window - 1
+		 * sub-locks outstanding before the next one is sent. */
+		if (window > 0)
+			cl_sync_io_throttle(env, anchor, window);
+
 		subenv = lov_sublock_env_get(env, lock, lls);
 		if (IS_ERR(subenv)) {
 			rc = PTR_ERR(subenv);
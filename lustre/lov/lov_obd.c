@@ -823,6 +823,7 @@ int lov_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
 	mutex_init(&lov->lov_lock);
 	atomic_set(&lov->lov_refcount, 0);
 	lov->lov_sp_me = LUSTRE_SP_CLI;
+	lov->lov_glimpse_window = LOV_GLIMPSE_WINDOW_DEFAULT;
 
 	init_rwsem(&lov->lov_notify_lock);
 
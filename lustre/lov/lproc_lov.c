@@ -138,6 +138,35 @@ static ssize_t lov_stripetype_seq_write(struct file *file,
 }
 LPROC_SEQ_FOPS(lov_stripetype);
 
+static int lov_glimpse_window_seq_show(struct seq_file *m, void *v)
+{
+	struct obd_device *dev = (struct obd_device *)m->private;
+
+	LASSERT(dev != NULL);
+	seq_printf(m, "%u\n", dev->u.lov.lov_glimpse_window);
+	return 0;
+}
+
+static ssize_t lov_glimpse_window_seq_write(struct file *file,
+					    const char __user *buffer,
+					    size_t count, loff_t *off)
+{
+	struct obd_device *dev = ((struct seq_file *)file->private_data)->private;
+	int val, rc;
+
+	LASSERT(dev != NULL);
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	if (val < 0)
+		return -ERANGE;
+
+	dev->u.lov.lov_glimpse_window = val;
+	return count;
+}
+LPROC_SEQ_FOPS(lov_glimpse_window);
+
 static int lov_stripecount_seq_show(struct seq_file *m, void *v)
 {
 	struct obd_device *dev = (struct obd_device *)m->private;
@@ -306,6 +335,8 @@ struct lprocfs_vars lprocfs_lov_obd_vars[] = {
 	  .fops	=	&lov_kbytesavail_fops	},
 	{ .name	=	"desc_uuid",
 	  .fops	=	&lov_desc_uuid_fops	},
+	{ .name	=	"glimpse_window",
+	  .fops	=	&lov_glimpse_window_fops	},
 	{ NULL }
 };
 
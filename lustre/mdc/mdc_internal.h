@@ -126,6 +126,10 @@ int mdc_unlink(struct obd_export *exp, struct md_op_data *op_data,
 int mdc_cancel_unused(struct obd_export *exp, const struct lu_fid *fid,
 		      union ldlm_policy_data *policy, enum ldlm_mode mode,
 		      enum ldlm_cancel_flags flags, void *opaque);
+int mdc_cancel_unused_local(struct obd_export *exp, const struct lu_fid *fid,
+			    union ldlm_policy_data *policy, enum ldlm_mode mode,
+			    enum ldlm_cancel_flags flags,
+			    struct list_head *cancels);
 
 int mdc_revalidate_lock(struct obd_export *exp, struct lookup_intent *it,
                         struct lu_fid *fid, __u64 *bits);
@@ -169,6 +169,37 @@ int mdc_cancel_unused(struct obd_export *exp, const struct lu_fid *fid,
 	RETURN(rc);
 }
 
+/* Cancel locally the unused locks on @fid matched by @policy & @mode, and add
+ * them to @cancels. Unlike mdc_resource_get_unused(), the locks are not packed
+ * into a request of this export but sent by the caller with
+ * ldlm_cli_cancel_list(), so they are collected even if ELC is disabled.
+ * Returns the amount of locks added to @cancels. */
+int mdc_cancel_unused_local(struct obd_export *exp, const struct lu_fid *fid,
+			    union ldlm_policy_data *policy, enum ldlm_mode mode,
+			    enum ldlm_cancel_flags flags,
+			    struct list_head *cancels)
+{
+	struct obd_device *obd = class_exp2obd(exp);
+	struct ldlm_resource *res;
+	struct ldlm_res_id res_id;
+	int count;
+
+	ENTRY;
+
+	fid_build_reg_res_name(fid, &res_id);
+	res = ldlm_resource_get(obd->obd_namespace, NULL, &res_id, 0, 0);
+	if (IS_ERR(res))
+		RETURN(0);
+
+	LDLM_RESOURCE_ADDREF(res);
+	count = ldlm_cancel_resource_local(res, cancels, policy, mode, 0,
+					   flags, NULL);
+	LDLM_RESOURCE_DELREF(res);
+	ldlm_resource_putref(res);
+
+	RETURN(count);
+}
+
 int mdc_null_inode(struct obd_export *exp,
 		   const struct lu_fid *fid)
 {
@@ -2808,6 +2808,7 @@ static struct md_ops mdc_md_ops = {
 	.m_read_page		= mdc_read_page,
         .m_unlink           = mdc_unlink,
         .m_cancel_unused    = mdc_cancel_unused,
+	.m_cancel_unused_local = mdc_cancel_unused_local,
         .m_init_ea_size     = mdc_init_ea_size,
         .m_set_lock_data    = mdc_set_lock_data,
         .m_lock_match       = mdc_lock_match,
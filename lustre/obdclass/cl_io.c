@@ -1207,6 +1207,7 @@ void cl_sync_io_init(struct cl_sync_io *anchor, int nr,
 	init_waitqueue_head(&anchor->csi_waitq);
 	atomic_set(&anchor->csi_sync_nr, nr);
 	atomic_set(&anchor->csi_barrier, nr > 0);
+	atomic_set(&anchor->csi_wakers, 0);
 	anchor->csi_sync_rc = 0;
 	anchor->csi_end_io = end;
 	LASSERT(end != NULL);
@@ -1245,7 +1246,8 @@ int cl_sync_io_wait(const struct lu_env *env, struct cl_sync_io *anchor,
 	LASSERT(atomic_read(&anchor->csi_sync_nr) == 0);
 
 	/* wait until cl_sync_io_note() has done wakeup */
-	while (unlikely(atomic_read(&anchor->csi_barrier) != 0)) {
+	while (unlikely(atomic_read(&anchor->csi_barrier) != 0 ||
+			atomic_read(&anchor->csi_wakers) != 0)) {
 		cpu_relax();
 	}
 	RETURN(rc);
@@ -1258,6 +1260,8 @@ EXPORT_SYMBOL(cl_sync_io_wait);
 void cl_sync_io_note(const struct lu_env *env, struct cl_sync_io *anchor,
 		     int ioret)
 {
+	int window;
+	int nr;
 	ENTRY;
 	if (anchor->csi_sync_rc == 0 && ioret < 0)
 		anchor->csi_sync_rc = ioret;
@@ -1267,11 +1271,66 @@ void cl_sync_io_note(const struct lu_env *env, struct cl_sync_io *anchor,
 	 * IO.
 	 */
 	LASSERT(atomic_read(&anchor->csi_sync_nr) > 0);
-	if (atomic_dec_and_test(&anchor->csi_sync_nr)) {
+	/* Once this entry is dropped, other completions and the owner may end
+	 * the IO and destroy the anchor, so sample the window before that and
+	 * hold off cl_sync_io_wait() if we are going to wake the owner. */
+	window = ACCESS_ONCE(anchor->csi_window);
+	if (unlikely(window > 0))
+		atomic_inc(&anchor->csi_wakers);
+	nr = atomic_dec_return(&anchor->csi_sync_nr);
+	if (nr == 0) {
+		if (unlikely(window > 0))
+			atomic_dec(&anchor->csi_wakers);
 		LASSERT(anchor->csi_end_io != NULL);
 		anchor->csi_end_io(env, anchor);
 		/* Can't access anchor any more */
+	} else if (unlikely(window > 0)) {
+		/* concurrent completions may step over the window value, so
+		 * compare with what this one left behind. */
+		if (nr <= window)
+			wake_up_all(&anchor->csi_waitq);
+		atomic_dec(&anchor->csi_wakers);
+		/* Can't access anchor any more */
 	}
 	EXIT;
 }
 EXPORT_SYMBOL(cl_sync_io_note);
+
+/**
+ * Wait until no more than \a window entries of \a anchor are outstanding.
+ *
+ * This is used to bound the number of asynchronous requests a single thread
+ * keeps in flight against one anchor, e.g. glimpses of a widely striped
+ * file. The caller must hold its own reference on the anchor (as
+ * cl_lock_request() does) so that the anchor can't complete underneath.
+ *
+ * \param[in] anchor	anchor the requests were submitted against
+ * \param[in] window	maximum number of outstanding entries, including the
+ *			caller's own reference
+ */
+void cl_sync_io_throttle(const struct lu_env *env, struct cl_sync_io *anchor,
+			 int window)
+{
+	struct l_wait_info lwi;
+	ENTRY;
+
+	LASSERT(window > 0);
+	if (atomic_read(&anchor->csi_sync_nr) <= window)
+		RETURN_EXIT;
+
+	CDEBUG(D_DLMTRACE, "anchor %p: throttle %d entries to window %d\n",
+	       anchor, atomic_read(&anchor->csi_sync_nr), window);
+	anchor->csi_window = window;
+	smp_mb();
+	/* a completion which sampled csi_window before it was set won't wake
+	 * us up, so re-check now and then instead of sleeping forever. */
+	while (atomic_read(&anchor->csi_sync_nr) > window) {
+		lwi = LWI_TIMEOUT(cfs_time_seconds(1) / 100 + 1, NULL, NULL);
+		l_wait_event(anchor->csi_waitq,
+			     atomic_read(&anchor->csi_sync_nr) <= window,
+			     &lwi);
+	}
+	anchor->csi_window = 0;
+	EXIT;
+}
+EXPORT_SYMBOL(cl_sync_io_throttle);
@@ -110,6 +110,24 @@ static void cl_page_get_trust(struct cl_page *page)
 	atomic_inc(&page->cp_ref);
 }
 
+/* slice \a i of \a page, counting from the top of the stack */
+#define cl_page_slice_get(page, i)					\
+	((struct cl_page_slice *)((char *)(page) +			\
+				  (page)->cp_layer_offset[i]))
+
+/*
+ * Iterate over the slices of \a page, from the top of the stack to the
+ * bottom, or the other way around. The slices sit at fixed offsets in the
+ * page allocation, so this is an array walk instead of a list walk.
+ */
+#define cl_page_slice_for_each(page, slice, i)				\
+	for (i = 0; i < (page)->cp_layer_count &&			\
+		    ((slice) = cl_page_slice_get(page, i)) != NULL; i++)
+
+#define cl_page_slice_for_each_reverse(page, slice, i)			\
+	for (i = (page)->cp_layer_count - 1; i >= 0 &&			\
+		    ((slice) = cl_page_slice_get(page, i)) != NULL; i--)
+
 /**
  * Returns a slice within a page, corresponding to the given layer in the
  * device stack.
@@ -121,9 +139,10 @@ cl_page_at_trusted(const struct cl_page *page,
                    const struct lu_device_type *dtype)
 {
 	const struct cl_page_slice *slice;
+	int i;
 	ENTRY;
 
-	list_for_each_entry(slice, &page->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each(page, slice, i) {
 		if (slice->cpl_obj->co_lu.lo_dev->ld_type == dtype)
 			RETURN(slice);
 	}
@@ -134,21 +153,19 @@ static void cl_page_free(const struct lu_env *env, struct cl_page *page)
 {
 	struct cl_object *obj  = page->cp_obj;
 	int pagesize = cl_object_header(obj)->coh_page_bufsize;
+	struct cl_page_slice *slice;
+	int i;
 
 	PASSERT(env, page, list_empty(&page->cp_batch));
 	PASSERT(env, page, page->cp_owner == NULL);
 	PASSERT(env, page, page->cp_state == CPS_FREEING);
 
 	ENTRY;
-	while (!list_empty(&page->cp_layers)) {
-		struct cl_page_slice *slice;
-
-		slice = list_entry(page->cp_layers.next,
-				   struct cl_page_slice, cpl_linkage);
-		list_del_init(page->cp_layers.next);
+	cl_page_slice_for_each(page, slice, i) {
 		if (unlikely(slice->cpl_ops->cpo_fini != NULL))
 			slice->cpl_ops->cpo_fini(env, slice);
 	}
+	page->cp_layer_count = 0;
 	CS_PAGE_DEC(obj, total);
 	CS_PAGESTATE_DEC(obj, page->cp_state);
 	lu_object_ref_del_at(&obj->co_lu, &page->cp_obj_ref, "cl_page", page);
@@ -189,7 +206,7 @@ struct cl_page *cl_page_alloc(const struct lu_env *env,
 		page->cp_vmpage = vmpage;
 		cl_page_state_set_trust(page, CPS_CACHED);
 		page->cp_type = type;
-		INIT_LIST_HEAD(&page->cp_layers);
+		page->cp_layer_count = 0;
 		INIT_LIST_HEAD(&page->cp_batch);
 		lu_ref_init(&page->cp_reference);
 		head = o->co_lu.lo_header;
@@ -432,11 +449,12 @@ EXPORT_SYMBOL(cl_page_at);
 	struct cl_page		   *__page = (_page);			\
 	const struct cl_page_slice *__scan;				\
 	int			    __result;				\
+	int			    __i;				\
 	ptrdiff_t		    __op   = (_op);			\
 	int			   (*__method)_proto;			\
 									\
 	__result = 0;							\
-	list_for_each_entry(__scan, &__page->cp_layers, cpl_linkage) {	\
+	cl_page_slice_for_each(__page, __scan, __i) {			\
 		__method = *(void **)((char *)__scan->cpl_ops +  __op);	\
 		if (__method != NULL) {					\
 			__result = (*__method)(__env, __scan, ## __VA_ARGS__); \
@@ -454,10 +472,11 @@ do {									\
 	const struct lu_env        *__env  = (_env);			\
 	struct cl_page             *__page = (_page);			\
 	const struct cl_page_slice *__scan;				\
+	int			    __i;				\
 	ptrdiff_t                   __op   = (_op);			\
 	void                      (*__method)_proto;			\
 									\
-	list_for_each_entry(__scan, &__page->cp_layers, cpl_linkage) {	\
+	cl_page_slice_for_each(__page, __scan, __i) {			\
 		__method = *(void **)((char *)__scan->cpl_ops +  __op); \
 		if (__method != NULL)					\
 			(*__method)(__env, __scan, ## __VA_ARGS__);	\
@@ -469,12 +488,12 @@ do {									\
 	const struct lu_env        *__env  = (_env);			\
 	struct cl_page             *__page = (_page);			\
 	const struct cl_page_slice *__scan;				\
+	int			    __i;				\
 	ptrdiff_t                   __op   = (_op);			\
 	void                      (*__method)_proto;			\
 									\
 	/* get to the bottom page. */					\
-	list_for_each_entry_reverse(__scan, &__page->cp_layers,		\
-				    cpl_linkage) {			\
+	cl_page_slice_for_each_reverse(__page, __scan, __i) {		\
 		__method = *(void **)((char *)__scan->cpl_ops + __op);	\
 		if (__method != NULL)					\
 			(*__method)(__env, __scan, ## __VA_ARGS__);	\
@@ -824,8 +843,7 @@ int cl_page_is_vmlocked(const struct lu_env *env, const struct cl_page *pg)
         const struct cl_page_slice *slice;
 
         ENTRY;
-        slice = container_of(pg->cp_layers.next,
-                             const struct cl_page_slice, cpl_linkage);
+	slice = cl_page_slice_get(pg, 0);
         PASSERT(env, pg, slice->cpl_ops->cpo_is_vmlocked != NULL);
         /*
          * Call ->cpo_is_vmlocked() directly instead of going through
@@ -1073,7 +1091,8 @@ EXPORT_SYMBOL(cl_page_size);
  *
  * This is called by cl_object_operations::coo_page_init() methods to add a
  * per-layer state to the page. New state is added at the end of
- * cl_page::cp_layers list, that is, it is at the bottom of the stack.
+ * cl_page::cp_layer_offset array, that is, it is at the bottom of the stack.
+ * \a slice must be part of the page allocation.
  *
  * \see cl_lock_slice_add(), cl_req_slice_add(), cl_io_slice_add()
  */
@@ -1081,8 +1100,13 @@ void cl_page_slice_add(struct cl_page *page, struct cl_page_slice *slice,
 		       struct cl_object *obj, pgoff_t index,
 		       const struct cl_page_operations *ops)
 {
+	ptrdiff_t offset = (char *)slice - (char *)page;
+
 	ENTRY;
-	list_add_tail(&slice->cpl_linkage, &page->cp_layers);
+	LASSERT(page->cp_layer_count < CP_MAX_LAYER);
+	LASSERT(offset > 0 &&
+		offset < cl_object_header(page->cp_obj)->coh_page_bufsize);
+	page->cp_layer_offset[page->cp_layer_count++] = offset;
 	slice->cpl_obj  = obj;
 	slice->cpl_index = index;
 	slice->cpl_ops  = ops;
@@ -1103,10 +1127,27 @@ struct cl_client_cache *cl_cache_init(unsigned long lru_page_max)
 	if (cache == NULL)
 		RETURN(NULL);
 
+	OBD_ALLOC(cache->ccc_nodes, nr_node_ids * sizeof(*cache->ccc_nodes));
+	if (cache->ccc_nodes == NULL) {
+		OBD_FREE(cache, sizeof(*cache));
+		RETURN(NULL);
+	}
+
+#ifdef HAVE_PERCPU_COUNTER_INIT_GFP_FLAG
+	if (percpu_counter_init(&cache->ccc_lru_left, 0, GFP_KERNEL) != 0) {
+#else
+	if (percpu_counter_init(&cache->ccc_lru_left, 0) != 0) {
+#endif
+		OBD_FREE(cache->ccc_nodes,
+			 nr_node_ids * sizeof(*cache->ccc_nodes));
+		OBD_FREE(cache, sizeof(*cache));
+		RETURN(NULL);
+	}
+
 	/* Initialize cache data */
 	atomic_set(&cache->ccc_users, 1);
 	cache->ccc_lru_max = lru_page_max;
-	atomic_long_set(&cache->ccc_lru_left, lru_page_max);
+	cl_cache_lru_give(cache, NUMA_NO_NODE, lru_page_max);
 	spin_lock_init(&cache->ccc_lru_lock);
 	INIT_LIST_HEAD(&cache->ccc_lru);
 
@@ -1135,7 +1176,136 @@ EXPORT_SYMBOL(cl_cache_incref);
  */
 void cl_cache_decref(struct cl_client_cache *cache)
 {
-	if (atomic_dec_and_test(&cache->ccc_users))
+	if (atomic_dec_and_test(&cache->ccc_users)) {
+		percpu_counter_destroy(&cache->ccc_lru_left);
+		OBD_FREE(cache->ccc_nodes,
+			 nr_node_ids * sizeof(*cache->ccc_nodes));
 		OBD_FREE(cache, sizeof(*cache));
+	}
 }
 EXPORT_SYMBOL(cl_cache_decref);
+
+/**
+ * Total # of LRU slots available on all nodes.
+ */
+long cl_cache_lru_left(struct cl_client_cache *cache)
+{
+	long left = 0;
+	int nid;
+
+	for_each_online_node(nid)
+		left += atomic_long_read(&cache->ccc_nodes[nid].ccn_lru_left);
+
+	return left;
+}
+EXPORT_SYMBOL(cl_cache_lru_left);
+
+/**
+ * Approximate total # of LRU slots available, cheap enough to be checked
+ * for every page.
+ */
+long cl_cache_lru_left_approx(struct cl_client_cache *cache)
+{
+	return percpu_counter_read_positive(&cache->ccc_lru_left);
+}
+EXPORT_SYMBOL(cl_cache_lru_left_approx);
+
+static long cl_cache_node_take(struct cl_client_cache *cache, int nid,
+			       long npages, bool partial)
+{
+	struct cl_cache_node *ccn = &cache->ccc_nodes[nid];
+	long ov, nv;
+
+	do {
+		ov = atomic_long_read(&ccn->ccn_lru_left);
+		if (ov <= 0 || (!partial && ov < npages))
+			return 0;
+		nv = ov > npages ? ov - npages : 0;
+	} while (atomic_long_cmpxchg(&ccn->ccn_lru_left, ov, nv) != ov);
+
+	percpu_counter_sub(&cache->ccc_lru_left, ov - nv);
+
+	return ov - nv;
+}
+
+/**
+ * Take \a npages LRU slots from a single node, \a nid if it has enough of
+ * them, otherwise the first other node that does.
+ *
+ * \param[in,out] nid	node to take from first, NUMA_NO_NODE stands for the
+ *			node of the current CPU; set to the node the slots
+ *			were taken from, where they have to be given back
+ *
+ * \retval		\a npages if the slots were taken, 0 otherwise
+ */
+long cl_cache_lru_take(struct cl_client_cache *cache, int *nid, long npages)
+{
+	int n;
+
+	if (*nid == NUMA_NO_NODE)
+		*nid = numa_node_id();
+
+	if (cl_cache_node_take(cache, *nid, npages, false) == npages)
+		return npages;
+
+	for_each_online_node(n) {
+		if (n == *nid)
+			continue;
+
+		if (cl_cache_node_take(cache, n, npages, false) == npages) {
+			atomic_long_add(npages,
+					&cache->ccc_nodes[*nid].ccn_borrowed);
+			*nid = n;
+			return npages;
+		}
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(cl_cache_lru_take);
+
+/**
+ * Remove up to \a npages free LRU slots from the budget, taking from all
+ * the nodes. Used when max_cached_mb is reduced.
+ *
+ * \retval		# of slots removed
+ */
+long cl_cache_lru_shrink(struct cl_client_cache *cache, long npages)
+{
+	long taken = 0;
+	int nid;
+
+	for_each_online_node(nid) {
+		taken += cl_cache_node_take(cache, nid, npages - taken, true);
+		if (taken == npages)
+			break;
+	}
+
+	return taken;
+}
+EXPORT_SYMBOL(cl_cache_lru_shrink);
+
+/**
+ * Give \a npages LRU slots back to node \a nid, the node they were taken
+ * from by cl_cache_lru_take(). NUMA_NO_NODE spreads new slots over all
+ * nodes.
+ */
+void cl_cache_lru_give(struct cl_client_cache *cache, int nid, long npages)
+{
+	percpu_counter_add(&cache->ccc_lru_left, npages);
+
+	if (nid == NUMA_NO_NODE) {
+		long share = npages / (long)num_online_nodes();
+		long rest = npages - share * num_online_nodes();
+
+		for_each_online_node(nid) {
+			atomic_long_add(share + rest,
+					&cache->ccc_nodes[nid].ccn_lru_left);
+			rest = 0;
+		}
+		return;
+	}
+
+	atomic_long_add(npages, &cache->ccc_nodes[nid].ccn_lru_left);
+}
+EXPORT_SYMBOL(cl_cache_lru_give);
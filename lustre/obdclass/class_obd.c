@@ -50,6 +50,7 @@
 #include <lustre_ver.h>
 #include <libcfs/list.h>
 #include <cl_object.h>
+#include <obd_cksum.h>
 #ifdef HAVE_SERVER_SUPPORT
 # include <dt_object.h>
 # include <md_object.h>
@@ -576,6 +577,8 @@ static int __init obdclass_init(void)
 		return err;
 
 	err = lustre_register_fs();
+	if (err == 0)
+		obd_t10_cksum_speed_init();
 
 	return err;
 }
@@ -623,6 +626,7 @@ static void __exit obdclass_exit(void)
 #endif /* HAVE_SERVER_SUPPORT */
 	cl_global_fini();
 	lu_global_fini();
+	obd_t10_cksum_fini();
 
         obd_cleanup_caches();
         obd_sysctl_clean();
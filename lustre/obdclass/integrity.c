@@ -0,0 +1,650 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * Copyright (c) 2016, Intel Corporation.
+ */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ * Lustre is a trademark of Sun Microsystems, Inc.
+ *
+ * lustre/obdclass/integrity.c
+ *
+ * T10-PI style bulk checksums.
+ *
+ * Instead of running one hash over the whole RPC, a 16-bit guard tag is
+ * computed for every sector of the bulk (either the IP checksum or the
+ * T10-DIF CRC, both of which have fast architecture specific versions in
+ * the kernel). The RPC checksum is then a crc32 over the array of guard
+ * tags, which is only 1/256 (512B sectors) or 1/2048 (4KB sectors) of the
+ * data size. Sectors are independent of each other, so the guard tags are
+ * also what a caller can compute piecewise and combine later.
+ */
+
+#define DEBUG_SUBSYSTEM S_CLASS
+
+#include <linux/crc-t10dif.h>
+#include <linux/kthread.h>
+#include <net/checksum.h>
+#include <obd_class.h>
+#include <obd_cksum.h>
+
+typedef __u16 (obd_dif_csum_fn)(void *, unsigned int);
+
+static __u16 obd_dif_ip_fn(void *data, unsigned int len)
+{
+	return (__force __u16)ip_compute_csum(data, len);
+}
+
+#if defined(CONFIG_CRC_T10DIF) || defined(CONFIG_CRC_T10DIF_MODULE)
+static __u16 obd_dif_crc_fn(void *data, unsigned int len)
+{
+	return (__force __u16)cpu_to_be16(crc_t10dif(data, len));
+}
+#define OBD_T10_CRC_SUPPORTED 1
+#else
+#define obd_dif_crc_fn NULL
+#define OBD_T10_CRC_SUPPORTED 0
+#endif
+
+/* Number of guard tags buffered before they are fed to the top-level hash */
+#define OBD_T10_GUARD_BUF	(PAGE_SIZE / sizeof(__u16))
+
+struct obd_t10_cksum_desc {
+	struct cfs_crypto_hash_desc	*otc_hdesc;
+	obd_dif_csum_fn			*otc_fn;
+	unsigned int			 otc_sector_size;
+	unsigned int			 otc_used;
+	__u16				*otc_guards;
+};
+
+/**
+ * Array of T10 checksum speeds in MByte per second, indexed by the bit
+ * position of the OBD_CKSUM_T10* type. Zero means "not measured yet", they
+ * are measured by a thread started when obdclass is loaded.
+ */
+static int obd_t10_cksum_speeds[4];
+static DECLARE_COMPLETION(obd_t10_speed_done);
+
+static inline int obd_t10_cksum_index(cksum_type_t cksum_type)
+{
+	switch (cksum_type) {
+	case OBD_CKSUM_T10IP512:
+		return 0;
+	case OBD_CKSUM_T10IP4K:
+		return 1;
+	case OBD_CKSUM_T10CRC512:
+		return 2;
+	case OBD_CKSUM_T10CRC4K:
+		return 3;
+	default:
+		return -EINVAL;
+	}
+}
+
+static obd_dif_csum_fn *obd_t10_cksum_fn(cksum_type_t cksum_type)
+{
+	if (cksum_type & (OBD_CKSUM_T10IP512 | OBD_CKSUM_T10IP4K))
+		return obd_dif_ip_fn;
+	return obd_dif_crc_fn;
+}
+
+/**
+ * Initialize a T10 checksum descriptor for \a cksum_type.
+ *
+ * \param[in] cksum_type	one of the OBD_CKSUM_T10* types
+ *
+ * \retval			pointer to descriptor, to be passed to
+ *				obd_t10_cksum_update_page() and released by
+ *				obd_t10_cksum_final()
+ * \retval			ERR_PTR(errno) in case of error
+ */
+struct obd_t10_cksum_desc *obd_t10_cksum_init(cksum_type_t cksum_type)
+{
+	struct obd_t10_cksum_desc *desc;
+	int rc;
+
+	if (obd_t10_cksum_index(cksum_type) < 0)
+		return ERR_PTR(-EINVAL);
+
+	OBD_ALLOC_PTR(desc);
+	if (desc == NULL)
+		return ERR_PTR(-ENOMEM);
+
+	desc->otc_fn = obd_t10_cksum_fn(cksum_type);
+	if (desc->otc_fn == NULL)
+		GOTO(out_desc, rc = -EOPNOTSUPP);
+
+	desc->otc_sector_size = cksum_type_t10_sector_size(cksum_type);
+
+	OBD_ALLOC_LARGE(desc->otc_guards,
+			OBD_T10_GUARD_BUF * sizeof(*desc->otc_guards));
+	if (desc->otc_guards == NULL)
+		GOTO(out_desc, rc = -ENOMEM);
+
+	desc->otc_hdesc = cfs_crypto_hash_init(CFS_HASH_ALG_CRC32, NULL, 0);
+	if (IS_ERR(desc->otc_hdesc)) {
+		rc = PTR_ERR(desc->otc_hdesc);
+		GOTO(out_guards, rc);
+	}
+
+	return desc;
+
+out_guards:
+	OBD_FREE_LARGE(desc->otc_guards,
+		       OBD_T10_GUARD_BUF * sizeof(*desc->otc_guards));
+out_desc:
+	OBD_FREE_PTR(desc);
+	return ERR_PTR(rc);
+}
+EXPORT_SYMBOL(obd_t10_cksum_init);
+
+static int obd_t10_cksum_flush(struct obd_t10_cksum_desc *desc)
+{
+	int rc;
+
+	if (desc->otc_used == 0)
+		return 0;
+
+	rc = cfs_crypto_hash_update(desc->otc_hdesc, desc->otc_guards,
+				    desc->otc_used * sizeof(__u16));
+	desc->otc_used = 0;
+
+	return rc;
+}
+
+/**
+ * Compute the guard tags of \a frag into \a guards, which must have room
+ * for PAGE_SIZE / \a sector_size tags.
+ *
+ * \retval		number of guard tags computed
+ */
+static unsigned int obd_t10_frag_guards(obd_dif_csum_fn *fn,
+					unsigned int sector_size,
+					const struct obd_t10_frag *frag,
+					__u16 *guards)
+{
+	unsigned int offset = frag->otf_offset;
+	unsigned int end = offset + frag->otf_len;
+	unsigned int nr = 0;
+	char *addr = NULL;
+
+	LASSERT(end <= PAGE_SIZE);
+
+	while (offset < end) {
+		unsigned int chunk;
+		bool full;
+		__u16 guard;
+
+		chunk = min(end, (offset | (sector_size - 1)) + 1) - offset;
+		full = chunk == sector_size;
+
+		if (frag->otf_guards != NULL && frag->otf_reuse && full) {
+			guard = frag->otf_guards[offset / sector_size];
+		} else {
+			if (addr == NULL)
+				addr = kmap(frag->otf_page);
+			guard = fn(addr + offset, chunk);
+			if (frag->otf_guards != NULL && full)
+				frag->otf_guards[offset / sector_size] = guard;
+		}
+		guards[nr++] = guard;
+		offset += chunk;
+	}
+	if (addr != NULL)
+		kunmap(frag->otf_page);
+
+	return nr;
+}
+
+static int obd_t10_cksum_update_frag(struct obd_t10_cksum_desc *desc,
+				     const struct obd_t10_frag *frag)
+{
+	int rc = 0;
+
+	if (desc->otc_used + PAGE_SIZE / desc->otc_sector_size >
+	    OBD_T10_GUARD_BUF)
+		rc = obd_t10_cksum_flush(desc);
+	if (rc == 0)
+		desc->otc_used += obd_t10_frag_guards(desc->otc_fn,
+						      desc->otc_sector_size,
+						      frag, desc->otc_guards +
+							    desc->otc_used);
+	return rc;
+}
+
+/**
+ * Add the guard tags of a page fragment to the checksum.
+ *
+ * The fragment is split on sector boundaries (relative to the start of the
+ * page) so that the client and the server, which see the same page offsets
+ * and lengths in the niobufs, always compute the same guard tags. A short
+ * fragment gets a guard over the bytes actually present.
+ *
+ * \param[in] desc	descriptor from obd_t10_cksum_init()
+ * \param[in] page	page holding the data
+ * \param[in] offset	offset of the data within \a page
+ * \param[in] len	number of bytes to checksum
+ *
+ * \retval		0 on success
+ * \retval		negative errno on failure
+ */
+int obd_t10_cksum_update_page(struct obd_t10_cksum_desc *desc,
+			      struct page *page, unsigned int offset,
+			      unsigned int len)
+{
+	struct obd_t10_frag frag = {
+		.otf_page	= page,
+		.otf_offset	= offset,
+		.otf_len	= len,
+	};
+
+	return obd_t10_cksum_update_frag(desc, &frag);
+}
+EXPORT_SYMBOL(obd_t10_cksum_update_page);
+
+/**
+ * Same as obd_t10_cksum_update_page(), exchanging the guard tags of the
+ * full sectors with \a guards, which is indexed by sector within the page.
+ *
+ * If \a reuse is set, \a guards already holds valid tags (e.g. read from
+ * the storage integrity metadata) and the data of full sectors is not
+ * touched at all. Otherwise the computed tags of full sectors are saved
+ * in \a guards so that they can be handed to the storage.
+ */
+int obd_t10_cksum_update_guards(struct obd_t10_cksum_desc *desc,
+				struct page *page, unsigned int offset,
+				unsigned int len, __u16 *guards, bool reuse)
+{
+	struct obd_t10_frag frag = {
+		.otf_page	= page,
+		.otf_offset	= offset,
+		.otf_len	= len,
+		.otf_guards	= guards,
+		.otf_reuse	= reuse,
+	};
+
+	return obd_t10_cksum_update_frag(desc, &frag);
+}
+EXPORT_SYMBOL(obd_t10_cksum_update_guards);
+
+/*
+ * The guard tags of large RPCs are computed by the "obd_t10" workitem
+ * scheduler, OBD_T10_CHUNK_FRAGS fragments per workitem, the calling thread
+ * doing the first chunk itself. The guard arrays of the chunks are hashed in
+ * order afterwards, so the checksum is the same as the one computed by a
+ * single thread.
+ */
+static unsigned int obd_t10_parallel_kb = 4096;
+module_param(obd_t10_parallel_kb, uint, 0644);
+MODULE_PARM_DESC(obd_t10_parallel_kb, "Minimum RPC size in KB to compute the T10 checksum on several CPUs, 0 to disable");
+
+/* fragments (i.e. up to 256KB of data) handled by a single workitem */
+#define OBD_T10_CHUNK_FRAGS	max(1UL, 262144UL >> PAGE_SHIFT)
+/* maximum number of scheduler threads */
+#define OBD_T10_SCHED_THREADS	8
+
+static struct cfs_wi_sched *obd_t10_sched;
+/* scheduler could not be started, don't try again */
+static bool obd_t10_sched_failed;
+static DEFINE_MUTEX(obd_t10_sched_mutex);
+
+struct obd_t10_parallel {
+	obd_dif_csum_fn		*otp_fn;
+	unsigned int		 otp_sector_size;
+	obd_t10_frag_get_t	 otp_get;
+	void			*otp_data;
+	atomic_t		 otp_pending;
+	struct completion	 otp_done;
+};
+
+struct obd_t10_chunk {
+	struct cfs_workitem	 otk_wi;
+	struct obd_t10_parallel	*otk_par;
+	int			 otk_first;
+	int			 otk_count;
+	unsigned int		 otk_used;
+	__u16			*otk_guards;
+};
+
+static struct cfs_wi_sched *obd_t10_sched_get(void)
+{
+	struct cfs_wi_sched *sched;
+	int nthrs;
+	int rc;
+
+	sched = ACCESS_ONCE(obd_t10_sched);
+	if (sched != NULL || obd_t10_sched_failed)
+		return sched;
+
+	mutex_lock(&obd_t10_sched_mutex);
+	if (obd_t10_sched != NULL || obd_t10_sched_failed)
+		GOTO(out, sched = obd_t10_sched);
+
+	nthrs = min(cfs_cpt_weight(cfs_cpt_table, CFS_CPT_ANY),
+		    OBD_T10_SCHED_THREADS);
+	if (nthrs < 2) {
+		/* the caller is as good as a single helper thread */
+		obd_t10_sched_failed = true;
+		GOTO(out, sched = NULL);
+	}
+
+	rc = cfs_wi_sched_create("obd_t10", cfs_cpt_table, CFS_CPT_ANY,
+				 nthrs, &sched);
+	if (rc != 0) {
+		CWARN("cannot start T10 checksum threads, computing checksums serially: rc = %d\n",
+		      rc);
+		obd_t10_sched_failed = true;
+		GOTO(out, sched = NULL);
+	}
+	/* the scheduler must be set up before other threads can see it */
+	smp_wmb();
+	obd_t10_sched = sched;
+out:
+	mutex_unlock(&obd_t10_sched_mutex);
+
+	return sched;
+}
+
+static void obd_t10_chunk_guards(struct obd_t10_chunk *chunk)
+{
+	struct obd_t10_parallel *par = chunk->otk_par;
+	struct obd_t10_frag frag;
+	int i;
+
+	for (i = chunk->otk_first; i < chunk->otk_first + chunk->otk_count;
+	     i++) {
+		memset(&frag, 0, sizeof(frag));
+		par->otp_get(par->otp_data, i, &frag);
+		chunk->otk_used += obd_t10_frag_guards(par->otp_fn,
+						       par->otp_sector_size,
+						       &frag, chunk->otk_guards +
+							      chunk->otk_used);
+	}
+}
+
+static int obd_t10_chunk_action(struct cfs_workitem *wi)
+{
+	struct obd_t10_chunk *chunk = wi->wi_data;
+	struct obd_t10_parallel *par = chunk->otk_par;
+
+	obd_t10_chunk_guards(chunk);
+
+	/* the chunk is freed by the waiter once the last one is done */
+	cfs_wi_exit(obd_t10_sched, wi);
+	if (atomic_dec_and_test(&par->otp_pending))
+		complete(&par->otp_done);
+
+	return 1;
+}
+
+/**
+ * Add the guard tags of \a count page fragments to the checksum, in the same
+ * way as calling obd_t10_cksum_update_guards() on each of them in order.
+ *
+ * Fragments are described by \a get, which may be called from other threads
+ * and in any order, but only once for each fragment. If the fragments hold
+ * at least obd_t10_parallel_kb of data, the guard tags are computed on
+ * several CPUs.
+ *
+ * \param[in] desc	descriptor from obd_t10_cksum_init()
+ * \param[in] count	number of fragments
+ * \param[in] get	callback filling the description of fragment \a idx
+ * \param[in] data	opaque argument of \a get
+ *
+ * \retval		0 on success
+ * \retval		negative errno on failure
+ */
+int obd_t10_cksum_update_frags(struct obd_t10_cksum_desc *desc, int count,
+			       obd_t10_frag_get_t get, void *data)
+{
+	struct obd_t10_parallel par;
+	struct obd_t10_chunk *chunks = NULL;
+	struct cfs_wi_sched *sched = NULL;
+	struct obd_t10_frag frag;
+	__u16 *guards = NULL;
+	unsigned int per_chunk;
+	int nchunks;
+	int i;
+	int rc = 0;
+
+	nchunks = DIV_ROUND_UP(count, OBD_T10_CHUNK_FRAGS);
+	per_chunk = OBD_T10_CHUNK_FRAGS * (PAGE_SIZE / desc->otc_sector_size);
+
+	if (nchunks > 1 && obd_t10_parallel_kb != 0 &&
+	    ((unsigned long)count << (PAGE_SHIFT - 10)) >= obd_t10_parallel_kb)
+		sched = obd_t10_sched_get();
+	if (sched != NULL) {
+		OBD_ALLOC_LARGE(chunks, nchunks * sizeof(*chunks));
+		if (chunks != NULL)
+			OBD_ALLOC_LARGE(guards, nchunks * per_chunk *
+						sizeof(*guards));
+	}
+
+	if (guards == NULL) {
+		for (i = 0; i < count && rc == 0; i++) {
+			memset(&frag, 0, sizeof(frag));
+			get(data, i, &frag);
+			rc = obd_t10_cksum_update_frag(desc, &frag);
+		}
+		GOTO(out, rc);
+	}
+
+	par.otp_fn = desc->otc_fn;
+	par.otp_sector_size = desc->otc_sector_size;
+	par.otp_get = get;
+	par.otp_data = data;
+	atomic_set(&par.otp_pending, nchunks - 1);
+	init_completion(&par.otp_done);
+
+	for (i = 0; i < nchunks; i++) {
+		struct obd_t10_chunk *chunk = &chunks[i];
+
+		chunk->otk_par = &par;
+		chunk->otk_first = i * OBD_T10_CHUNK_FRAGS;
+		chunk->otk_count = min_t(int, count - chunk->otk_first,
+					 OBD_T10_CHUNK_FRAGS);
+		chunk->otk_used = 0;
+		chunk->otk_guards = guards + i * per_chunk;
+		if (i == 0)
+			continue;
+		cfs_wi_init(&chunk->otk_wi, chunk, obd_t10_chunk_action);
+		cfs_wi_schedule(sched, &chunk->otk_wi);
+	}
+	obd_t10_chunk_guards(&chunks[0]);
+	wait_for_completion(&par.otp_done);
+
+	rc = obd_t10_cksum_flush(desc);
+	for (i = 0; i < nchunks && rc == 0; i++)
+		rc = cfs_crypto_hash_update(desc->otc_hdesc,
+					    chunks[i].otk_guards,
+					    chunks[i].otk_used *
+					    sizeof(*guards));
+out:
+	if (guards != NULL)
+		OBD_FREE_LARGE(guards, nchunks * per_chunk * sizeof(*guards));
+	if (chunks != NULL)
+		OBD_FREE_LARGE(chunks, nchunks * sizeof(*chunks));
+
+	return rc;
+}
+EXPORT_SYMBOL(obd_t10_cksum_update_frags);
+
+/**
+ * Finish the checksum and release \a desc.
+ *
+ * \param[in] desc	descriptor from obd_t10_cksum_init()
+ * \param[out] cksum	resulting RPC checksum, may be NULL to just release
+ *			the descriptor
+ *
+ * \retval		0 on success
+ * \retval		negative errno on failure
+ */
+int obd_t10_cksum_final(struct obd_t10_cksum_desc *desc, __u32 *cksum)
+{
+	unsigned int bufsize = sizeof(*cksum);
+	int rc = 0;
+
+	if (cksum != NULL)
+		rc = obd_t10_cksum_flush(desc);
+
+	if (rc == 0 && cksum != NULL)
+		rc = cfs_crypto_hash_final(desc->otc_hdesc,
+					   (unsigned char *)cksum, &bufsize);
+	else
+		cfs_crypto_hash_final(desc->otc_hdesc, NULL, NULL);
+
+	OBD_FREE_LARGE(desc->otc_guards,
+		       OBD_T10_GUARD_BUF * sizeof(*desc->otc_guards));
+	OBD_FREE_PTR(desc);
+
+	return rc;
+}
+EXPORT_SYMBOL(obd_t10_cksum_final);
+
+/**
+ * Measure the speed of the given T10 checksum type, in the same way as
+ * libcfs does for the crypto hashes: checksum 1MB buffers for a while.
+ */
+static int obd_t10_performance_test(cksum_type_t cksum_type)
+{
+	int buf_len = max(PAGE_SIZE, 1048576UL);
+	unsigned long start, end;
+	struct page *page;
+	int bcount, rc = 0;
+	void *buf;
+	__u32 cksum;
+
+	page = alloc_page(GFP_KERNEL);
+	if (page == NULL)
+		return -ENOMEM;
+
+	buf = kmap(page);
+	memset(buf, 0xAD, PAGE_SIZE);
+	kunmap(page);
+
+	for (start = jiffies, end = start + msecs_to_jiffies(MSEC_PER_SEC / 4),
+	     bcount = 0; time_before(jiffies, end) && rc == 0; bcount++) {
+		struct obd_t10_cksum_desc *desc;
+		int i;
+
+		desc = obd_t10_cksum_init(cksum_type);
+		if (IS_ERR(desc)) {
+			rc = PTR_ERR(desc);
+			break;
+		}
+
+		for (i = 0; i < buf_len / PAGE_SIZE && rc == 0; i++)
+			rc = obd_t10_cksum_update_page(desc, page, 0,
+						       PAGE_SIZE);
+
+		if (rc == 0)
+			rc = obd_t10_cksum_final(desc, &cksum);
+		else
+			obd_t10_cksum_final(desc, NULL);
+	}
+	end = jiffies;
+	__free_page(page);
+
+	if (rc != 0) {
+		CDEBUG(D_INFO, "T10 checksum %x test error: rc = %d\n",
+		       cksum_type, rc);
+		return rc;
+	}
+
+	rc = ((bcount * buf_len / max(jiffies_to_msecs(end - start), 1U)) *
+	      1000) / (1024 * 1024);
+	CDEBUG(D_CONFIG, "T10 checksum %x speed = %d MB/s\n", cksum_type, rc);
+
+	/* never report 0, that means "not measured" */
+	return max(rc, 1);
+}
+
+static int obd_t10_speed_thread(void *arg)
+{
+	cksum_type_t t10;
+
+	for (t10 = OBD_CKSUM_T10IP512; t10 <= OBD_CKSUM_T10CRC4K; t10 <<= 1)
+		ACCESS_ONCE(obd_t10_cksum_speeds[obd_t10_cksum_index(t10)]) =
+			obd_t10_performance_test(t10);
+
+	complete(&obd_t10_speed_done);
+	return 0;
+}
+
+/**
+ * Measure the speed of all T10 checksum types once, in the background so
+ * that loading obdclass isn't delayed by about a second.
+ */
+void obd_t10_cksum_speed_init(void)
+{
+	struct task_struct *task;
+
+	task = kthread_run(obd_t10_speed_thread, NULL, "obd_t10_speed");
+	if (IS_ERR(task)) {
+		CWARN("cannot start T10 checksum benchmark thread, measuring now: rc = %ld\n",
+		      PTR_ERR(task));
+		obd_t10_speed_thread(NULL);
+	}
+}
+
+/**
+ * Speed of the T10 checksum type in MB/s, as measured when obdclass was
+ * loaded. This never blocks, so it can be called from ptlrpcd and request
+ * handlers.
+ *
+ * \param[in] cksum_type	one of the OBD_CKSUM_T10* types
+ *
+ * \retval			positive speed in MB/s
+ * \retval			0 if the speed is still being measured, the
+ *				type is then never preferred to another one
+ * \retval			negative errno if \a cksum_type is unusable
+ */
+int obd_t10_cksum_speed(cksum_type_t cksum_type)
+{
+	int idx = obd_t10_cksum_index(cksum_type);
+
+	if (idx < 0)
+		return idx;
+
+	return ACCESS_ONCE(obd_t10_cksum_speeds[idx]);
+}
+EXPORT_SYMBOL(obd_t10_cksum_speed);
+
+/**
+ * Whether the T10 checksum type can be computed on this node, without
+ * measuring its speed.
+ */
+bool obd_t10_cksum_available(cksum_type_t cksum_type)
+{
+	return obd_t10_cksum_index(cksum_type) >= 0 &&
+	       obd_t10_cksum_fn(cksum_type) != NULL;
+}
+EXPORT_SYMBOL(obd_t10_cksum_available);
+
+void obd_t10_cksum_fini(void)
+{
+	wait_for_completion(&obd_t10_speed_done);
+	if (obd_t10_sched != NULL) {
+		cfs_wi_sched_destroy(obd_t10_sched);
+		obd_t10_sched = NULL;
+	}
+}
@@ -69,6 +69,7 @@
 #include <libcfs/libcfs.h>
 #include <obd_support.h>
 #include <obd_class.h>
+#include <obd_cksum.h>
 #include <lnet/lnetctl.h>
 #include <lprocfs_status.h>
 #include <lustre_ioctl.h>
@@ -343,6 +344,23 @@ static ssize_t obd_proc_jobid_name_seq_write(struct file *file,
 }
 LPROC_SEQ_FOPS(obd_proc_jobid_name);
 
+/**
+ * Speed of every bulk checksum type in MB/s, negative if the type is not
+ * usable on this node. The T10 types are measured in the background when
+ * obdclass is loaded, and read as 0 until then.
+ */
+static int obd_proc_checksum_speed_seq_show(struct seq_file *m, void *v)
+{
+	DECLARE_CKSUM_NAME;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cksum_name); i++)
+		seq_printf(m, "%s: %d\n", cksum_name[i],
+			   obd_cksum_type_speed(1 << i));
+	return 0;
+}
+LPROC_SEQ_FOPS_RO(obd_proc_checksum_speed);
+
 /* Root for /proc/fs/lustre */
 struct proc_dir_entry *proc_lustre_root = NULL;
 EXPORT_SYMBOL(proc_lustre_root);
@@ -358,6 +376,8 @@ static struct lprocfs_vars lprocfs_base[] = {
 	  .fops	=	&obd_proc_jobid_var_fops},
 	{ .name =	"jobid_name",
 	  .fops =	&obd_proc_jobid_name_fops},
+	{ .name =	"checksum_speed",
+	  .fops =	&obd_proc_checksum_speed_fops	},
 	{ NULL }
 };
 #else
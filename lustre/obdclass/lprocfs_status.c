@@ -653,7 +653,7 @@ static const char *obd_connect_names[] = {
 	"disp_stripe",
 	"open_by_fid",
 	"lfsck",
-	"unknown",
+	"multiobj_brw",
 	"unlink_close",
 	"multi_mod_rpcs",
 	"dir_stripe",
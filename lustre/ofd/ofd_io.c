@@ -41,6 +41,7 @@
 #define DEBUG_SUBSYSTEM S_FILTER
 
 #include <linux/kthread.h>
+#include <obd_cksum.h>
 #include "ofd_internal.h"
 
 struct ofd_inconsistency_item {
@@ -416,6 +417,37 @@ int ofd_verify_ff(const struct lu_env *env, struct ofd_object *fo,
 	RETURN(-EINPROGRESS);
 }
 
+/**
+ * Mark local buffers whose guard tags can be exchanged with the OSD.
+ *
+ * If the client checksums the bulk with the same T10 type that the OSD
+ * keeps as integrity metadata on disk, the per-sector guard tags computed
+ * for the RPC checksum on write are handed down to the disk, and those
+ * read from the disk are used for the RPC checksum on read, so neither
+ * side has to run over the data a second time.
+ *
+ * \param[in] ofd	OFD device
+ * \param[in] oa	OBDO structure from client
+ * \param[in] lnb	local buffers
+ * \param[in] nr_local	number of local buffers
+ */
+static void ofd_lnb_guard_init(struct ofd_device *ofd, struct obdo *oa,
+			       struct niobuf_local *lnb, int nr_local)
+{
+	__u32 t10_type = ofd->ofd_dt_conf.ddp_t10_cksum_type;
+	bool want = false;
+	int i;
+
+	if (t10_type != 0 && oa->o_valid & OBD_MD_FLCKSUM)
+		want = cksum_type_unpack(oa->o_valid & OBD_MD_FLFLAGS ?
+					 oa->o_flags : 0) == t10_type;
+
+	for (i = 0; i < nr_local; i++) {
+		lnb[i].lnb_guard_want = want;
+		lnb[i].lnb_guard_valid = 0;
+	}
+}
+
 /**
  * Prepare buffers for read request processing.
  *
@@ -479,6 +511,8 @@ static int ofd_preprw_read(const struct lu_env *env, struct obd_export *exp,
 	}
 
 	LASSERT(*nr_local > 0 && *nr_local <= PTLRPC_MAX_BRW_PAGES);
+	ofd_lnb_guard_init(ofd, oa, lnb, *nr_local);
+
 	rc = dt_attr_get(env, ofd_object_child(fo), la);
 	if (unlikely(rc))
 		GOTO(buf_put, rc);
@@ -642,6 +676,7 @@ static int ofd_preprw_write(const struct lu_env *env, struct obd_export *exp,
 		tot_bytes += rnb[i].rnb_len;
 	}
 	LASSERT(*nr_local > 0 && *nr_local <= PTLRPC_MAX_BRW_PAGES);
+	ofd_lnb_guard_init(ofd, oa, lnb, *nr_local);
 
 	rc = dt_write_prep(env, ofd_object_child(fo), lnb, *nr_local);
 	if (unlikely(rc != 0))
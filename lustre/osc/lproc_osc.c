@@ -130,6 +130,44 @@ static ssize_t osc_max_rpcs_in_flight_seq_write(struct file *file,
 }
 LPROC_SEQ_FOPS(osc_max_rpcs_in_flight);
 
+static int osc_max_brw_objects_seq_show(struct seq_file *m, void *v)
+{
+	struct obd_device *dev = m->private;
+	struct client_obd *cli = &dev->u.cli;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	seq_printf(m, "%u\n", cli->cl_max_brw_objs);
+	spin_unlock(&cli->cl_loi_list_lock);
+	return 0;
+}
+
+/**
+ * Set how many objects a single OST_WRITE may carry. Setting this to 1
+ * disables multi-object write RPCs altogether.
+ */
+static ssize_t osc_max_brw_objects_seq_write(struct file *file,
+					     const char __user *buffer,
+					     size_t count, loff_t *off)
+{
+	struct obd_device *dev = ((struct seq_file *)file->private_data)->private;
+	struct client_obd *cli = &dev->u.cli;
+	int val, rc;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	if (val < 1 || val > PTLRPC_MAX_BRW_OBJS)
+		return -ERANGE;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	cli->cl_max_brw_objs = val;
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return count;
+}
+LPROC_SEQ_FOPS(osc_max_brw_objects);
+
 static int osc_max_dirty_mb_seq_show(struct seq_file *m, void *v)
 {
 	struct obd_device *dev = m->private;
@@ -627,6 +665,8 @@ struct lprocfs_vars lprocfs_osc_obd_vars[] = {
 	  .fops	=	&osc_obd_max_pages_per_rpc_fops	},
 	{ .name	=	"max_rpcs_in_flight",
 	  .fops	=	&osc_max_rpcs_in_flight_fops	},
+	{ .name	=	"max_brw_objects",
+	  .fops	=	&osc_max_brw_objects_fops	},
 	{ .name	=	"destroys_in_flight",
 	  .fops	=	&osc_destroys_in_flight_fops	},
 	{ .name	=	"max_dirty_mb",
@@ -690,6 +730,8 @@ static int osc_rpc_stats_seq_show(struct seq_file *seq, void *v)
 		   atomic_read(&cli->cl_pending_w_pages));
 	seq_printf(seq, "pending read pages:   %d\n",
 		   atomic_read(&cli->cl_pending_r_pages));
+	seq_printf(seq, "multi-object write RPCs: "LPU64" ("LPU64" objects)\n",
+		   cli->cl_w_multiobj_rpcs, cli->cl_w_multiobj_objs);
 
 	seq_printf(seq, "\n\t\t\tread\t\t\twrite\n");
 	seq_printf(seq, "pages per rpc         rpcs   %% cum %% |");
@@ -781,6 +823,11 @@ static ssize_t osc_rpc_stats_seq_write(struct file *file,
         lprocfs_oh_clear(&cli->cl_read_offset_hist);
         lprocfs_oh_clear(&cli->cl_write_offset_hist);
 
+	spin_lock(&cli->cl_loi_list_lock);
+	cli->cl_w_multiobj_rpcs = 0;
+	cli->cl_w_multiobj_objs = 0;
+	spin_unlock(&cli->cl_loi_list_lock);
+
         return len;
 }
 LPROC_SEQ_FOPS(osc_rpc_stats);
@@ -801,6 +848,14 @@ static int osc_stats_seq_show(struct seq_file *seq, void *v)
 		   stats->os_lockless_reads);
 	seq_printf(seq, "lockless_truncate\t\t"LPU64"\n",
 		   stats->os_lockless_truncates);
+	seq_printf(seq, "grant_cache_wait\t\t"LPU64"\n",
+		   stats->os_cache_waits);
+	seq_printf(seq, "sync_fallback_forced\t\t"LPU64"\n",
+		   stats->os_sync_forced);
+	seq_printf(seq, "sync_fallback_no_grant\t\t"LPU64"\n",
+		   stats->os_sync_no_grant);
+	seq_printf(seq, "sync_fallback_timeout\t\t"LPU64"\n",
+		   stats->os_sync_timeout);
 	return 0;
 }
 
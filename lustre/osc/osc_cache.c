@@ -1559,6 +1559,7 @@ static int osc_enter_cache(const struct lu_env *env, struct client_obd *cli,
 {
 	struct osc_object	*osc = oap->oap_obj;
 	struct lov_oinfo	*loi = osc->oo_oinfo;
+	struct osc_device	*od = lu2osc_dev(osc->oo_cl.co_lu.lo_dev);
 	struct osc_cache_waiter	 ocw;
 	struct l_wait_info	 lwi;
 	int			 rc = -EDQUOT;
@@ -1577,6 +1578,7 @@ static int osc_enter_cache(const struct lu_env *env, struct client_obd *cli,
 	    cli->cl_dirty_max_pages == 0 ||
 	    cli->cl_ar.ar_force_sync || loi->loi_ar.ar_force_sync) {
 		OSC_DUMP_GRANT(D_CACHE, cli, "forced sync i/o\n");
+		od->od_stats.os_sync_forced++;
 		GOTO(out, rc = -EDQUOT);
 	}
 
@@ -1595,6 +1597,8 @@ static int osc_enter_cache(const struct lu_env *env, struct client_obd *cli,
 	init_waitqueue_head(&ocw.ocw_waitq);
 	ocw.ocw_oap   = oap;
 	ocw.ocw_grant = bytes;
+	if (cli->cl_dirty_pages > 0 || cli->cl_w_in_flight > 0)
+		od->od_stats.os_cache_waits++;
 	while (cli->cl_dirty_pages > 0 || cli->cl_w_in_flight > 0) {
 		list_add_tail(&ocw.ocw_entry, &cli->cl_cache_waiters);
 		ocw.ocw_rc = 0;
@@ -1633,6 +1637,7 @@ static int osc_enter_cache(const struct lu_env *env, struct client_obd *cli,
 		OSC_DUMP_GRANT(D_CACHE, cli,
 			       "timeout, fall back to sync i/o\n");
 		osc_extent_tree_dump(D_CACHE, osc);
+		od->od_stats.os_sync_timeout++;
 		/* fall back to synchronous I/O */
 		rc = -EDQUOT;
 		break;
@@ -1644,6 +1649,7 @@ static int osc_enter_cache(const struct lu_env *env, struct client_obd *cli,
 	case -EDQUOT:
 		OSC_DUMP_GRANT(D_CACHE, cli,
 			       "no grant space, fall back to sync i/o\n");
+		od->od_stats.os_sync_no_grant++;
 		break;
 	default:
 		CDEBUG(D_CACHE, "%s: event for cache space @ %p never arrived "
@@ -1879,13 +1885,15 @@ static void osc_ap_completion(const struct lu_env *env, struct client_obd *cli,
 
 /**
  * Try to add extent to one RPC. We need to think about the following things:
- * - # of pages must not be over max_pages_per_rpc
+ * - # of pages must not be over max_pages_per_rpc, nor over \a limit if it
+ *   is not zero
  * - extent must be compatible with previous ones
  */
 static int try_to_add_extent_for_io(struct client_obd *cli,
 				    struct osc_extent *ext,
 				    struct list_head *rpclist,
-				    unsigned int *pc, unsigned int *max_pages)
+				    unsigned int *pc, unsigned int *max_pages,
+				    unsigned int limit)
 {
 	struct osc_extent *tmp;
 	struct osc_async_page *oap = list_first_entry(&ext->oe_pages,
@@ -1897,6 +1905,8 @@ static int try_to_add_extent_for_io(struct client_obd *cli,
 		ext);
 
 	*max_pages = max(ext->oe_mppr, *max_pages);
+	if (limit > 0 && *max_pages > limit)
+		*max_pages = limit;
 	if (*pc + ext->oe_nr_pages > *max_pages)
 		RETURN(0);
 
@@ -1944,22 +1954,28 @@ static int try_to_add_extent_for_io(struct client_obd *cli,
  * 4. If urgent list is not empty, goto 2;
  * 5. Traverse the extent tree from the 1st extent;
  * 6. Above steps exit if there is no space in this RPC.
+ *
+ * \a page_count pages are already in \a rpclist. If \a limit is not zero,
+ * the RPC is never filled beyond \a limit pages.
  */
 static unsigned int get_write_extents(struct osc_object *obj,
-				      struct list_head *rpclist)
+				      struct list_head *rpclist,
+				      unsigned int page_count,
+				      unsigned int limit)
 {
 	struct client_obd *cli = osc_cli(obj);
 	struct osc_extent *ext;
-	unsigned int page_count = 0;
 	unsigned int max_pages = cli->cl_max_pages_per_rpc;
 
 	LASSERT(osc_object_is_locked(obj));
+	if (limit > 0 && max_pages > limit)
+		max_pages = limit;
 	while (!list_empty(&obj->oo_hp_exts)) {
 		ext = list_entry(obj->oo_hp_exts.next, struct osc_extent,
 				 oe_link);
 		LASSERT(ext->oe_state == OES_CACHE);
 		if (!try_to_add_extent_for_io(cli, ext, rpclist, &page_count,
-					      &max_pages))
+					      &max_pages, limit))
 			return page_count;
 		EASSERT(ext->oe_nr_pages <= max_pages, ext);
 	}
@@ -1970,7 +1986,7 @@ static unsigned int get_write_extents(struct osc_object *obj,
 		ext = list_entry(obj->oo_urgent_exts.next,
 				 struct osc_extent, oe_link);
 		if (!try_to_add_extent_for_io(cli, ext, rpclist, &page_count,
-					      &max_pages))
+					      &max_pages, limit))
 			return page_count;
 
 		if (!ext->oe_intree)
@@ -1983,7 +1999,8 @@ static unsigned int get_write_extents(struct osc_object *obj,
 				continue;
 
 			if (!try_to_add_extent_for_io(cli, ext, rpclist,
-						      &page_count, &max_pages))
+						      &page_count, &max_pages,
+						      limit))
 				return page_count;
 		}
 	}
@@ -2000,7 +2017,7 @@ static unsigned int get_write_extents(struct osc_object *obj,
 		}
 
 		if (!try_to_add_extent_for_io(cli, ext, rpclist, &page_count,
-					      &max_pages))
+					      &max_pages, limit))
 			return page_count;
 
 		ext = next_extent(ext);
@@ -2008,6 +2025,189 @@ static unsigned int get_write_extents(struct osc_object *obj,
 	return page_count;
 }
 
+/**
+ * Move the extents of \a osc gathered for an RPC, which follow \a from in
+ * \a rpclist, into the state they are sent in. The object must be locked.
+ */
+static void osc_write_extents_prep(struct osc_object *osc,
+				   struct list_head *rpclist,
+				   struct list_head *from, unsigned int pages)
+{
+	struct osc_extent *ext;
+
+	LASSERT(osc_object_is_locked(osc));
+
+	osc_update_pending(osc, OBD_BRW_WRITE, -pages);
+
+	ext = list_entry(from->next, struct osc_extent, oe_link);
+	list_for_each_entry_from(ext, rpclist, oe_link) {
+		LASSERT(ext->oe_obj == osc);
+		LASSERT(ext->oe_state == OES_CACHE ||
+			ext->oe_state == OES_LOCK_DONE);
+		if (ext->oe_state == OES_CACHE)
+			osc_extent_state_set(ext, OES_LOCKING);
+		else
+			osc_extent_state_set(ext, OES_RPC);
+	}
+}
+
+static bool osc_rpclist_has_obj(struct list_head *rpclist,
+				struct osc_object *osc)
+{
+	struct osc_extent *ext;
+
+	list_for_each_entry(ext, rpclist, oe_link) {
+		if (ext->oe_obj == osc)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Get the owner of \a osc as it would be sent in a write RPC.
+ *
+ * Only the uid and gid are asked from the upper layers, which doesn't
+ * sleep, so this can be called under cl_loi_list_lock.
+ */
+static void osc_object_owner(const struct lu_env *env, struct osc_object *osc,
+			     __u32 *uid, __u32 *gid)
+{
+	struct osc_thread_info *info = osc_env_info(env);
+	struct cl_req_attr *attr = &info->oti_req_attr;
+	struct obdo *oa = &info->oti_oa;
+
+	memset(attr, 0, sizeof(*attr));
+	oa->o_valid = 0;
+	oa->o_uid = 0;
+	oa->o_gid = 0;
+	attr->cra_type = CRT_WRITE;
+	attr->cra_flags = OBD_MD_FLUID | OBD_MD_FLGID;
+	attr->cra_oa = oa;
+	cl_req_attr_set(env, osc2cl(osc), attr);
+	*uid = oa->o_uid;
+	*gid = oa->o_gid;
+}
+
+/**
+ * Add the dirty extents of other objects to a write RPC.
+ *
+ * Small files flushed together would otherwise cost one OST_WRITE each.
+ * When the OST understands OBD_CONNECT_MULTIOBJ_BRW, objects which are
+ * ready for writing and whose pending pages fit in the room left in the
+ * RPC are taken off the ready list and their extents appended to
+ * \a rpclist, object after object, so that the extents of one object stay
+ * next to each other in the RPC. Every object beyond the first one
+ * costs an obdo and an ioobj in the request, accounted here in niobufs
+ * so that the request still fits in OST_IO_MAXREQSIZE.
+ *
+ * The OST reports a single result for the whole RPC and the client
+ * completes all its extents with it, so only objects of the same owner
+ * are aggregated: a quota error of one user must not fail the writes of
+ * another one.
+ *
+ * \param[in] env		execution environment
+ * \param[in] cli		client obd
+ * \param[in] osc		object the RPC was built for, not locked
+ * \param[in] rpclist	extents of the RPC so far
+ * \param[in] page_count	pages in \a rpclist
+ *
+ * \retval		number of pages in \a rpclist
+ */
+static unsigned int osc_gather_write_objects(const struct lu_env *env,
+					     struct client_obd *cli,
+					     struct osc_object *osc,
+					     struct list_head *rpclist,
+					     unsigned int page_count)
+{
+	const unsigned int obj_cost =
+		DIV_ROUND_UP(sizeof(struct obdo) + sizeof(struct obd_ioobj),
+			     sizeof(struct niobuf_remote));
+	struct osc_extent *first;
+	struct osc_object *tmp;
+	unsigned int max_objs;
+	unsigned int nr_objs = 1;
+	__u32 uid;
+	__u32 gid;
+	ENTRY;
+
+	if (cli->cl_import == NULL || cli->cl_import->imp_invalid ||
+	    !(cli->cl_import->imp_connect_data.ocd_connect_flags &
+	      OBD_CONNECT_MULTIOBJ_BRW))
+		RETURN(page_count);
+
+	/* only writes under client locks are aggregated */
+	first = list_entry(rpclist->next, struct osc_extent, oe_link);
+	if (first->oe_srvlock || first->oe_no_merge)
+		RETURN(page_count);
+
+	osc_object_owner(env, osc, &uid, &gid);
+
+	spin_lock(&cli->cl_loi_list_lock);
+	max_objs = cli->cl_max_brw_objs;
+	while (nr_objs < max_objs) {
+		struct osc_object *next = NULL;
+		struct list_head *last;
+		unsigned int room;
+		unsigned int pages;
+
+		if (page_count + nr_objs * obj_cost >=
+		    cli->cl_max_pages_per_rpc)
+			break;
+		room = cli->cl_max_pages_per_rpc - page_count -
+		       nr_objs * obj_cost;
+
+		list_for_each_entry(tmp, &cli->cl_loi_ready_list,
+				    oo_ready_item) {
+			__u32 tuid;
+			__u32 tgid;
+
+			if (tmp == osc ||
+			    atomic_read(&tmp->oo_nr_writes) == 0 ||
+			    atomic_read(&tmp->oo_nr_writes) > room ||
+			    osc_rpclist_has_obj(rpclist, tmp))
+				continue;
+
+			osc_object_owner(env, tmp, &tuid, &tgid);
+			if (tuid == uid && tgid == gid) {
+				next = tmp;
+				break;
+			}
+		}
+		if (next == NULL)
+			break;
+
+		list_del_init(&next->oo_ready_item);
+		cl_object_get(osc2cl(next));
+		spin_unlock(&cli->cl_loi_list_lock);
+
+		last = rpclist->prev;
+		osc_object_lock(next);
+		pages = 0;
+		if (osc_makes_rpc(cli, next, OBD_BRW_WRITE))
+			pages = get_write_extents(next, rpclist, page_count,
+						  page_count + room) -
+				page_count;
+		if (pages > 0) {
+			osc_write_extents_prep(next, rpclist, last, pages);
+			page_count += pages;
+			nr_objs++;
+		}
+		osc_object_unlock(next);
+
+		osc_list_maint(cli, next);
+		cl_object_put(env, osc2cl(next));
+
+		/* incompatible extents, don't pick the same object again */
+		if (pages == 0)
+			RETURN(page_count);
+
+		spin_lock(&cli->cl_loi_list_lock);
+	}
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	RETURN(page_count);
+}
+
 static int
 osc_send_write_rpc(const struct lu_env *env, struct client_obd *cli,
 		   struct osc_object *osc)
@@ -2024,27 +2224,22 @@ __must_hold(osc)
 
 	LASSERT(osc_object_is_locked(osc));
 
-	page_count = get_write_extents(osc, &rpclist);
+	page_count = get_write_extents(osc, &rpclist, 0, 0);
 	LASSERT(equi(page_count == 0, list_empty(&rpclist)));
 
 	if (list_empty(&rpclist))
 		RETURN(0);
 
-	osc_update_pending(osc, OBD_BRW_WRITE, -page_count);
-
-	list_for_each_entry(ext, &rpclist, oe_link) {
-		LASSERT(ext->oe_state == OES_CACHE ||
-			ext->oe_state == OES_LOCK_DONE);
-		if (ext->oe_state == OES_CACHE)
-			osc_extent_state_set(ext, OES_LOCKING);
-		else
-			osc_extent_state_set(ext, OES_RPC);
-	}
+	osc_write_extents_prep(osc, &rpclist, &rpclist, page_count);
 
 	/* we're going to grab page lock, so release object lock because
 	 * lock order is page lock -> object lock. */
 	osc_object_unlock(osc);
 
+	if (cli->cl_max_brw_objs > 1 && page_count < cli->cl_max_pages_per_rpc)
+		page_count = osc_gather_write_objects(env, cli, osc, &rpclist,
+						      page_count);
+
 	list_for_each_entry_safe(ext, tmp, &rpclist, oe_link) {
 		if (ext->oe_state == OES_LOCKING) {
 			rc = osc_extent_make_ready(env, ext);
@@ -2100,7 +2295,7 @@ __must_hold(osc)
 				     &osc->oo_reading_exts, oe_link) {
 		EASSERT(ext->oe_state == OES_LOCK_DONE, ext);
 		if (!try_to_add_extent_for_io(cli, ext, &rpclist, &page_count,
-					      &max_pages))
+					      &max_pages, 0))
 			break;
 		osc_extent_state_set(ext, OES_RPC);
 		EASSERT(ext->oe_nr_pages <= max_pages, ext);
@@ -70,6 +70,8 @@ struct osc_io {
 			   oi_is_active:1;
 	/** how many LRU pages are reserved for this IO */
 	unsigned long	   oi_lru_reserved;
+	/** NUMA node the reserved LRU slots were taken from */
+	int		   oi_lru_nid;
 
 	/** active extents, we know how many bytes is going to be written,
 	 * so having an active extent will prevent it from being fragmented */
@@ -111,6 +113,8 @@ struct osc_thread_info {
 	pgoff_t			oti_fn_index; /* first non-overlapped index */
 	struct cl_sync_io	oti_anchor;
 	struct cl_req_attr	oti_req_attr;
+	/* owner lookup of write RPC aggregation */
+	struct obdo		oti_oa;
 	struct lu_buf		oti_ladvise_buf;
 };
 
@@ -362,6 +366,11 @@ struct osc_page {
 	 * Set if the page must be transferred with OBD_BRW_SRVLOCK.
 	 */
 			      ops_srvlock:1;
+	/**
+	 * NUMA node the LRU slot of this page was taken from, valid if
+	 * ops_in_lru is set.
+	 */
+	int			ops_lru_nid;
 	/**
 	 * lru page list. See osc_lru_{del|use}() in osc_page.c for usage.
 	 */
@@ -138,8 +138,9 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 		  struct list_head *ext_list, int cmd);
 long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 		   long target, bool force);
-unsigned long osc_lru_reserve(struct client_obd *cli, unsigned long npages);
-void osc_lru_unreserve(struct client_obd *cli, unsigned long npages);
+unsigned long osc_lru_reserve(struct client_obd *cli, unsigned long npages,
+			      int *nid);
+void osc_lru_unreserve(struct client_obd *cli, int nid, unsigned long npages);
 
 extern struct lu_kmem_descr osc_caches[];
 
@@ -187,6 +188,12 @@ struct osc_device {
                 uint64_t     os_lockless_writes;          /* by bytes */
                 uint64_t     os_lockless_reads;           /* by bytes */
                 uint64_t     os_lockless_truncates;       /* by times */
+		/* writers that slept in osc_enter_cache() for grant */
+		uint64_t     os_cache_waits;
+		/* writes that fell back to sync i/o, by reason */
+		uint64_t     os_sync_forced;
+		uint64_t     os_sync_no_grant;
+		uint64_t     os_sync_timeout;
         } od_stats;
 
         /* configuration item(s) */
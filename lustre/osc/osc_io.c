@@ -273,6 +273,8 @@ static int osc_io_commit_async(const struct lu_env *env,
 	struct cl_page  *page;
 	struct cl_page  *last_page;
 	struct osc_page *opg;
+	pgoff_t		 touch_idx = 0;
+	size_t		 touch_to = 0;
 	int result = 0;
 	ENTRY;
 
@@ -313,8 +315,12 @@ static int osc_io_commit_async(const struct lu_env *env,
 				break;
 		}
 
-		osc_page_touch_at(env, osc2cl(osc), osc_index(opg),
-				  page == last_page ? to : PAGE_SIZE);
+		/* remember the furthest byte written, the attributes are
+		 * updated once for the whole queue below */
+		if (touch_to == 0 || osc_index(opg) >= touch_idx) {
+			touch_idx = osc_index(opg);
+			touch_to = page == last_page ? to : PAGE_SIZE;
+		}
 
 		cl_page_list_del(env, qin, page);
 
@@ -323,6 +329,12 @@ static int osc_io_commit_async(const struct lu_env *env,
 		 * complete at any time. */
 	}
 
+	/* KMS, size and [mc]time only depend on the last page, taking the
+	 * attribute lock and walking the layers once per page would cost a
+	 * lot for large writes */
+	if (touch_to != 0)
+		osc_page_touch_at(env, osc2cl(osc), touch_idx, touch_to);
+
 	/* for sync write, kernel will wait for this page to be flushed before
 	 * osc_io_end() is called, so release it earlier.
 	 * for mkwrite(), it's known there is no further pages. */
@@ -371,7 +383,8 @@ static int osc_io_write_iter_init(const struct lu_env *env,
 	if (io->u.ci_rw.crw_pos & ~PAGE_MASK)
 		++npages;
 
-	oio->oi_lru_reserved = osc_lru_reserve(osc_cli(osc), npages);
+	oio->oi_lru_reserved = osc_lru_reserve(osc_cli(osc), npages,
+					       &oio->oi_lru_nid);
 
 	RETURN(osc_io_iter_init(env, ios));
 }
@@ -398,7 +411,8 @@ static void osc_io_write_iter_fini(const struct lu_env *env,
 	struct osc_object *osc = cl2osc(ios->cis_obj);
 
 	if (oio->oi_lru_reserved > 0) {
-		osc_lru_unreserve(osc_cli(osc), oio->oi_lru_reserved);
+		osc_lru_unreserve(osc_cli(osc), oio->oi_lru_nid,
+				  oio->oi_lru_reserved);
 		oio->oi_lru_reserved = 0;
 	}
 	oio->oi_write_osclock = NULL;
@@ -459,10 +459,16 @@ void osc_page_submit(const struct lu_env *env, struct osc_page *opg,
 /* OSC is a natural place to manage LRU pages as applications are specialized
  * to write OSC by OSC. Ideally, if one OSC is used more frequently it should
  * occupy more LRU slots. On the other hand, we should avoid using up all LRU
- * slots (client_obd::cl_lru_left) otherwise process has to be put into sleep
- * for free LRU slots - this will be very bad so the algorithm requires each
- * OSC to free slots voluntarily to maintain a reasonable number of free slots
- * at any time.
+ * slots (cl_client_cache::ccc_nodes) otherwise process has to be put into
+ * sleep for free LRU slots - this will be very bad so the algorithm requires
+ * each OSC to free slots voluntarily to maintain a reasonable number of free
+ * slots at any time.
+ *
+ * Both the LRU slots and the LRU lists are split by NUMA node: slots are
+ * taken from the node of the IO thread and returned to the node they were
+ * taken from (osc_page::ops_lru_nid), and pages are kept on the list of the
+ * node they live on, so that a reclaiming thread drops pages of its own node
+ * first.
  */
 
 static DECLARE_WAIT_QUEUE_HEAD(osc_lru_waitq);
@@ -502,7 +508,7 @@ static int osc_cache_too_much(struct client_obd *cli)
 
 	/* if it's going to run out LRU slots, we should free some, but not
 	 * too much to maintain faireness among OSCs. */
-	if (atomic_long_read(cli->cl_lru_left) < cache->ccc_lru_max >> 2) {
+	if (cl_cache_lru_left_approx(cache) < cache->ccc_lru_max >> 2) {
 		if (pages >= budget)
 			return lru_shrink_max(cli);
 		else if (pages >= budget / 2)
@@ -539,40 +545,78 @@ int lru_queue_work(const struct lu_env *env, void *data)
 	RETURN(0);
 }
 
+static inline int osc_page_nid(struct osc_page *opg)
+{
+	return page_to_nid(cl_page_vmpage(opg->ops_cl.cpl_page));
+}
+
+static inline struct client_lru_node *osc_lru_node(struct client_obd *cli,
+						   struct osc_page *opg)
+{
+	return &cli->cl_lru_nodes[osc_page_nid(opg)];
+}
+
+static void osc_lru_node_add(struct client_obd *cli, int nid,
+			     struct list_head *lru, long npages)
+{
+	struct client_lru_node *cln = &cli->cl_lru_nodes[nid];
+
+	spin_lock(&cln->cln_lock);
+	list_splice_tail_init(lru, &cln->cln_list);
+	atomic_long_add(npages, &cln->cln_in_list);
+	spin_unlock(&cln->cln_lock);
+}
+
 void osc_lru_add_batch(struct client_obd *cli, struct list_head *plist)
 {
 	struct list_head lru = LIST_HEAD_INIT(lru);
 	struct osc_async_page *oap;
 	long npages = 0;
+	long total = 0;
+	int nid = NUMA_NO_NODE;
 
+	/* pages of an RPC are mostly on the same node, so splice the runs of
+	 * pages from one node at once */
 	list_for_each_entry(oap, plist, oap_pending_item) {
 		struct osc_page *opg = oap2osc_page(oap);
 
 		if (!opg->ops_in_lru)
 			continue;
 
+		if (osc_page_nid(opg) != nid) {
+			if (npages > 0)
+				osc_lru_node_add(cli, nid, &lru, npages);
+			nid = osc_page_nid(opg);
+			total += npages;
+			npages = 0;
+		}
+
 		++npages;
 		LASSERT(list_empty(&opg->ops_lru));
-		list_add(&opg->ops_lru, &lru);
+		list_add_tail(&opg->ops_lru, &lru);
 	}
 
 	if (npages > 0) {
-		spin_lock(&cli->cl_lru_list_lock);
-		list_splice_tail(&lru, &cli->cl_lru_list);
-		atomic_long_sub(npages, &cli->cl_lru_busy);
-		atomic_long_add(npages, &cli->cl_lru_in_list);
+		osc_lru_node_add(cli, nid, &lru, npages);
+		total += npages;
+	}
+
+	if (total > 0) {
+		atomic_long_sub(total, &cli->cl_lru_busy);
+		atomic_long_add(total, &cli->cl_lru_in_list);
 		cli->cl_lru_last_used = cfs_time_current_sec();
-		spin_unlock(&cli->cl_lru_list_lock);
 
 		if (waitqueue_active(&osc_lru_waitq))
 			(void)ptlrpcd_queue_work(cli->cl_lru_work);
 	}
 }
 
-static void __osc_lru_del(struct client_obd *cli, struct osc_page *opg)
+static void __osc_lru_del(struct client_obd *cli, struct client_lru_node *cln,
+			  struct osc_page *opg)
 {
-	LASSERT(atomic_long_read(&cli->cl_lru_in_list) > 0);
+	LASSERT(atomic_long_read(&cln->cln_in_list) > 0);
 	list_del_init(&opg->ops_lru);
+	atomic_long_dec(&cln->cln_in_list);
 	atomic_long_dec(&cli->cl_lru_in_list);
 }
 
@@ -583,16 +627,18 @@ static void __osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 static void osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 {
 	if (opg->ops_in_lru) {
-		spin_lock(&cli->cl_lru_list_lock);
+		struct client_lru_node *cln = osc_lru_node(cli, opg);
+
+		spin_lock(&cln->cln_lock);
 		if (!list_empty(&opg->ops_lru)) {
-			__osc_lru_del(cli, opg);
+			__osc_lru_del(cli, cln, opg);
 		} else {
 			LASSERT(atomic_long_read(&cli->cl_lru_busy) > 0);
 			atomic_long_dec(&cli->cl_lru_busy);
 		}
-		spin_unlock(&cli->cl_lru_list_lock);
+		spin_unlock(&cln->cln_lock);
 
-		atomic_long_inc(cli->cl_lru_left);
+		cl_cache_lru_give(cli->cl_cache, opg->ops_lru_nid, 1);
 		/* this is a great place to release more LRU pages if
 		 * this osc occupies too many LRU pages and kernel is
 		 * stealing one of them. */
@@ -614,9 +660,11 @@ static void osc_lru_use(struct client_obd *cli, struct osc_page *opg)
 	/* If page is being transferred for the first time,
 	 * ops_lru should be empty */
 	if (opg->ops_in_lru && !list_empty(&opg->ops_lru)) {
-		spin_lock(&cli->cl_lru_list_lock);
-		__osc_lru_del(cli, opg);
-		spin_unlock(&cli->cl_lru_list_lock);
+		struct client_lru_node *cln = osc_lru_node(cli, opg);
+
+		spin_lock(&cln->cln_lock);
+		__osc_lru_del(cli, cln, opg);
+		spin_unlock(&cln->cln_lock);
 		atomic_long_inc(&cli->cl_lru_busy);
 	}
 }
@@ -662,47 +710,34 @@ static inline bool lru_page_busy(struct client_obd *cli, struct cl_page *page)
 }
 
 /**
- * Drop @target of pages from LRU at most.
+ * Drop @target of pages from the LRU list of node \a nid at most.
  */
-long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
-		   long target, bool force)
+static long osc_lru_shrink_node(const struct lu_env *env,
+				struct client_obd *cli, int nid,
+				long target, bool force)
 {
+	struct client_lru_node *cln = &cli->cl_lru_nodes[nid];
 	struct cl_io *io;
 	struct cl_object *clobj = NULL;
 	struct cl_page **pvec;
 	struct osc_page *opg;
 	long count = 0;
+	long give = 0;
+	int give_nid = NUMA_NO_NODE;
 	int maxscan = 0;
 	int index = 0;
 	int rc = 0;
 	ENTRY;
 
-	LASSERT(atomic_long_read(&cli->cl_lru_in_list) >= 0);
-	if (atomic_long_read(&cli->cl_lru_in_list) == 0 || target <= 0)
+	if (atomic_long_read(&cln->cln_in_list) == 0)
 		RETURN(0);
 
-	CDEBUG(D_CACHE, "%s: shrinkers: %d, force: %d\n",
-	       cli_name(cli), atomic_read(&cli->cl_lru_shrinkers), force);
-	if (!force) {
-		if (atomic_read(&cli->cl_lru_shrinkers) > 0)
-			RETURN(-EBUSY);
-
-		if (atomic_inc_return(&cli->cl_lru_shrinkers) > 1) {
-			atomic_dec(&cli->cl_lru_shrinkers);
-			RETURN(-EBUSY);
-		}
-	} else {
-		atomic_inc(&cli->cl_lru_shrinkers);
-	}
-
 	pvec = (struct cl_page **)osc_env_info(env)->oti_pvec;
 	io = &osc_env_info(env)->oti_io;
 
-	spin_lock(&cli->cl_lru_list_lock);
-	if (force)
-		cli->cl_lru_reclaim++;
-	maxscan = min(target << 1, atomic_long_read(&cli->cl_lru_in_list));
-	while (!list_empty(&cli->cl_lru_list)) {
+	spin_lock(&cln->cln_lock);
+	maxscan = min(target << 1, atomic_long_read(&cln->cln_in_list));
+	while (!list_empty(&cln->cln_list)) {
 		struct cl_page *page;
 		bool will_free = false;
 
@@ -712,11 +747,11 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 		if (--maxscan < 0)
 			break;
 
-		opg = list_entry(cli->cl_lru_list.next, struct osc_page,
+		opg = list_entry(cln->cln_list.next, struct osc_page,
 				 ops_lru);
 		page = opg->ops_cl.cpl_page;
 		if (lru_page_busy(cli, page)) {
-			list_move_tail(&opg->ops_lru, &cli->cl_lru_list);
+			list_move_tail(&opg->ops_lru, &cln->cln_list);
 			continue;
 		}
 
@@ -725,7 +760,7 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 			struct cl_object *tmp = page->cp_obj;
 
 			cl_object_get(tmp);
-			spin_unlock(&cli->cl_lru_list_lock);
+			spin_unlock(&cln->cln_lock);
 
 			if (clobj != NULL) {
 				discard_pagevec(env, io, pvec, index);
@@ -741,7 +776,7 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 			io->ci_ignore_layout = 1;
 			rc = cl_io_init(env, io, CIT_MISC, clobj);
 
-			spin_lock(&cli->cl_lru_list_lock);
+			spin_lock(&cln->cln_lock);
 
 			if (rc != 0)
 				break;
@@ -754,9 +789,22 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 			if (!lru_page_busy(cli, page)) {
 				/* remove it from lru list earlier to avoid
 				 * lock contention */
-				__osc_lru_del(cli, opg);
+				__osc_lru_del(cli, cln, opg);
 				opg->ops_in_lru = 0; /* will be discarded */
 
+				/* the slot goes back to the node it was taken
+				 * from, which is usually the same for a run of
+				 * pages */
+				if (opg->ops_lru_nid != give_nid) {
+					if (give > 0)
+						cl_cache_lru_give(cli->cl_cache,
+								  give_nid,
+								  give);
+					give_nid = opg->ops_lru_nid;
+					give = 0;
+				}
+				give++;
+
 				cl_page_get(page);
 				will_free = true;
 			} else {
@@ -765,24 +813,24 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 		}
 
 		if (!will_free) {
-			list_move_tail(&opg->ops_lru, &cli->cl_lru_list);
+			list_move_tail(&opg->ops_lru, &cln->cln_list);
 			continue;
 		}
 
-		/* Don't discard and free the page with cl_lru_list held */
+		/* Don't discard and free the page with cln_lock held */
 		pvec[index++] = page;
 		if (unlikely(index == OTI_PVEC_SIZE)) {
-			spin_unlock(&cli->cl_lru_list_lock);
+			spin_unlock(&cln->cln_lock);
 			discard_pagevec(env, io, pvec, index);
 			index = 0;
 
-			spin_lock(&cli->cl_lru_list_lock);
+			spin_lock(&cln->cln_lock);
 		}
 
 		if (++count >= target)
 			break;
 	}
-	spin_unlock(&cli->cl_lru_list_lock);
+	spin_unlock(&cln->cln_lock);
 
 	if (clobj != NULL) {
 		discard_pagevec(env, io, pvec, index);
@@ -791,11 +839,65 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 		cl_object_put(env, clobj);
 	}
 
+	if (give > 0)
+		cl_cache_lru_give(cli->cl_cache, give_nid, give);
+	if (count > 0)
+		atomic_long_add(count,
+				&cli->cl_cache->ccc_nodes[nid].ccn_reclaimed);
+	RETURN(count > 0 ? count : rc);
+}
+
+/**
+ * Drop @target of pages from LRU at most. The LRU list of the local NUMA
+ * node is scanned first so that a reclaiming thread frees memory close to
+ * itself, the lists of the other nodes only when that is not enough.
+ */
+long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
+		   long target, bool force)
+{
+	long count = 0;
+	int local = numa_node_id();
+	int nid;
+	int rc = 0;
+	ENTRY;
+
+	LASSERT(atomic_long_read(&cli->cl_lru_in_list) >= 0);
+	if (atomic_long_read(&cli->cl_lru_in_list) == 0 || target <= 0)
+		RETURN(0);
+
+	CDEBUG(D_CACHE, "%s: shrinkers: %d, force: %d\n",
+	       cli_name(cli), atomic_read(&cli->cl_lru_shrinkers), force);
+	if (!force) {
+		if (atomic_read(&cli->cl_lru_shrinkers) > 0)
+			RETURN(-EBUSY);
+
+		if (atomic_inc_return(&cli->cl_lru_shrinkers) > 1) {
+			atomic_dec(&cli->cl_lru_shrinkers);
+			RETURN(-EBUSY);
+		}
+	} else {
+		atomic_inc(&cli->cl_lru_shrinkers);
+		cli->cl_lru_reclaim++;
+	}
+
+	rc = osc_lru_shrink_node(env, cli, local, target, force);
+	if (rc > 0)
+		count = rc;
+
+	for_each_online_node(nid) {
+		if (count >= target || rc < 0)
+			break;
+		if (nid == local)
+			continue;
+
+		rc = osc_lru_shrink_node(env, cli, nid, target - count, force);
+		if (rc > 0)
+			count += rc;
+	}
+
 	atomic_dec(&cli->cl_lru_shrinkers);
-	if (count > 0) {
-		atomic_long_add(count, cli->cl_lru_left);
+	if (count > 0)
 		wake_up_all(&osc_lru_waitq);
-	}
 	RETURN(count > 0 ? count : rc);
 }
 
@@ -897,11 +999,13 @@ static int osc_lru_alloc(const struct lu_env *env, struct client_obd *cli,
 
 	if (oio->oi_lru_reserved > 0) {
 		--oio->oi_lru_reserved;
+		opg->ops_lru_nid = oio->oi_lru_nid;
 		goto out;
 	}
 
-	LASSERT(atomic_long_read(cli->cl_lru_left) >= 0);
-	while (!atomic_long_add_unless(cli->cl_lru_left, -1, 0)) {
+	/* take the slot from the node the page was allocated on first */
+	opg->ops_lru_nid = osc_page_nid(opg);
+	while (cl_cache_lru_take(cli->cl_cache, &opg->ops_lru_nid, 1) == 0) {
 		/* run out of LRU spaces, try to drop some by itself */
 		rc = osc_lru_reclaim(cli, 1);
 		if (rc < 0)
@@ -911,7 +1015,7 @@ static int osc_lru_alloc(const struct lu_env *env, struct client_obd *cli,
 
 		cond_resched();
 		rc = l_wait_event(osc_lru_waitq,
-				atomic_long_read(cli->cl_lru_left) > 0,
+				cl_cache_lru_left(cli->cl_cache) > 0,
 				&lwi);
 		if (rc < 0)
 			break;
@@ -930,14 +1034,19 @@ out:
 /**
  * osc_lru_reserve() is called to reserve enough LRU slots for I/O.
  *
- * The benefit of doing this is to reduce contention against atomic counter
- * cl_lru_left by changing it from per-page access to per-IO access.
+ * The benefit of doing this is to reduce contention against the atomic
+ * counters of cl_client_cache::ccc_nodes by changing it from per-page access
+ * to per-IO access. The slots are taken from the node of the IO thread, as
+ * this is where the page cache allocates the pages of the IO, or else from
+ * another single node which is returned in \a nid.
  */
-unsigned long osc_lru_reserve(struct client_obd *cli, unsigned long npages)
+unsigned long osc_lru_reserve(struct client_obd *cli, unsigned long npages,
+			      int *nid)
 {
+	struct cl_client_cache *cache = cli->cl_cache;
 	unsigned long reserved = 0;
 	unsigned long max_pages;
-	unsigned long c;
+	long left;
 
 	/* reserve a full RPC window at most to avoid that a thread accidentally
 	 * consumes too many LRU slots */
@@ -945,23 +1054,18 @@ unsigned long osc_lru_reserve(struct client_obd *cli, unsigned long npages)
 	if (npages > max_pages)
 		npages = max_pages;
 
-	c = atomic_long_read(cli->cl_lru_left);
-	if (c < npages && osc_lru_reclaim(cli, npages) > 0)
-		c = atomic_long_read(cli->cl_lru_left);
-	while (c >= npages) {
-		if (c == atomic_long_cmpxchg(cli->cl_lru_left, c, c - npages)) {
-			reserved = npages;
-			break;
-		}
-		c = atomic_long_read(cli->cl_lru_left);
-	}
-	if (atomic_long_read(cli->cl_lru_left) < max_pages) {
+	*nid = NUMA_NO_NODE;
+	reserved = cl_cache_lru_take(cache, nid, npages);
+	if (reserved == 0 && osc_lru_reclaim(cli, npages) > 0)
+		reserved = cl_cache_lru_take(cache, nid, npages);
+
+	left = cl_cache_lru_left(cache);
+	if (left < max_pages) {
 		/* If there aren't enough pages in the per-OSC LRU then
 		 * wake up the LRU thread to try and clear out space, so
 		 * we don't block if pages are being dirtied quickly. */
-		CDEBUG(D_CACHE, "%s: queue LRU, left: %lu/%ld.\n",
-		       cli_name(cli), atomic_long_read(cli->cl_lru_left),
-		       max_pages);
+		CDEBUG(D_CACHE, "%s: queue LRU, left: %ld/%ld.\n",
+		       cli_name(cli), left, max_pages);
 		(void)ptlrpcd_queue_work(cli->cl_lru_work);
 	}
 
@@ -973,11 +1077,12 @@ unsigned long osc_lru_reserve(struct client_obd *cli, unsigned long npages)
  *
  * LRU slots reserved by osc_lru_reserve() may have entries left due to several
  * reasons such as page already existing or I/O error. Those reserved slots
- * should be freed by calling this function.
+ * should be freed by calling this function, with the node returned by
+ * osc_lru_reserve().
  */
-void osc_lru_unreserve(struct client_obd *cli, unsigned long npages)
+void osc_lru_unreserve(struct client_obd *cli, int nid, unsigned long npages)
 {
-	atomic_long_add(npages, cli->cl_lru_left);
+	cl_cache_lru_give(cli->cl_cache, nid, npages);
 	wake_up_all(&osc_lru_waitq);
 }
 
@@ -66,10 +66,13 @@ module_param(osc_reqpool_mem_max, uint, 0444);
 
 struct osc_brw_async_args {
 	struct obdo		 *aa_oa;
+	/* obdos of the 2nd and following objects of a multi-object write */
+	struct obdo		 *aa_xoa;
 	int			  aa_requested_nob;
 	int			  aa_nio_count;
 	u32			  aa_page_count;
 	int			  aa_resends;
+	u32			  aa_obj_count;
 	struct brw_page	**aa_ppga;
 	struct client_obd	 *aa_cli;
 	struct list_head	  aa_oaps;
@@ -711,6 +714,22 @@ static void osc_announce_cached(struct client_obd *cli, struct obdo *oa,
 			nrextents = (nrpages + cli->cl_max_extent_pages - 1)  /
 				     cli->cl_max_extent_pages;
 			oa->o_undirty += nrextents * cli->cl_grant_extent_tax;
+
+			/* small or sparse writes pay a whole chunk and an
+			 * extent tax for only a few pages, so the estimate
+			 * above is far too low for them. Size the request on
+			 * the grant really consumed per dirty page if that is
+			 * higher, so that such workloads are not starved of
+			 * grant and pushed to sync i/o. The OST ignores any
+			 * request above 2GB. */
+			if (cli->cl_dirty_pages > 0) {
+				u64 want = (u64)nrpages * cli->cl_dirty_grant;
+
+				do_div(want, cli->cl_dirty_pages);
+				want = min_t(u64, want, 0x7fffffff);
+				if (want > oa->o_undirty)
+					oa->o_undirty = want;
+			}
 		}
         }
 	oa->o_grant = cli->cl_avail_grant + cli->cl_reserved_grant;
@@ -1061,39 +1080,98 @@ static inline int can_merge_pages(struct brw_page *p1, struct brw_page *p2)
         return (p1->off + p1->count == p2->off);
 }
 
+/* does page \a i of a multi-object write start another object */
+static inline bool brw_obj_boundary(struct brw_page **pga, u32 i,
+				    u32 obj_count)
+{
+	return obj_count > 1 && i > 0 &&
+	       brw_page2oap(pga[i - 1])->oap_obj !=
+	       brw_page2oap(pga[i])->oap_obj;
+}
+
+struct osc_t10_frags {
+	struct brw_page	**otf_pga;
+	int		  otf_count;
+	/* bytes of the last page that are actually in the bulk */
+	unsigned int	  otf_last_len;
+};
+
+static void osc_t10_frag_get(void *data, int idx, struct obd_t10_frag *frag)
+{
+	struct osc_t10_frags *frags = data;
+	struct brw_page *pg = frags->otf_pga[idx];
+
+	frag->otf_page = pg->pg;
+	frag->otf_offset = pg->off & ~PAGE_MASK;
+	frag->otf_len = idx == frags->otf_count - 1 ? frags->otf_last_len :
+						       pg->count;
+}
+
 static u32 osc_checksum_bulk(int nob, size_t pg_count,
 			     struct brw_page **pga, int opc,
 			     cksum_type_t cksum_type)
 {
 	u32				cksum;
 	int				i = 0;
-	struct cfs_crypto_hash_desc	*hdesc;
+	struct cfs_crypto_hash_desc	*hdesc = NULL;
+	struct obd_t10_cksum_desc	*t10 = NULL;
 	unsigned int			bufsize;
 	int				err;
 	unsigned char			cfs_alg = cksum_obd2cfs(cksum_type);
 
 	LASSERT(pg_count > 0);
 
-	hdesc = cfs_crypto_hash_init(cfs_alg, NULL, 0);
-	if (IS_ERR(hdesc)) {
-		CERROR("Unable to initialize checksum hash %s\n",
-		       cfs_crypto_hash_name(cfs_alg));
-		return PTR_ERR(hdesc);
+	if (cksum_type_is_t10(cksum_type)) {
+		t10 = obd_t10_cksum_init(cksum_type);
+		if (IS_ERR(t10)) {
+			CERROR("Unable to initialize T10 checksum %x\n",
+			       cksum_type);
+			return PTR_ERR(t10);
+		}
+	} else {
+		hdesc = cfs_crypto_hash_init(cfs_alg, NULL, 0);
+		if (IS_ERR(hdesc)) {
+			CERROR("Unable to initialize checksum hash %s\n",
+			       cfs_crypto_hash_name(cfs_alg));
+			return PTR_ERR(hdesc);
+		}
+	}
+
+	/* corrupt the data before we compute the checksum, to
+	 * simulate an OST->client data error */
+	if (opc == OST_READ &&
+	    OBD_FAIL_CHECK(OBD_FAIL_OSC_CHECKSUM_RECEIVE)) {
+		unsigned char *ptr = kmap(pga[0]->pg);
+		int off = pga[0]->off & ~PAGE_MASK;
+
+		memcpy(ptr + off, "bad1", min_t(typeof(nob), 4, nob));
+		kunmap(pga[0]->pg);
+	}
+
+	if (t10 != NULL) {
+		struct osc_t10_frags frags = { .otf_pga = pga };
+		int left = nob;
+
+		/* only the last page can be partially in the bulk */
+		while (left > 0 && pg_count > 0) {
+			frags.otf_last_len = min_t(int, pga[i]->count, left);
+			left -= pga[i]->count;
+			pg_count--;
+			i++;
+		}
+		frags.otf_count = i;
+		err = obd_t10_cksum_update_frags(t10, frags.otf_count,
+						 osc_t10_frag_get, &frags);
+		if (err == 0)
+			err = obd_t10_cksum_final(t10, &cksum);
+		else
+			obd_t10_cksum_final(t10, NULL);
+		GOTO(out, err);
 	}
 
 	while (nob > 0 && pg_count > 0) {
 		unsigned int count = pga[i]->count > nob ? nob : pga[i]->count;
 
-		/* corrupt the data before we compute the checksum, to
-		 * simulate an OST->client data error */
-		if (i == 0 && opc == OST_READ &&
-		    OBD_FAIL_CHECK(OBD_FAIL_OSC_CHECKSUM_RECEIVE)) {
-			unsigned char *ptr = kmap(pga[i]->pg);
-			int off = pga[i]->off & ~PAGE_MASK;
-
-			memcpy(ptr + off, "bad1", min_t(typeof(nob), 4, nob));
-			kunmap(pga[i]->pg);
-		}
 		cfs_crypto_hash_update_page(hdesc, pga[i]->pg,
 					    pga[i]->off & ~PAGE_MASK,
 					    count);
@@ -1107,7 +1185,7 @@ static u32 osc_checksum_bulk(int nob, size_t pg_count,
 
 	bufsize = sizeof(cksum);
 	err = cfs_crypto_hash_final(hdesc, (unsigned char *)&cksum, &bufsize);
-
+out:
 	/* For sending we only compute the wrong checksum instead
 	 * of corrupting the data so it is still correct on a redo */
 	if (opc == OST_WRITE && OBD_FAIL_CHECK(OBD_FAIL_OSC_CHECKSUM_SEND))
@@ -1116,8 +1194,16 @@ static u32 osc_checksum_bulk(int nob, size_t pg_count,
 	return cksum;
 }
 
+/**
+ * Build a BRW request for \a page_count pages.
+ *
+ * A write may carry the pages of \a obj_count objects, grouped by object
+ * in \a pga. \a oa describes the first object and goes in the ost_body,
+ * \a xoa holds the obdos of the following ones, in order.
+ */
 static int
 osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
+		     struct obdo *xoa, u32 obj_count,
 		     u32 page_count, struct brw_page **pga,
 		     struct ptlrpc_request **reqp, int resend)
 {
@@ -1126,7 +1212,9 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
         struct ost_body         *body;
         struct obd_ioobj        *ioobj;
         struct niobuf_remote    *niobuf;
+	struct obdo		*wxoa = NULL;
         int niocount, i, requested_nob, opc, rc;
+	u32 first, k;
         struct osc_brw_async_args *aa;
         struct req_capsule      *pill;
         struct brw_page *pg_prev;
@@ -1137,10 +1225,13 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
         if (OBD_FAIL_CHECK(OBD_FAIL_OSC_BRW_PREP_REQ2))
                 RETURN(-EINVAL); /* Fatal */
 
+	LASSERT(obj_count == 1 || (cmd & OBD_BRW_WRITE) != 0);
 	if ((cmd & OBD_BRW_WRITE) != 0) {
 		opc = OST_WRITE;
 		req = ptlrpc_request_alloc_pool(cli->cl_import,
 						osc_rq_pool,
+						obj_count > 1 ?
+						&RQF_OST_BRW_WRITE_MULTI :
 						&RQF_OST_BRW_WRITE);
 	} else {
 		opc = OST_READ;
@@ -1149,16 +1240,21 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
         if (req == NULL)
                 RETURN(-ENOMEM);
 
-        for (niocount = i = 1; i < page_count; i++) {
-                if (!can_merge_pages(pga[i - 1], pga[i]))
-                        niocount++;
-        }
+	/* niobufs never span two objects */
+	for (niocount = i = 1; i < page_count; i++) {
+		if (!can_merge_pages(pga[i - 1], pga[i]) ||
+		    brw_obj_boundary(pga, i, obj_count))
+			niocount++;
+	}
 
         pill = &req->rq_pill;
         req_capsule_set_size(pill, &RMF_OBD_IOOBJ, RCL_CLIENT,
-                             sizeof(*ioobj));
+			     obj_count * sizeof(*ioobj));
         req_capsule_set_size(pill, &RMF_NIOBUF_REMOTE, RCL_CLIENT,
                              niocount * sizeof(*niobuf));
+	if (obj_count > 1)
+		req_capsule_set_size(pill, &RMF_BRW_OBDOS, RCL_CLIENT,
+				     (obj_count - 1) * sizeof(*xoa));
 
         rc = ptlrpc_request_pack(req, LUSTRE_OST_VERSION, opc);
         if (rc) {
@@ -1190,30 +1286,52 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
 
 	lustre_set_wire_obdo(&req->rq_import->imp_connect_data, &body->oa, oa);
 
-	obdo_to_ioobj(oa, ioobj);
-	ioobj->ioo_bufcnt = niocount;
-	/* The high bits of ioo_max_brw tells server _maximum_ number of bulks
-	 * that might be send for this request.  The actual number is decided
-	 * when the RPC is finally sent in ptlrpc_register_bulk(). It sends
-	 * "max - 1" for old client compatibility sending "0", and also so the
-	 * the actual maximum is a power-of-two number, not one less. LU-1431 */
-	ioobj_max_brw_set(ioobj, desc->bd_md_max_brw);
+	if (obj_count > 1) {
+		wxoa = req_capsule_client_get(pill, &RMF_BRW_OBDOS);
+		LASSERT(wxoa != NULL);
+	}
+	for (k = 0; k < obj_count; k++) {
+		if (k > 0) {
+			lustre_set_wire_obdo(&req->rq_import->imp_connect_data,
+					     &wxoa[k - 1], &xoa[k - 1]);
+			obdo_to_ioobj(&xoa[k - 1], &ioobj[k]);
+		} else {
+			obdo_to_ioobj(oa, &ioobj[k]);
+		}
+		ioobj[k].ioo_bufcnt = 0;
+		/* The high bits of ioo_max_brw tells server _maximum_ number
+		 * of bulks that might be send for this request.  The actual
+		 * number is decided when the RPC is finally sent in
+		 * ptlrpc_register_bulk(). It sends "max - 1" for old client
+		 * compatibility sending "0", and also so the the actual
+		 * maximum is a power-of-two number, not one less. LU-1431 */
+		ioobj_max_brw_set(&ioobj[k], desc->bd_md_max_brw);
+	}
 	LASSERT(page_count > 0);
 	pg_prev = pga[0];
+	first = k = 0;
         for (requested_nob = i = 0; i < page_count; i++, niobuf++) {
                 struct brw_page *pg = pga[i];
 		int poff = pg->off & ~PAGE_MASK;
+		bool last = i == page_count - 1 ||
+			    brw_obj_boundary(pga, i + 1, obj_count);
+
+		if (brw_obj_boundary(pga, i, obj_count)) {
+			first = i;
+			k++;
+		}
 
                 LASSERT(pg->count > 0);
                 /* make sure there is no gap in the middle of page array */
-		LASSERTF(page_count == 1 ||
-			 (ergo(i == 0, poff + pg->count == PAGE_CACHE_SIZE) &&
-			  ergo(i > 0 && i < page_count - 1,
-			       poff == 0 && pg->count == PAGE_CACHE_SIZE)   &&
-			  ergo(i == page_count - 1, poff == 0)),
+		LASSERTF((i == first && last) ||
+			 (ergo(i == first,
+			       poff + pg->count == PAGE_CACHE_SIZE) &&
+			  ergo(i != first && !last,
+			       poff == 0 && pg->count == PAGE_CACHE_SIZE) &&
+			  ergo(last, poff == 0)),
 			 "i: %d/%d pg: %p off: "LPU64", count: %u\n",
 			 i, page_count, pg, pg->off, pg->count);
-                LASSERTF(i == 0 || pg->off > pg_prev->off,
+                LASSERTF(i == first || pg->off > pg_prev->off,
                          "i %d p_c %u pg %p [pri %lu ind %lu] off "LPU64
                          " prev_pg %p [pri %lu ind %lu] off "LPU64"\n",
                          i, page_count,
@@ -1226,16 +1344,18 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
 		desc->bd_frag_ops->add_kiov_frag(desc, pg->pg, poff, pg->count);
                 requested_nob += pg->count;
 
-                if (i > 0 && can_merge_pages(pg_prev, pg)) {
+		if (i > first && can_merge_pages(pg_prev, pg)) {
                         niobuf--;
 			niobuf->rnb_len += pg->count;
 		} else {
 			niobuf->rnb_offset = pg->off;
 			niobuf->rnb_len    = pg->count;
 			niobuf->rnb_flags  = pg->flag;
+			ioobj[k].ioo_bufcnt++;
                 }
                 pg_prev = pg;
         }
+	LASSERT(k == obj_count - 1);
 
         LASSERTF((void *)(niobuf - niocount) ==
                 req_capsule_client_get(&req->rq_pill, &RMF_NIOBUF_REMOTE),
@@ -1249,6 +1369,13 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
                         body->oa.o_flags = 0;
                 }
                 body->oa.o_flags |= OBD_FL_RECOV_RESEND;
+		for (k = 1; k < obj_count; k++) {
+			if ((wxoa[k - 1].o_valid & OBD_MD_FLFLAGS) == 0) {
+				wxoa[k - 1].o_valid |= OBD_MD_FLFLAGS;
+				wxoa[k - 1].o_flags = 0;
+			}
+			wxoa[k - 1].o_flags |= OBD_FL_RECOV_RESEND;
+		}
         }
 
         if (osc_should_shrink_grant(cli))
@@ -1286,6 +1413,9 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
                 /* 1 RC per niobuf */
                 req_capsule_set_size(pill, &RMF_RCS, RCL_SERVER,
                                      sizeof(__u32) * niocount);
+		if (obj_count > 1)
+			req_capsule_set_size(pill, &RMF_BRW_OBDOS, RCL_SERVER,
+					     (obj_count - 1) * sizeof(*xoa));
         } else {
                 if (cli->cl_checksum &&
                     !sptlrpc_flavor_has_bulk(&req->rq_flvr)) {
@@ -1300,6 +1430,8 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
         CLASSERT(sizeof(*aa) <= sizeof(req->rq_async_args));
         aa = ptlrpc_req_async_args(req);
         aa->aa_oa = oa;
+	aa->aa_xoa = xoa;
+	aa->aa_obj_count = obj_count;
         aa->aa_requested_nob = requested_nob;
         aa->aa_nio_count = niocount;
         aa->aa_page_count = page_count;
@@ -1310,9 +1442,10 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
 
 	*reqp = req;
 	niobuf = req_capsule_client_get(pill, &RMF_NIOBUF_REMOTE);
-	CDEBUG(D_RPCTRACE, "brw rpc %p - object "DOSTID" offset %lld<>%lld\n",
-		req, POSTID(&oa->o_oi), niobuf[0].rnb_offset,
-		niobuf[niocount - 1].rnb_offset + niobuf[niocount - 1].rnb_len);
+	CDEBUG(D_RPCTRACE, "brw rpc %p - object "DOSTID" offset %lld<>%lld"
+	       " (%u objects)\n", req, POSTID(&oa->o_oi), niobuf[0].rnb_offset,
+	       niobuf[niocount - 1].rnb_offset + niobuf[niocount - 1].rnb_len,
+	       obj_count);
         RETURN(0);
 
  out:
@@ -1373,7 +1506,9 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
                         &req->rq_import->imp_connection->c_peer;
         struct client_obd *cli = aa->aa_cli;
         struct ost_body *body;
+	struct obdo *rxoa = NULL;
 	u32 client_cksum = 0;
+	u32 k;
         ENTRY;
 
         if (rc < 0 && rc != -EDQUOT) {
@@ -1399,6 +1534,17 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
                 osc_quota_setdq(cli, qid, body->oa.o_valid, body->oa.o_flags);
         }
 
+	/* the other objects of a multi-object write have their own owner */
+	if (aa->aa_obj_count > 1)
+		rxoa = req_capsule_server_get(&req->rq_pill, &RMF_BRW_OBDOS);
+	for (k = 1; rxoa != NULL && k < aa->aa_obj_count; k++) {
+		struct obdo *xoa = &rxoa[k - 1];
+		unsigned int qid[MAXQUOTAS] = { xoa->o_uid, xoa->o_gid };
+
+		if (xoa->o_valid & (OBD_MD_FLUSRQUOTA | OBD_MD_FLGRPQUOTA))
+			osc_quota_setdq(cli, qid, xoa->o_valid, xoa->o_flags);
+	}
+
         osc_update_grant(cli, body);
 
         if (rc < 0)
@@ -1512,6 +1658,16 @@ out:
 		lustre_get_wire_obdo(&req->rq_import->imp_connect_data,
 				     aa->aa_oa, &body->oa);
 
+	if (rc >= 0 && aa->aa_obj_count > 1) {
+		if (rxoa == NULL) {
+			DEBUG_REQ(D_ERROR, req, "Can't unpack object obdos\n");
+			RETURN(-EPROTO);
+		}
+		for (k = 1; k < aa->aa_obj_count; k++)
+			lustre_get_wire_obdo(&req->rq_import->imp_connect_data,
+					     &aa->aa_xoa[k - 1], &rxoa[k - 1]);
+	}
+
         RETURN(rc);
 }
 
@@ -1528,7 +1684,8 @@ static int osc_brw_redo_request(struct ptlrpc_request *request,
 
 	rc = osc_brw_prep_request(lustre_msg_get_opc(request->rq_reqmsg) ==
 				OST_WRITE ? OBD_BRW_WRITE : OBD_BRW_READ,
-				  aa->aa_cli, aa->aa_oa, aa->aa_page_count,
+				  aa->aa_cli, aa->aa_oa, aa->aa_xoa,
+				  aa->aa_obj_count, aa->aa_page_count,
 				  aa->aa_ppga, &new_req, 1);
         if (rc)
                 RETURN(rc);
@@ -1615,10 +1772,81 @@ static void sort_brw_pages(struct brw_page **array, int num)
         } while (stride > 1);
 }
 
+/* sort each object of a multi-object write on its own */
+static void sort_brw_objs(struct brw_page **array, int num, u32 obj_count)
+{
+	int first = 0;
+	int i;
+
+	for (i = 1; i <= num; i++) {
+		if (i == num || brw_obj_boundary(array, i, obj_count)) {
+			sort_brw_pages(array + first, i - first);
+			first = i;
+		}
+	}
+}
+
 static void osc_release_ppga(struct brw_page **ppga, size_t count)
 {
         LASSERT(ppga != NULL);
-        OBD_FREE(ppga, sizeof(*ppga) * count);
+	OBD_FREE_LARGE(ppga, sizeof(*ppga) * count);
+}
+
+/**
+ * Update the cached attributes of the object \a last belongs to from the
+ * obdo returned by the OST, \a last being the last page of the object in
+ * the RPC.
+ */
+static void osc_brw_update_attr(const struct lu_env *env,
+				struct ptlrpc_request *req, struct obdo *oa,
+				struct osc_async_page *last)
+{
+	struct cl_attr *attr = &osc_env_info(env)->oti_attr;
+	unsigned long valid = 0;
+	struct cl_object *obj;
+
+	obj = osc2cl(last->oap_obj);
+
+	cl_object_attr_lock(obj);
+	if (oa->o_valid & OBD_MD_FLBLOCKS) {
+		attr->cat_blocks = oa->o_blocks;
+		valid |= CAT_BLOCKS;
+	}
+	if (oa->o_valid & OBD_MD_FLMTIME) {
+		attr->cat_mtime = oa->o_mtime;
+		valid |= CAT_MTIME;
+	}
+	if (oa->o_valid & OBD_MD_FLATIME) {
+		attr->cat_atime = oa->o_atime;
+		valid |= CAT_ATIME;
+	}
+	if (oa->o_valid & OBD_MD_FLCTIME) {
+		attr->cat_ctime = oa->o_ctime;
+		valid |= CAT_CTIME;
+	}
+
+	if (lustre_msg_get_opc(req->rq_reqmsg) == OST_WRITE) {
+		struct lov_oinfo *loi = cl2osc(obj)->oo_oinfo;
+		loff_t last_off = last->oap_count + last->oap_obj_off +
+			last->oap_page_off;
+
+		/* Change file size if this is an out of quota or
+		 * direct IO write and it extends the file size */
+		if (loi->loi_lvb.lvb_size < last_off) {
+			attr->cat_size = last_off;
+			valid |= CAT_SIZE;
+		}
+		/* Extend KMS if it's not a lockless write */
+		if (loi->loi_kms < last_off &&
+		    oap2osc_page(last)->ops_srvlock == 0) {
+			attr->cat_kms = last_off;
+			valid |= CAT_KMS;
+		}
+	}
+
+	if (valid != 0)
+		cl_object_attr_update(env, obj, attr, valid);
+	cl_object_attr_unlock(obj);
 }
 
 static int brw_interpret(const struct lu_env *env,
@@ -1658,57 +1886,28 @@ static int brw_interpret(const struct lu_env *env,
 	}
 
 	if (rc == 0) {
-		struct obdo *oa = aa->aa_oa;
-		struct cl_attr *attr = &osc_env_info(env)->oti_attr;
-		unsigned long valid = 0;
-		struct cl_object *obj;
-		struct osc_async_page *last;
-
-		last = brw_page2oap(aa->aa_ppga[aa->aa_page_count - 1]);
-		obj = osc2cl(last->oap_obj);
-
-		cl_object_attr_lock(obj);
-		if (oa->o_valid & OBD_MD_FLBLOCKS) {
-			attr->cat_blocks = oa->o_blocks;
-			valid |= CAT_BLOCKS;
-		}
-		if (oa->o_valid & OBD_MD_FLMTIME) {
-			attr->cat_mtime = oa->o_mtime;
-			valid |= CAT_MTIME;
-		}
-		if (oa->o_valid & OBD_MD_FLATIME) {
-			attr->cat_atime = oa->o_atime;
-			valid |= CAT_ATIME;
-		}
-		if (oa->o_valid & OBD_MD_FLCTIME) {
-			attr->cat_ctime = oa->o_ctime;
-			valid |= CAT_CTIME;
+		u32 i;
+		u32 k = 0;
+
+		/* the last page of each object tells its new size */
+		for (i = 0; i < aa->aa_page_count; i++) {
+			if (i < aa->aa_page_count - 1 &&
+			    !brw_obj_boundary(aa->aa_ppga, i + 1,
+					      aa->aa_obj_count))
+				continue;
+
+			osc_brw_update_attr(env, req,
+					    k == 0 ? aa->aa_oa :
+						     &aa->aa_xoa[k - 1],
+					    brw_page2oap(aa->aa_ppga[i]));
+			k++;
 		}
-
-		if (lustre_msg_get_opc(req->rq_reqmsg) == OST_WRITE) {
-			struct lov_oinfo *loi = cl2osc(obj)->oo_oinfo;
-			loff_t last_off = last->oap_count + last->oap_obj_off +
-				last->oap_page_off;
-
-			/* Change file size if this is an out of quota or
-			 * direct IO write and it extends the file size */
-			if (loi->loi_lvb.lvb_size < last_off) {
-				attr->cat_size = last_off;
-				valid |= CAT_SIZE;
-			}
-			/* Extend KMS if it's not a lockless write */
-			if (loi->loi_kms < last_off &&
-			    oap2osc_page(last)->ops_srvlock == 0) {
-				attr->cat_kms = last_off;
-				valid |= CAT_KMS;
-			}
-		}
-
-		if (valid != 0)
-			cl_object_attr_update(env, obj, attr, valid);
-		cl_object_attr_unlock(obj);
+		LASSERT(k == aa->aa_obj_count);
 	}
 	OBDO_FREE(aa->aa_oa);
+	if (aa->aa_xoa != NULL)
+		OBD_FREE_LARGE(aa->aa_xoa,
+			       (aa->aa_obj_count - 1) * sizeof(*aa->aa_xoa));
 
 	if (lustre_msg_get_opc(req->rq_reqmsg) == OST_WRITE && rc == 0)
 		osc_inc_unstable_pages(req);
@@ -1756,6 +1955,40 @@ static void brw_commit(struct ptlrpc_request *req)
 	}
 }
 
+/**
+ * Fill the obdos \a xoa of the 2nd and following objects of a multi-object
+ * write from the first page of each object, \a flags being the
+ * cl_req_attr::cra_flags to ask for.
+ */
+static void osc_brw_xoa_set(const struct lu_env *env,
+			    struct list_head *ext_list,
+			    struct cl_req_attr *crattr, struct obdo *xoa,
+			    u64 flags)
+{
+	struct osc_object *cur = NULL;
+	struct osc_extent *ext;
+	bool first;
+	int k = 0;
+
+	list_for_each_entry(ext, ext_list, oe_link) {
+		if (ext->oe_obj == cur)
+			continue;
+
+		first = cur == NULL;
+		cur = ext->oe_obj;
+		/* the first object goes in the ost_body */
+		if (first)
+			continue;
+
+		crattr->cra_page = oap2cl_page(list_entry(ext->oe_pages.next,
+							  struct osc_async_page,
+							  oap_pending_item));
+		crattr->cra_oa = &xoa[k++];
+		crattr->cra_flags = flags;
+		cl_req_attr_set(env, osc2cl(cur), crattr);
+	}
+}
+
 /**
  * Build an RPC by the list of extent @ext_list. The caller must ensure
  * that the total pages in this list are NOT over max pages per RPC.
@@ -1769,39 +2002,48 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 	struct brw_page			**pga = NULL;
 	struct osc_brw_async_args	*aa = NULL;
 	struct obdo			*oa = NULL;
+	struct obdo			*xoa = NULL;
 	struct osc_async_page		*oap;
 	struct osc_object		*obj = NULL;
+	struct osc_object		*cur = NULL;
 	struct cl_req_attr		*crattr = NULL;
 	loff_t				starting_offset = OBD_OBJECT_EOF;
 	loff_t				ending_offset = 0;
+	loff_t				first_offset = OBD_OBJECT_EOF;
 	int				mpflag = 0;
 	int				mem_tight = 0;
 	int				page_count = 0;
+	u32				obj_count = 0;
 	bool				soft_sync = false;
 	bool				interrupted = false;
 	int				i;
-	int				grant = 0;
 	int				rc;
 	struct list_head		rpc_list = LIST_HEAD_INIT(rpc_list);
 	struct ost_body			*body;
 	ENTRY;
 	LASSERT(!list_empty(ext_list));
 
-	/* add pages into rpc_list to build BRW rpc */
+	/* add pages into rpc_list to build BRW rpc, the extents of a
+	 * multi-object write are grouped by object */
 	list_for_each_entry(ext, ext_list, oe_link) {
 		LASSERT(ext->oe_state == OES_RPC);
 		mem_tight |= ext->oe_memalloc;
-		grant += ext->oe_grants;
 		page_count += ext->oe_nr_pages;
 		if (obj == NULL)
 			obj = ext->oe_obj;
+		if (ext->oe_obj != cur) {
+			cur = ext->oe_obj;
+			obj_count++;
+		}
 	}
+	LASSERT(obj_count == 1 || cmd == OBD_BRW_WRITE);
 
 	soft_sync = osc_over_unstable_soft_limit(cli);
 	if (mem_tight)
 		mpflag = cfs_memory_pressure_get_and_set();
 
-	OBD_ALLOC(pga, sizeof(*pga) * page_count);
+	/* 32KB for a 16MB RPC, don't depend on high order allocations */
+	OBD_ALLOC_LARGE(pga, sizeof(*pga) * page_count);
 	if (pga == NULL)
 		GOTO(out, rc = -ENOMEM);
 
@@ -1809,8 +2051,24 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 	if (oa == NULL)
 		GOTO(out, rc = -ENOMEM);
 
+	if (obj_count > 1) {
+		OBD_ALLOC_LARGE(xoa, (obj_count - 1) * sizeof(*xoa));
+		if (xoa == NULL)
+			GOTO(out, rc = -ENOMEM);
+	}
+
 	i = 0;
+	cur = NULL;
 	list_for_each_entry(ext, ext_list, oe_link) {
+		if (ext->oe_obj != cur) {
+			/* offsets are checked per object, only the first one
+			 * is accounted in the offset histogram */
+			if (cur == obj)
+				first_offset = starting_offset;
+			cur = ext->oe_obj;
+			starting_offset = OBD_OBJECT_EOF;
+			ending_offset = 0;
+		}
 		list_for_each_entry(oap, &ext->oe_pages, oap_pending_item) {
 			if (mem_tight)
 				oap->oap_brw_flags |= OBD_BRW_MEMALLOC;
@@ -1836,6 +2094,8 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 				interrupted = true;
 		}
 	}
+	if (obj_count > 1)
+		starting_offset = first_offset;
 
 	/* first page in the list */
 	oap = list_entry(rpc_list.next, typeof(*oap), oap_rpc_item);
@@ -1847,12 +2107,29 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 	crattr->cra_page = oap2cl_page(oap);
 	crattr->cra_oa = oa;
 	cl_req_attr_set(env, osc2cl(obj), crattr);
+	if (obj_count > 1)
+		osc_brw_xoa_set(env, ext_list, crattr, xoa, ~0ULL);
+
+	/* grant is consumed by each object on its own */
+	if (cmd == OBD_BRW_WRITE) {
+		struct obdo *goa = oa;
+
+		oa->o_grant_used = 0;
+		cur = obj;
+		i = 0;
+		list_for_each_entry(ext, ext_list, oe_link) {
+			if (ext->oe_obj != cur) {
+				cur = ext->oe_obj;
+				goa = &xoa[i++];
+				goa->o_grant_used = 0;
+			}
+			goa->o_grant_used += ext->oe_grants;
+		}
+	}
 
-	if (cmd == OBD_BRW_WRITE)
-		oa->o_grant_used = grant;
-
-	sort_brw_pages(pga, page_count);
-	rc = osc_brw_prep_request(cmd, cli, oa, page_count, pga, &req, 0);
+	sort_brw_objs(pga, page_count, obj_count);
+	rc = osc_brw_prep_request(cmd, cli, oa, xoa, obj_count, page_count,
+				  pga, &req, 0);
 	if (rc != 0) {
 		CERROR("prep_req failed: %d\n", rc);
 		GOTO(out, rc);
@@ -1873,7 +2150,14 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 	body = req_capsule_client_get(&req->rq_pill, &RMF_OST_BODY);
 	crattr->cra_oa = &body->oa;
 	crattr->cra_flags = OBD_MD_FLMTIME|OBD_MD_FLCTIME|OBD_MD_FLATIME;
+	crattr->cra_page = oap2cl_page(oap);
 	cl_req_attr_set(env, osc2cl(obj), crattr);
+	if (obj_count > 1)
+		osc_brw_xoa_set(env, ext_list, crattr,
+				req_capsule_client_get(&req->rq_pill,
+						       &RMF_BRW_OBDOS),
+				OBD_MD_FLMTIME | OBD_MD_FLCTIME |
+				OBD_MD_FLATIME);
 	lustre_msg_set_jobid(req->rq_reqmsg, crattr->cra_jobid);
 
 	CLASSERT(sizeof(*aa) <= sizeof(req->rq_async_args));
@@ -1897,11 +2181,15 @@ int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 		lprocfs_oh_tally(&cli->cl_write_rpc_hist, cli->cl_w_in_flight);
 		lprocfs_oh_tally_log2(&cli->cl_write_offset_hist,
 				      starting_offset + 1);
+		if (obj_count > 1) {
+			cli->cl_w_multiobj_rpcs++;
+			cli->cl_w_multiobj_objs += obj_count;
+		}
 	}
 	spin_unlock(&cli->cl_loi_list_lock);
 
-	DEBUG_REQ(D_INODE, req, "%d pages, aa %p. now %ur/%uw in flight",
-		  page_count, aa, cli->cl_r_in_flight,
+	DEBUG_REQ(D_INODE, req, "%d pages, %u objects, aa %p. now %ur/%uw in "
+		  "flight", page_count, obj_count, aa, cli->cl_r_in_flight,
 		  cli->cl_w_in_flight);
 
 	ptlrpcd_add_req(req);
@@ -1917,8 +2205,10 @@ out:
 
 		if (oa)
 			OBDO_FREE(oa);
+		if (xoa)
+			OBD_FREE_LARGE(xoa, (obj_count - 1) * sizeof(*xoa));
 		if (pga)
-			OBD_FREE(pga, sizeof(*pga) * page_count);
+			OBD_FREE_LARGE(pga, sizeof(*pga) * page_count);
 		/* this should happen rarely and is pretty bad, it makes the
 		 * pending list not follow the dirty order */
 		while (!list_empty(ext_list)) {
@@ -2456,7 +2746,6 @@ static int osc_set_info_async(const struct lu_env *env, struct obd_export *exp,
 		LASSERT(cli->cl_cache == NULL); /* only once */
 		cli->cl_cache = (struct cl_client_cache *)val;
 		cl_cache_incref(cli->cl_cache);
-		cli->cl_lru_left = &cli->cl_cache->ccc_lru_left;
 
 		/* add this osc into entity list */
 		LASSERT(list_empty(&cli->cl_lru_osc));
@@ -2888,7 +3177,6 @@ int osc_cleanup(struct obd_device *obd)
 		spin_lock(&cli->cl_cache->ccc_lru_lock);
 		list_del_init(&cli->cl_lru_osc);
 		spin_unlock(&cli->cl_cache->ccc_lru_lock);
-		cli->cl_lru_left = NULL;
 		cl_cache_decref(cli->cl_cache);
 		cli->cl_cache = NULL;
 	}
@@ -1682,6 +1682,7 @@ static void osd_conf_get(const struct lu_env *env,
 	param->ddp_max_extent_blks = EXT_INIT_MAX_LEN >> 2;
 	/* worst-case extent insertion metadata overhead */
 	param->ddp_extent_tax = 6 * LDISKFS_BLOCK_SIZE(sb);
+	param->ddp_t10_cksum_type = osd_dt_dev(dev)->od_t10_type;
 	param->ddp_mntopts      = 0;
         if (test_opt(sb, XATTR_USER))
                 param->ddp_mntopts |= MNTOPT_USERXATTR;
@@ -6095,7 +6096,9 @@ static void osd_key_fini(const struct lu_context *ctx,
 		ldiskfs_htree_lock_free(info->oti_hlock);
 	OBD_FREE(info->oti_it_ea_buf, OSD_IT_EA_BUFSIZE);
 	lu_buf_free(&info->oti_iobuf.dr_pg_buf);
+	lu_buf_free(&info->oti_iobuf.dr_lnb_buf);
 	lu_buf_free(&info->oti_iobuf.dr_bl_buf);
+	lu_buf_free(&info->oti_iobuf.dr_pi_buf);
 	lu_buf_free(&info->oti_big_buf);
 	if (idc != NULL) {
 		LASSERT(info->oti_ins_cache_size > 0);
@@ -6446,6 +6449,8 @@ static int osd_device_init0(const struct lu_env *env,
 	if (rc != 0)
 		GOTO(out, rc);
 
+	osd_t10_init(o);
+
 	rc = osd_obj_map_init(env, o);
 	if (rc != 0)
 		GOTO(out_mnt, rc);
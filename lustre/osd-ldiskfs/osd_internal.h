@@ -271,6 +271,11 @@ struct osd_device {
 	unsigned long long	od_readcache_max_filesize;
 	int			od_read_cache;
 	int			od_writethrough_cache;
+	/* OBD_CKSUM_T10* type matching the block device integrity profile,
+	 * whose guard tags are passed straight to and from the disk */
+	__u32			od_t10_type;
+	/* log2 of the integrity interval of the block device */
+	unsigned int		od_t10_shift;
 
 	struct brw_stats	od_brw_stats;
 	atomic_t		od_r_in_flight;
@@ -502,8 +507,13 @@ struct osd_iobuf {
 	unsigned int       dr_rw:1;
 	struct lu_buf	   dr_pg_buf;
 	struct page      **dr_pages;
+	struct lu_buf	   dr_lnb_buf;
+	/* local buffers of dr_pages, to exchange guard tags with, or NULL */
+	struct niobuf_local **dr_lnbs;
 	struct lu_buf	   dr_bl_buf;
 	sector_t	  *dr_blocks;
+	/* integrity tuples of all sectors of dr_pages, see osd_do_bio() */
+	struct lu_buf	   dr_pi_buf;
 	unsigned long      dr_start_time;
 	unsigned long      dr_elapsed;  /* how long io took */
 	struct osd_device *dr_dev;
@@ -666,6 +676,7 @@ int osd_register_proc_index_in_idif(struct osd_device *osd);
 #endif
 int osd_statfs(const struct lu_env *env, struct dt_device *dev,
                struct obd_statfs *sfs);
+void osd_t10_init(struct osd_device *osd);
 struct inode *osd_iget(struct osd_thread_info *info, struct osd_device *dev,
 		       struct osd_inode_id *id);
 int osd_ea_fid_set(struct osd_thread_info *info, struct inode *inode,
@@ -60,6 +60,195 @@
 /* ext_depth() */
 #include <ldiskfs/ldiskfs_extents.h>
 
+#ifdef CONFIG_BLK_DEV_INTEGRITY
+/* T10 protection information tuple, as stored by the device */
+struct osd_dif_tuple {
+	__be16 odt_guard_tag;
+	__be16 odt_app_tag;
+	__be32 odt_ref_tag;
+};
+
+static inline size_t osd_pi_buf_size(struct osd_device *d, int pages)
+{
+	return pages * (PAGE_CACHE_SIZE >> d->od_t10_shift) *
+	       sizeof(struct osd_dif_tuple);
+}
+
+/**
+ * Check whether the integrity profile of the device matches one of the
+ * OBD_CKSUM_T10* checksum types, in which case guard tags computed by the
+ * target for the bulk checksum can be written to the disk as they are, and
+ * those read from the disk can be used for the bulk checksum.
+ */
+void osd_t10_init(struct osd_device *osd)
+{
+	struct super_block *sb = osd_sb(osd);
+	struct blk_integrity *bi = bdev_get_integrity(sb->s_bdev);
+	unsigned int interval;
+	const char *name;
+	__u32 type = 0;
+
+	osd->od_t10_type = 0;
+	if (bi == NULL)
+		return;
+
+#ifdef HAVE_INTERVAL_EXP_BLK_INTEGRITY
+	name = bi->profile != NULL ? bi->profile->name : NULL;
+	interval = 1 << bi->interval_exp;
+#else
+	name = bi->name;
+	interval = bi->sector_size;
+#endif
+	if (name == NULL || bi->tuple_size != sizeof(struct osd_dif_tuple) ||
+	    interval > PAGE_CACHE_SIZE || interval > sb->s_blocksize)
+		return;
+
+	if (strcmp(name, "T10-DIF-TYPE1-CRC") == 0) {
+		if (interval == 512)
+			type = OBD_CKSUM_T10CRC512;
+		else if (interval == 4096)
+			type = OBD_CKSUM_T10CRC4K;
+	} else if (strcmp(name, "T10-DIF-TYPE1-IP") == 0) {
+		if (interval == 512)
+			type = OBD_CKSUM_T10IP512;
+		else if (interval == 4096)
+			type = OBD_CKSUM_T10IP4K;
+	}
+
+	if (type == 0)
+		return;
+
+	osd->od_t10_type = type;
+	osd->od_t10_shift = ilog2(interval);
+	CDEBUG(D_INFO, "%s: device integrity %s/%u matches checksum type %x\n",
+	       osd_name(osd), name, interval, type);
+}
+
+/* Are the guard tags of page \a idx exchanged with the disk? */
+static bool osd_page_pi(struct osd_iobuf *iobuf, int idx)
+{
+	struct niobuf_local *lnb = iobuf->dr_lnbs[idx];
+
+	if (lnb == NULL || !lnb->lnb_guard_want)
+		return false;
+
+	return iobuf->dr_rw == 0 || lnb->lnb_guard_valid;
+}
+
+/**
+ * Attach tuples [\a first, \a first + \a count) of dr_pi_buf to \a bio,
+ * which starts at \a sector, as its integrity payload.
+ *
+ * For writes the tuples are built from the guard tags that the target
+ * computed for the bulk checksum, so the block layer does not generate
+ * them again. For reads the device fills the tuples in, and the guard tags
+ * are picked up by osd_pi_read_done().
+ */
+static int osd_bio_integrity_attach(struct osd_iobuf *iobuf, struct bio *bio,
+				    sector_t sector, unsigned int first,
+				    unsigned int count)
+{
+	struct osd_device *osd = iobuf->dr_dev;
+	struct osd_dif_tuple *pi = iobuf->dr_pi_buf.lb_buf;
+	unsigned int per_page = PAGE_CACHE_SIZE >> osd->od_t10_shift;
+	unsigned int len = count * sizeof(*pi);
+	struct bio_integrity_payload *bip;
+	__u32 ref = sector >> (osd->od_t10_shift - 9);
+	char *addr;
+	int i;
+
+	pi += first;
+	if (iobuf->dr_rw == 1) {
+		for (i = 0; i < count; i++) {
+			unsigned int t = first + i;
+			struct niobuf_local *lnb = iobuf->dr_lnbs[t / per_page];
+
+			pi[i].odt_guard_tag =
+				(__force __be16)lnb->lnb_guards[t % per_page];
+			pi[i].odt_app_tag = 0;
+			pi[i].odt_ref_tag = cpu_to_be32(ref + i);
+		}
+	}
+
+	addr = (char *)pi;
+	bip = bio_integrity_alloc(bio, GFP_NOIO,
+				  DIV_ROUND_UP(offset_in_page(addr) + len,
+					       PAGE_SIZE));
+	if (IS_ERR_OR_NULL(bip))
+		return -ENOMEM;
+
+#ifdef HAVE_BVEC_ITER
+	bip->bip_iter.bi_size = len;
+	bip->bip_iter.bi_sector = sector;
+#else
+	bip->bip_size = len;
+	bip->bip_sector = sector;
+#endif
+	while (len > 0) {
+		unsigned int off = offset_in_page(addr);
+		unsigned int bytes = min_t(unsigned int, len, PAGE_SIZE - off);
+		struct page *page = is_vmalloc_addr(addr) ?
+				    vmalloc_to_page(addr) : virt_to_page(addr);
+
+		if (bio_integrity_add_page(bio, page, bytes, off) < bytes)
+			return -ENOMEM;
+		addr += bytes;
+		len -= bytes;
+	}
+
+	return 0;
+}
+
+/* Hand the guard tags read from the disk to the local buffers */
+static void osd_pi_read_done(struct osd_iobuf *iobuf)
+{
+	struct osd_dif_tuple *pi = iobuf->dr_pi_buf.lb_buf;
+	unsigned int per_page;
+	int i, j;
+
+	if (iobuf->dr_dev->od_t10_type == 0)
+		return;
+
+	per_page = PAGE_CACHE_SIZE >> iobuf->dr_dev->od_t10_shift;
+	for (i = 0; i < iobuf->dr_npages; i++) {
+		struct niobuf_local *lnb = iobuf->dr_lnbs[i];
+
+		if (lnb == NULL || !lnb->lnb_guard_valid)
+			continue;
+		for (j = 0; j < per_page; j++)
+			lnb->lnb_guards[j] =
+				(__force __u16)pi[i * per_page + j].odt_guard_tag;
+	}
+}
+#else /* !CONFIG_BLK_DEV_INTEGRITY */
+static inline size_t osd_pi_buf_size(struct osd_device *d, int pages)
+{
+	return 0;
+}
+
+void osd_t10_init(struct osd_device *osd)
+{
+	osd->od_t10_type = 0;
+}
+
+static inline bool osd_page_pi(struct osd_iobuf *iobuf, int idx)
+{
+	return false;
+}
+
+static inline int osd_bio_integrity_attach(struct osd_iobuf *iobuf,
+					   struct bio *bio, sector_t sector,
+					   unsigned int first,
+					   unsigned int count)
+{
+	return 0;
+}
+
+static inline void osd_pi_read_done(struct osd_iobuf *iobuf)
+{
+}
+#endif /* CONFIG_BLK_DEV_INTEGRITY */
+
 static int __osd_init_iobuf(struct osd_device *d, struct osd_iobuf *iobuf,
 			    int rw, int line, int pages)
 {
@@ -83,7 +272,8 @@ static int __osd_init_iobuf(struct osd_device *d, struct osd_iobuf *iobuf,
 	iobuf->dr_init_at = line;
 
 	blocks = pages * (PAGE_CACHE_SIZE >> osd_sb(d)->s_blocksize_bits);
-	if (iobuf->dr_bl_buf.lb_len >= blocks * sizeof(iobuf->dr_blocks[0])) {
+	if (iobuf->dr_bl_buf.lb_len >= blocks * sizeof(iobuf->dr_blocks[0]) &&
+	    iobuf->dr_pi_buf.lb_len >= osd_pi_buf_size(d, pages)) {
 		LASSERT(iobuf->dr_pg_buf.lb_len >=
 			pages * sizeof(iobuf->dr_pages[0]));
 		return 0;
@@ -112,6 +302,17 @@ static int __osd_init_iobuf(struct osd_device *d, struct osd_iobuf *iobuf,
 	if (unlikely(iobuf->dr_pages == NULL))
 		return -ENOMEM;
 
+	lu_buf_realloc(&iobuf->dr_lnb_buf, pages * sizeof(iobuf->dr_lnbs[0]));
+	iobuf->dr_lnbs = iobuf->dr_lnb_buf.lb_buf;
+	if (unlikely(iobuf->dr_lnbs == NULL))
+		return -ENOMEM;
+
+	if (d->od_t10_type != 0) {
+		lu_buf_realloc(&iobuf->dr_pi_buf, osd_pi_buf_size(d, pages));
+		if (unlikely(iobuf->dr_pi_buf.lb_buf == NULL))
+			return -ENOMEM;
+	}
+
 	iobuf->dr_max_pages = pages;
 
 	return 0;
@@ -121,8 +322,17 @@ static int __osd_init_iobuf(struct osd_device *d, struct osd_iobuf *iobuf,
 
 static void osd_iobuf_add_page(struct osd_iobuf *iobuf, struct page *page)
 {
-        LASSERT(iobuf->dr_npages < iobuf->dr_max_pages);
-        iobuf->dr_pages[iobuf->dr_npages++] = page;
+	LASSERT(iobuf->dr_npages < iobuf->dr_max_pages);
+	iobuf->dr_lnbs[iobuf->dr_npages] = NULL;
+	iobuf->dr_pages[iobuf->dr_npages++] = page;
+}
+
+/* add the page of \a lnb, which may exchange guard tags with the disk */
+static void osd_iobuf_add_lnb(struct osd_iobuf *iobuf,
+			      struct niobuf_local *lnb)
+{
+	osd_iobuf_add_page(iobuf, lnb->lnb_page);
+	iobuf->dr_lnbs[iobuf->dr_npages - 1] = lnb;
 }
 
 void osd_fini_iobuf(struct osd_device *d, struct osd_iobuf *iobuf)
@@ -274,6 +484,13 @@ static int osd_do_bio(struct osd_device *osd, struct inode *inode,
 	int            page_idx;
 	int            i;
 	int            rc = 0;
+	/* integrity tuples of the current bio, see osd_bio_integrity_attach */
+	bool	       page_pi;
+	bool	       bio_pi = false;
+	sector_t       bio_start = 0;
+	unsigned int   pi_idx = 0;
+	unsigned int   pi_first = 0;
+	unsigned int   pi_next = 0;
 	ENTRY;
 
         LASSERT(iobuf->dr_npages == npages);
@@ -288,6 +505,12 @@ static int osd_do_bio(struct osd_device *osd, struct inode *inode,
                 page = pages[page_idx];
                 LASSERT(block_idx + blocks_per_page <= total_blocks);
 
+		page_pi = osd_page_pi(iobuf, page_idx);
+		/* on read the guard tags are valid if the whole page comes
+		 * from the disk, holes are cleared below */
+		if (page_pi && iobuf->dr_rw == 0)
+			iobuf->dr_lnbs[page_idx]->lnb_guard_valid = 1;
+
                 for (i = 0, page_offset = 0;
                      i < blocks_per_page;
                      i += nblocks, page_offset += blocksize * nblocks) {
@@ -300,6 +523,9 @@ static int osd_do_bio(struct osd_device *osd, struct inode *inode,
                                          page_idx, block_idx, i);
                                 memset(kmap(page) + page_offset, 0, blocksize);
                                 kunmap(page);
+				if (page_pi)
+					iobuf->dr_lnbs[page_idx]->
+						lnb_guard_valid = 0;
                                 continue;
                         }
 
@@ -312,17 +538,40 @@ static int osd_do_bio(struct osd_device *osd, struct inode *inode,
                                 sector_bits))
                                 nblocks++;
 
-                        if (bio != NULL &&
-                            can_be_merged(bio, sector) &&
-                            bio_add_page(bio, page,
-                                         blocksize * nblocks, page_offset) != 0)
-                                continue;       /* added this frag OK */
+			if (page_pi)
+				pi_idx = (page_idx << (PAGE_CACHE_SHIFT -
+						       osd->od_t10_shift)) +
+					 (page_offset >> osd->od_t10_shift);
+
+			/* a bio carries tuples for all of its sectors or for
+			 * none, and they have to be contiguous in dr_pi_buf */
+			if (bio != NULL &&
+			    can_be_merged(bio, sector) &&
+			    page_pi == bio_pi &&
+			    (!page_pi || pi_idx == pi_next) &&
+			    bio_add_page(bio, page,
+					 blocksize * nblocks, page_offset) != 0) {
+				pi_next += (blocksize * nblocks) >>
+					   osd->od_t10_shift;
+				continue;       /* added this frag OK */
+			}
 
 			if (bio != NULL) {
 				struct request_queue *q =
 					bdev_get_queue(bio->bi_bdev);
 				unsigned int bi_size = bio_sectors(bio) << 9;
 
+				if (bio_pi) {
+					rc = osd_bio_integrity_attach(iobuf,
+							bio, bio_start,
+							pi_first,
+							pi_next - pi_first);
+					if (rc != 0) {
+						bio_put(bio);
+						goto out;
+					}
+				}
+
 				/* Dang! I have to fragment this I/O */
 				CDEBUG(D_INODE, "bio++ sz %d vcnt %d(%d) "
 				       "sectors %d(%d) psg %d(%d) hsg %d(%d)\n",
@@ -354,6 +603,14 @@ static int osd_do_bio(struct osd_device *osd, struct inode *inode,
 			bio->bi_end_io = dio_complete_routine;
 			bio->bi_private = iobuf;
 
+			bio_start = sector;
+			bio_pi = page_pi;
+			if (page_pi) {
+				pi_first = pi_idx;
+				pi_next = pi_idx + ((blocksize * nblocks) >>
+						    osd->od_t10_shift);
+			}
+
 			rc = bio_add_page(bio, page,
 					  blocksize * nblocks, page_offset);
 			LASSERT(rc != 0);
@@ -361,6 +618,15 @@ static int osd_do_bio(struct osd_device *osd, struct inode *inode,
 	}
 
 	if (bio != NULL) {
+		if (bio_pi) {
+			rc = osd_bio_integrity_attach(iobuf, bio, bio_start,
+						      pi_first,
+						      pi_next - pi_first);
+			if (rc != 0) {
+				bio_put(bio);
+				goto out;
+			}
+		}
 		record_start_io(iobuf, bio_sectors(bio) << 9);
 		osd_submit_bio(iobuf->dr_rw, bio);
 		rc = 0;
@@ -379,6 +645,8 @@ out:
 
 	if (rc == 0)
 		rc = iobuf->dr_error;
+	if (rc == 0 && iobuf->dr_rw == 0)
+		osd_pi_read_done(iobuf);
 	RETURN(rc);
 }
 
@@ -1258,7 +1526,7 @@ static int osd_write_commit(const struct lu_env *env, struct dt_object *dt,
 
 		SetPageUptodate(lnb[i].lnb_page);
 
-		osd_iobuf_add_page(iobuf, lnb[i].lnb_page);
+		osd_iobuf_add_lnb(iobuf, &lnb[i]);
         }
 
 	osd_trans_exec_op(env, thandle, OSD_OT_WRITE);
@@ -1346,7 +1614,7 @@ static int osd_read_prep(const struct lu_env *env, struct dt_object *dt,
 			cache_hits++;
 		} else {
 			cache_misses++;
-			osd_iobuf_add_page(iobuf, lnb[i].lnb_page);
+			osd_iobuf_add_lnb(iobuf, &lnb[i]);
 		}
 
 		if (cache == 0)
@@ -614,6 +614,15 @@ static const struct req_msg_field *ost_brw_client[] = {
         &RMF_CAPA1
 };
 
+static const struct req_msg_field *ost_brw_multi_client[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_OST_BODY,
+	&RMF_OBD_IOOBJ,
+	&RMF_NIOBUF_REMOTE,
+	&RMF_CAPA1,
+	&RMF_BRW_OBDOS
+};
+
 static const struct req_msg_field *ost_brw_read_server[] = {
         &RMF_PTLRPC_BODY,
         &RMF_OST_BODY
@@ -625,6 +634,13 @@ static const struct req_msg_field *ost_brw_write_server[] = {
         &RMF_RCS
 };
 
+static const struct req_msg_field *ost_brw_multi_server[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_OST_BODY,
+	&RMF_RCS,
+	&RMF_BRW_OBDOS
+};
+
 static const struct req_msg_field *ost_get_info_generic_server[] = {
         &RMF_PTLRPC_BODY,
         &RMF_GENERIC_DATA,
@@ -779,6 +795,7 @@ static struct req_format *req_formats[] = {
         &RQF_OST_DESTROY,
         &RQF_OST_BRW_READ,
         &RQF_OST_BRW_WRITE,
+	&RQF_OST_BRW_WRITE_MULTI,
         &RQF_OST_STATFS,
         &RQF_OST_SET_GRANT_INFO,
 	&RQF_OST_GET_INFO,
@@ -1123,6 +1140,12 @@ struct req_msg_field RMF_RCS =
                     lustre_swab_generic_32s, dump_rcs);
 EXPORT_SYMBOL(RMF_RCS);
 
+/* obdos of the 2nd and following objects of a multi-object OST_WRITE */
+struct req_msg_field RMF_BRW_OBDOS =
+	DEFINE_MSGF("brw_obdos", RMF_F_STRUCT_ARRAY, sizeof(struct obdo),
+		    lustre_swab_obdo, NULL);
+EXPORT_SYMBOL(RMF_BRW_OBDOS);
+
 struct req_msg_field RMF_EAVALS_LENS =
 	DEFINE_MSGF("eavals_lens", RMF_F_STRUCT_ARRAY, sizeof(__u32),
 		lustre_swab_generic_32s, NULL);
@@ -1643,6 +1666,11 @@ struct req_format RQF_OST_BRW_WRITE =
         DEFINE_REQ_FMT0("OST_BRW_WRITE", ost_brw_client, ost_brw_write_server);
 EXPORT_SYMBOL(RQF_OST_BRW_WRITE);
 
+struct req_format RQF_OST_BRW_WRITE_MULTI =
+	DEFINE_REQ_FMT0("OST_BRW_WRITE_MULTI", ost_brw_multi_client,
+			ost_brw_multi_server);
+EXPORT_SYMBOL(RQF_OST_BRW_WRITE_MULTI);
+
 struct req_format RQF_OST_STATFS =
         DEFINE_REQ_FMT0("OST_STATFS", empty, obd_statfs_server);
 EXPORT_SYMBOL(RQF_OST_STATFS);
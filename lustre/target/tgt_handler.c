@@ -191,6 +191,9 @@ static int tgt_io_data_unpack(struct tgt_session_info *tsi, struct ost_id *oi)
 	struct niobuf_remote	*rnb;
 	struct obd_ioobj	*ioo;
 	int			 obj_count;
+	int			 max_objs = 1;
+	int			 niocount = 0;
+	int			 i;
 
 	ENTRY;
 
@@ -212,26 +215,34 @@ static int tgt_io_data_unpack(struct tgt_session_info *tsi, struct ost_id *oi)
 	}
 	ioo->ioo_oid = *oi;
 
+	/* only OST_WRITE may carry several objects, see tgt_brw_write() */
+	if (exp_connect_flags(tsi->tsi_exp) & OBD_CONNECT_MULTIOBJ_BRW &&
+	    lustre_msg_get_opc(tgt_ses_req(tsi)->rq_reqmsg) == OST_WRITE)
+		max_objs = PTLRPC_MAX_BRW_OBJS;
+
 	obj_count = req_capsule_get_size(tsi->tsi_pill, &RMF_OBD_IOOBJ,
 					RCL_CLIENT) / sizeof(*ioo);
 	if (obj_count == 0) {
 		CERROR("%s: short ioobj\n", tgt_name(tsi->tsi_tgt));
 		RETURN(-EPROTO);
-	} else if (obj_count > 1) {
+	} else if (obj_count > max_objs) {
 		CERROR("%s: too many ioobjs (%d)\n", tgt_name(tsi->tsi_tgt),
 		       obj_count);
 		RETURN(-EPROTO);
 	}
 
-	if (ioo->ioo_bufcnt == 0) {
-		CERROR("%s: ioo has zero bufcnt\n", tgt_name(tsi->tsi_tgt));
-		RETURN(-EPROTO);
+	for (i = 0; i < obj_count; i++) {
+		if (ioo[i].ioo_bufcnt == 0) {
+			CERROR("%s: ioo has zero bufcnt\n",
+			       tgt_name(tsi->tsi_tgt));
+			RETURN(-EPROTO);
+		}
+		niocount += ioo[i].ioo_bufcnt;
 	}
 
-	if (ioo->ioo_bufcnt > PTLRPC_MAX_BRW_PAGES) {
+	if (niocount > PTLRPC_MAX_BRW_PAGES) {
 		DEBUG_REQ(D_RPCTRACE, tgt_ses_req(tsi),
-			  "bulk has too many pages (%d)",
-			  ioo->ioo_bufcnt);
+			  "bulk has too many pages (%d)", niocount);
 		RETURN(-EPROTO);
 	}
 
@@ -1754,11 +1765,41 @@ void tgt_brw_unlock(struct obd_ioobj *obj, struct niobuf_remote *niob,
 	EXIT;
 }
 
+struct tgt_t10_frags {
+	struct ptlrpc_bulk_desc	*ttf_desc;
+	struct niobuf_local	*ttf_lnb;
+	int			 ttf_opc;
+};
+
+static void tgt_t10_frag_get(void *data, int idx, struct obd_t10_frag *frag)
+{
+	struct tgt_t10_frags *frags = data;
+	struct niobuf_local *lnb = &frags->ttf_lnb[idx];
+
+	frag->otf_page = BD_GET_KIOV(frags->ttf_desc, idx).kiov_page;
+	frag->otf_offset = BD_GET_KIOV(frags->ttf_desc, idx).kiov_offset &
+			   ~PAGE_MASK;
+	frag->otf_len = BD_GET_KIOV(frags->ttf_desc, idx).kiov_len;
+	if (lnb->lnb_guard_want) {
+		frag->otf_guards = lnb->lnb_guards;
+		frag->otf_reuse = frags->ttf_opc == OST_READ &&
+				  lnb->lnb_guard_valid;
+	}
+}
+
+/*
+ * Compute the bulk checksum of \a desc. For T10 checksum types, \a local_nb
+ * (which maps 1:1 to the bulk fragments) is used to exchange per-sector guard
+ * tags with the OSD, see ofd_lnb_guard_init().
+ */
 static __u32 tgt_checksum_bulk(struct lu_target *tgt,
 			       struct ptlrpc_bulk_desc *desc, int opc,
-			       cksum_type_t cksum_type)
+			       cksum_type_t cksum_type,
+			       struct niobuf_local *local_nb)
 {
-	struct cfs_crypto_hash_desc	*hdesc;
+	DECLARE_CKSUM_NAME;
+	struct cfs_crypto_hash_desc	*hdesc = NULL;
+	struct obd_t10_cksum_desc	*t10 = NULL;
 	unsigned int			bufsize;
 	int				i, err;
 	unsigned char			cfs_alg = cksum_obd2cfs(cksum_type);
@@ -1766,70 +1807,101 @@ static __u32 tgt_checksum_bulk(struct lu_target *tgt,
 
 	LASSERT(ptlrpc_is_bulk_desc_kiov(desc->bd_type));
 
-	hdesc = cfs_crypto_hash_init(cfs_alg, NULL, 0);
-	if (IS_ERR(hdesc)) {
-		CERROR("%s: unable to initialize checksum hash %s\n",
-		       tgt_name(tgt), cfs_crypto_hash_name(cfs_alg));
-		return PTR_ERR(hdesc);
-	}
-
-	CDEBUG(D_INFO, "Checksum for algo %s\n", cfs_crypto_hash_name(cfs_alg));
-	for (i = 0; i < desc->bd_iov_count; i++) {
-		/* corrupt the data before we compute the checksum, to
-		 * simulate a client->OST data error */
-		if (i == 0 && opc == OST_WRITE &&
-		    OBD_FAIL_CHECK(OBD_FAIL_OST_CHECKSUM_RECEIVE)) {
-			int off = BD_GET_KIOV(desc, i).kiov_offset &
-				~PAGE_MASK;
-			int len = BD_GET_KIOV(desc, i).kiov_len;
-			struct page *np = tgt_page_to_corrupt;
-			char *ptr = kmap(BD_GET_KIOV(desc, i).kiov_page) + off;
-
-			if (np) {
-				char *ptr2 = kmap(np) + off;
-
-				memcpy(ptr2, ptr, len);
-				memcpy(ptr2, "bad3", min(4, len));
-				kunmap(np);
-				BD_GET_KIOV(desc, i).kiov_page = np;
-			} else {
-				CERROR("%s: can't alloc page for corruption\n",
-				       tgt_name(tgt));
-			}
+	if (cksum_type_is_t10(cksum_type)) {
+		t10 = obd_t10_cksum_init(cksum_type);
+		if (IS_ERR(t10)) {
+			CERROR("%s: unable to initialize T10 checksum %x\n",
+			       tgt_name(tgt), cksum_type);
+			return PTR_ERR(t10);
 		}
-		cfs_crypto_hash_update_page(hdesc,
+	} else {
+		hdesc = cfs_crypto_hash_init(cfs_alg, NULL, 0);
+		if (IS_ERR(hdesc)) {
+			CERROR("%s: unable to initialize checksum hash %s\n",
+			       tgt_name(tgt), cfs_crypto_hash_name(cfs_alg));
+			return PTR_ERR(hdesc);
+		}
+	}
+
+	CDEBUG(D_INFO, "Checksum for algo %s\n",
+	       cksum_name[ffs(cksum_type) - 1]);
+
+	/* corrupt the data before we compute the checksum, to
+	 * simulate a client->OST data error */
+	if (opc == OST_WRITE && OBD_FAIL_CHECK(OBD_FAIL_OST_CHECKSUM_RECEIVE)) {
+		int off = BD_GET_KIOV(desc, 0).kiov_offset & ~PAGE_MASK;
+		int len = BD_GET_KIOV(desc, 0).kiov_len;
+		struct page *np = tgt_page_to_corrupt;
+		char *ptr = kmap(BD_GET_KIOV(desc, 0).kiov_page) + off;
+
+		if (np) {
+			char *ptr2 = kmap(np) + off;
+
+			memcpy(ptr2, ptr, len);
+			memcpy(ptr2, "bad3", min(4, len));
+			kunmap(np);
+			BD_GET_KIOV(desc, 0).kiov_page = np;
+		} else {
+			CERROR("%s: can't alloc page for corruption\n",
+			       tgt_name(tgt));
+		}
+	}
+
+	if (t10 != NULL) {
+		struct tgt_t10_frags frags = {
+			.ttf_desc	= desc,
+			.ttf_lnb	= local_nb,
+			.ttf_opc	= opc,
+		};
+
+		/* on write the guards become valid for the OSD only if
+		 * they cover the whole page */
+		for (i = 0; i < desc->bd_iov_count && opc == OST_WRITE; i++)
+			if (local_nb[i].lnb_guard_want)
+				local_nb[i].lnb_guard_valid =
+					BD_GET_KIOV(desc, i).kiov_offset == 0 &&
+					BD_GET_KIOV(desc, i).kiov_len ==
+						PAGE_CACHE_SIZE;
+
+		err = obd_t10_cksum_update_frags(t10, desc->bd_iov_count,
+						 tgt_t10_frag_get, &frags);
+		if (err == 0)
+			err = obd_t10_cksum_final(t10, &cksum);
+		else
+			obd_t10_cksum_final(t10, NULL);
+	} else {
+		for (i = 0; i < desc->bd_iov_count; i++)
+			cfs_crypto_hash_update_page(hdesc,
 				  BD_GET_KIOV(desc, i).kiov_page,
 				  BD_GET_KIOV(desc, i).kiov_offset &
 					~PAGE_MASK,
 				  BD_GET_KIOV(desc, i).kiov_len);
 
-		 /* corrupt the data after we compute the checksum, to
-		 * simulate an OST->client data error */
-		if (i == 0 && opc == OST_READ &&
-		    OBD_FAIL_CHECK(OBD_FAIL_OST_CHECKSUM_SEND)) {
-			int off = BD_GET_KIOV(desc, i).kiov_offset
-			  & ~PAGE_MASK;
-			int len = BD_GET_KIOV(desc, i).kiov_len;
-			struct page *np = tgt_page_to_corrupt;
-			char *ptr =
-			  kmap(BD_GET_KIOV(desc, i).kiov_page) + off;
-
-			if (np) {
-				char *ptr2 = kmap(np) + off;
-
-				memcpy(ptr2, ptr, len);
-				memcpy(ptr2, "bad4", min(4, len));
-				kunmap(np);
-				BD_GET_KIOV(desc, i).kiov_page = np;
-			} else {
-				CERROR("%s: can't alloc page for corruption\n",
-				       tgt_name(tgt));
-			}
-		}
+		bufsize = sizeof(cksum);
+		err = cfs_crypto_hash_final(hdesc, (unsigned char *)&cksum,
+					    &bufsize);
 	}
 
-	bufsize = sizeof(cksum);
-	err = cfs_crypto_hash_final(hdesc, (unsigned char *)&cksum, &bufsize);
+	/* corrupt the data after we compute the checksum, to
+	 * simulate an OST->client data error */
+	if (opc == OST_READ && OBD_FAIL_CHECK(OBD_FAIL_OST_CHECKSUM_SEND)) {
+		int off = BD_GET_KIOV(desc, 0).kiov_offset & ~PAGE_MASK;
+		int len = BD_GET_KIOV(desc, 0).kiov_len;
+		struct page *np = tgt_page_to_corrupt;
+		char *ptr = kmap(BD_GET_KIOV(desc, 0).kiov_page) + off;
+
+		if (np) {
+			char *ptr2 = kmap(np) + off;
+
+			memcpy(ptr2, ptr, len);
+			memcpy(ptr2, "bad4", min(4, len));
+			kunmap(np);
+			BD_GET_KIOV(desc, 0).kiov_page = np;
+		} else {
+			CERROR("%s: can't alloc page for corruption\n",
+			       tgt_name(tgt));
+		}
+	}
 
 	return cksum;
 }
@@ -1966,7 +2038,8 @@ int tgt_brw_read(struct tgt_session_info *tsi)
 		repbody->oa.o_flags = cksum_type_pack(cksum_type);
 		repbody->oa.o_valid = OBD_MD_FLCKSUM | OBD_MD_FLFLAGS;
 		repbody->oa.o_cksum = tgt_checksum_bulk(tsi->tsi_tgt, desc,
-							OST_READ, cksum_type);
+							OST_READ, cksum_type,
+							local_nb);
 		CDEBUG(D_PAGE, "checksum at read origin: %x\n",
 		       repbody->oa.o_cksum);
 	} else {
@@ -2070,6 +2143,157 @@ static void tgt_warn_on_cksum(struct ptlrpc_request *req,
 			   client_cksum, server_cksum);
 }
 
+/**
+ * Check the 2nd and following objects of a multi-object OST_WRITE.
+ *
+ * The ost_body describes the first object, the obdos of the other objects
+ * are carried in the RMF_BRW_OBDOS array, in the order of the ioobjs. Only
+ * writes under client locks can be aggregated, so none of the buffers may
+ * ask for a server side lock.
+ *
+ * \param[in] tsi	target session environment for this request
+ * \param[in] ioo	ioobj array
+ * \param[in] objcount	number of objects in \a ioo
+ * \param[in] rnb	remote buffers of all objects
+ * \param[in] niocount	number of remote buffers
+ *
+ * \retval		0 if the request is sane
+ * \retval		-EPROTO otherwise
+ */
+static int tgt_brw_multi_unpack(struct tgt_session_info *tsi,
+				struct obd_ioobj *ioo, int objcount,
+				struct niobuf_remote *rnb, int niocount)
+{
+	struct req_capsule	*pill = tsi->tsi_pill;
+	struct lu_nodemap	*nodemap;
+	struct obdo		*xoa;
+	int			 npages = 0;
+	int			 rc;
+	int			 i;
+
+	ENTRY;
+
+	req_capsule_extend(pill, &RQF_OST_BRW_WRITE_MULTI);
+	if (req_capsule_get_size(pill, &RMF_BRW_OBDOS, RCL_CLIENT) !=
+	    (objcount - 1) * sizeof(*xoa))
+		RETURN(-EPROTO);
+
+	xoa = req_capsule_client_get(pill, &RMF_BRW_OBDOS);
+	if (xoa == NULL)
+		RETURN(-EPROTO);
+
+	nodemap = tsi->tsi_exp->exp_target_data.ted_nodemap;
+	for (i = 1; i < objcount; i++) {
+		struct obdo *oa = &xoa[i - 1];
+
+		rc = tgt_validate_obdo(tsi, oa);
+		if (rc != 0)
+			RETURN(rc);
+
+		oa->o_uid = nodemap_map_id(nodemap, NODEMAP_UID,
+					   NODEMAP_CLIENT_TO_FS, oa->o_uid);
+		oa->o_gid = nodemap_map_id(nodemap, NODEMAP_GID,
+					   NODEMAP_CLIENT_TO_FS, oa->o_gid);
+		ioo[i].ioo_oid = oa->o_oi;
+	}
+
+	/* the local buffers of all objects must fit in the thread cache */
+	for (i = 0; i < niocount; i++) {
+		if (rnb[i].rnb_flags & OBD_BRW_SRVLOCK)
+			RETURN(-EPROTO);
+		npages += ((rnb[i].rnb_offset + rnb[i].rnb_len - 1) >>
+			   PAGE_CACHE_SHIFT) -
+			  (rnb[i].rnb_offset >> PAGE_CACHE_SHIFT) + 1;
+	}
+	if (npages > PTLRPC_MAX_BRW_PAGES)
+		RETURN(-EPROTO);
+
+	req_capsule_set_size(pill, &RMF_BRW_OBDOS, RCL_SERVER,
+			     (objcount - 1) * sizeof(*xoa));
+	RETURN(0);
+}
+
+/**
+ * Prepare the local buffers of all objects of a bulk write.
+ *
+ * Objects are prepared one by one, each with its own obdo from
+ * tbc->oas[], their local buffers follow each other in tbc->local.
+ * If an object fails, the objects prepared so far are committed with
+ * the error so that their buffers are released.
+ *
+ * \retval		total number of local buffers
+ * \retval		negative value on error
+ */
+static int tgt_brw_prep_write(const struct lu_env *env,
+			      struct obd_export *exp,
+			      struct tgt_thread_big_cache *tbc, int objcount,
+			      struct obd_ioobj *ioo, struct niobuf_remote *rnb)
+{
+	int npages = 0;
+	int nrnb = 0;
+	int rc = 0;
+	int i;
+
+	for (i = 0; i < objcount; i++) {
+		tbc->obj_pages[i] = PTLRPC_MAX_BRW_PAGES - npages;
+		rc = obd_preprw(env, OBD_BRW_WRITE, exp, tbc->oas[i], 1,
+				&ioo[i], rnb + nrnb, &tbc->obj_pages[i],
+				tbc->local + npages);
+		if (rc < 0)
+			break;
+
+		npages += tbc->obj_pages[i];
+		nrnb += ioo[i].ioo_bufcnt;
+	}
+
+	if (rc < 0) {
+		int j;
+
+		for (j = 0, npages = 0, nrnb = 0; j < i; j++) {
+			obd_commitrw(env, OBD_BRW_WRITE, exp, tbc->oas[j], 1,
+				     &ioo[j], rnb + nrnb, tbc->obj_pages[j],
+				     tbc->local + npages, rc);
+			npages += tbc->obj_pages[j];
+			nrnb += ioo[j].ioo_bufcnt;
+		}
+		return rc;
+	}
+
+	return npages;
+}
+
+/**
+ * Commit the local buffers prepared by tgt_brw_prep_write().
+ *
+ * \retval		0 on success
+ * \retval		the first error met otherwise
+ */
+static int tgt_brw_commit_write(const struct lu_env *env,
+				struct obd_export *exp,
+				struct tgt_thread_big_cache *tbc, int objcount,
+				struct obd_ioobj *ioo,
+				struct niobuf_remote *rnb, int old_rc)
+{
+	int npages = 0;
+	int nrnb = 0;
+	int rc = 0;
+	int i;
+
+	for (i = 0; i < objcount; i++) {
+		int rc2;
+
+		rc2 = obd_commitrw(env, OBD_BRW_WRITE, exp, tbc->oas[i], 1,
+				   &ioo[i], rnb + nrnb, tbc->obj_pages[i],
+				   tbc->local + npages, old_rc);
+		if (rc2 != 0 && rc == 0)
+			rc = rc2;
+		npages += tbc->obj_pages[i];
+		nrnb += ioo[i].ioo_bufcnt;
+	}
+
+	return rc;
+}
+
 int tgt_brw_write(struct tgt_session_info *tsi)
 {
 	struct ptlrpc_request	*req = tgt_ses_req(tsi);
@@ -2079,6 +2303,7 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 	struct niobuf_local	*local_nb;
 	struct obd_ioobj	*ioo;
 	struct ost_body		*body, *repbody;
+	struct obdo		*rxoa = NULL;
 	struct l_wait_info	 lwi;
 	struct lustre_handle	 lockh = {0};
 	__u32			*rcs;
@@ -2139,6 +2364,13 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 			sizeof(*remote_nb))
 		RETURN(err_serious(-EPROTO));
 
+	if (objcount > 1) {
+		rc = tgt_brw_multi_unpack(tsi, ioo, objcount, remote_nb,
+					  niocount);
+		if (rc != 0)
+			RETURN(err_serious(rc));
+	}
+
 	if ((remote_nb[0].rnb_flags & OBD_BRW_MEMALLOC) &&
 	    (exp->exp_connection->c_peer.nid == exp->exp_connection->c_self))
 		memory_pressure_set();
@@ -2188,11 +2420,29 @@ int tgt_brw_write(struct tgt_session_info *tsi)
 		GOTO(out_lock, rc = -ENOMEM);
 	repbody->oa = body->oa;
 
-	npages = PTLRPC_MAX_BRW_PAGES;
-	rc = obd_preprw(tsi->tsi_env, OBD_BRW_WRITE, exp, &repbody->oa,
-			objcount, ioo, remote_nb, &npages, local_nb);
+	tbc->oas[0] = &repbody->oa;
+	if (objcount > 1) {
+		struct obdo *xoa;
+
+		xoa = req_capsule_client_get(&req->rq_pill, &RMF_BRW_OBDOS);
+		rxoa = req_capsule_server_get(&req->rq_pill, &RMF_BRW_OBDOS);
+		if (rxoa == NULL)
+			GOTO(out_lock, rc = -ENOMEM);
+
+		for (i = 1; i < objcount; i++) {
+			rxoa[i - 1] = xoa[i - 1];
+			/* grant is announced and returned in the ost_body */
+			rxoa[i - 1].o_valid &= ~OBD_MD_FLGRANT;
+			tbc->oas[i] = &rxoa[i - 1];
+		}
+	}
+
+	rc = tgt_brw_prep_write(tsi->tsi_env, exp, tbc, objcount, ioo,
+				remote_nb);
 	if (rc < 0)
 		GOTO(out_lock, rc);
+	npages = rc;
+	rc = 0;
 
 	desc = ptlrpc_prep_bulk_exp(req, npages, ioobj_max_brw_get(ioo),
 				    PTLRPC_BULK_GET_SINK | PTLRPC_BULK_BUF_KIOV,
@@ -2226,7 +2476,8 @@ skip_transfer:
 		repbody->oa.o_flags &= ~OBD_FL_CKSUM_ALL;
 		repbody->oa.o_flags |= cksum_type_pack(cksum_type);
 		repbody->oa.o_cksum = tgt_checksum_bulk(tsi->tsi_tgt, desc,
-							OST_WRITE, cksum_type);
+							OST_WRITE, cksum_type,
+							local_nb);
 		cksum_counter++;
 
 		if (unlikely(body->oa.o_cksum != repbody->oa.o_cksum)) {
@@ -2246,8 +2497,8 @@ skip_transfer:
 	}
 
 	/* Must commit after prep above in all cases */
-	rc = obd_commitrw(tsi->tsi_env, OBD_BRW_WRITE, exp, &repbody->oa,
-			  objcount, ioo, remote_nb, npages, local_nb, rc);
+	rc = tgt_brw_commit_write(tsi->tsi_env, exp, tbc, objcount, ioo,
+				  remote_nb, rc);
 	if (rc == -ENOTCONN)
 		/* quota acquire process has been given up because
 		 * either the client has been evicted or the client
@@ -2259,7 +2510,8 @@ skip_transfer:
 	 * whole object, then it has already updated the mtime on its side,
 	 * otherwise it will have to glimpse anyway (see bug 21489, comment 32)
 	 */
-	repbody->oa.o_valid &= ~(OBD_MD_FLMTIME | OBD_MD_FLATIME);
+	for (i = 0; i < objcount; i++)
+		tbc->oas[i]->o_valid &= ~(OBD_MD_FLMTIME | OBD_MD_FLATIME);
 
 	if (rc == 0) {
 		int nob = 0;
@@ -2282,7 +2534,8 @@ skip_transfer:
 		LASSERT(j == npages);
 		ptlrpc_lprocfs_brw(req, nob);
 
-		tgt_drop_id(exp, &repbody->oa);
+		for (i = 0; i < objcount; i++)
+			tgt_drop_id(exp, tbc->oas[i]);
 	}
 out_lock:
 	tgt_brw_unlock(ioo, remote_nb, &lockh, LCK_PW);
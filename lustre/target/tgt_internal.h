@@ -240,6 +240,9 @@ extern struct page *tgt_page_to_corrupt;
 
 struct tgt_thread_big_cache {
 	struct niobuf_local	local[PTLRPC_MAX_BRW_PAGES];
+	/* per-object obdo and # of local buffers of a multi-object write */
+	struct obdo		*oas[PTLRPC_MAX_BRW_OBJS];
+	int			 obj_pages[PTLRPC_MAX_BRW_OBJS];
 };
 
 int tgt_server_data_init(const struct lu_env *env, struct lu_target *tgt);
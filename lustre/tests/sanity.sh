@@ -1259,6 +1259,36 @@ test_24E() {
 }
 run_test 24E "cross MDT rename/link"
 
+test_24F() { # negative dentries are cached under the dir UPDATE lock
+	test_mkdir -p -c1 $DIR/$tdir
+	cancel_lru_locks mdc
+
+	local i
+	# misses fetch the UPDATE lock of $tdir, later ones are cached
+	for ((i = 0; i < 10; i++)); do
+		stat $DIR/$tdir/nofile$i > /dev/null 2>&1 &&
+			error "nofile$i exists"
+	done
+	for ((i = 0; i < 10; i++)); do
+		stat $DIR/$tdir/nofile$i > /dev/null 2>&1
+	done
+
+	$LCTL set_param -n mdc.*.stats clear
+	for ((i = 0; i < 10; i++)); do
+		stat $DIR/$tdir/nofile$i > /dev/null 2>&1 &&
+			error "nofile$i exists"
+	done
+	local enqueues=$($LCTL get_param -n mdc.*.stats |
+			 awk '/^ldlm_enqueue/ { sum += $2 } END { print sum }')
+	[ ${enqueues:-0} -eq 0 ] ||
+		error "$enqueues lookups of cached negative dentries"
+
+	touch $DIR/$tdir/nofile0 || error "touch nofile0 failed"
+	stat $DIR/$tdir/nofile0 > /dev/null || error "nofile0 not found"
+	rm -rf $DIR/$tdir
+}
+run_test 24F "negative dentries cached with directory UPDATE lock"
+
 test_25a() {
 	echo '== symlink sanity ============================================='
 
@@ -5382,6 +5412,24 @@ test_64c() {
 }
 run_test 64c "verify grant shrink ========================------"
 
+test_64d() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+	$LCTL get_param -n osc.*.osc_stats | grep -q sync_fallback ||
+		{ skip "no sync fallback stats" && return; }
+
+	$SETSTRIPE -c 1 -i 0 $DIR/$tfile || error "setstripe failed"
+	clear_osc_stats
+	#define OBD_FAIL_OSC_NO_GRANT            0x411
+	$LCTL set_param fail_loc=0x411
+	dd if=/dev/zero of=$DIR/$tfile bs=4k count=4 conv=notrunc ||
+		error "dd failed"
+	$LCTL set_param fail_loc=0
+	[ $(calc_osc_stats sync_fallback_forced) -gt 0 ] ||
+		error "forced sync i/o was not counted"
+	rm -f $DIR/$tfile
+}
+run_test 64d "sync i/o fallback is counted in osc_stats"
+
 # bug 1414 - set/get directories' stripe info
 test_65a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
@@ -6048,6 +6096,54 @@ test_77j() { # bug 13805
 }
 run_test 77j "client only supporting ADLER32"
 
+test_77k() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+	$GSS && skip "could not run with gss" && return
+	local speed=$($LCTL get_param -n checksum_speed)
+	local algo
+
+	echo "$speed"
+	for algo in crc32 adler crc32c t10ip512 t10ip4k t10crc512 t10crc4k; do
+		echo "$speed" | grep -q "^$algo: " ||
+			error "no speed reported for $algo"
+	done
+
+	local param=/sys/module/obdclass/parameters/obd_t10_parallel_kb
+	local types=$($LCTL get_param -n osc.*osc-[^mM]*.checksum_type |
+		      head -n1)
+
+	# measured in the background when obdclass was loaded
+	for algo in t10ip512 t10ip4k t10crc512 t10crc4k; do
+		echo "$types" | grep -qw $algo || continue
+		echo "$speed" | grep -q "^$algo: 0$" &&
+			error "speed of $algo not measured"
+	done
+
+	local old=$(cat $param)
+	local old_ost=$(do_facet ost1 cat $param)
+
+	[ ! -f $F77_TMP ] && setup_f77
+	set_checksums 1
+	# split the T10 checksum of every RPC of 512KB or more across CPUs
+	echo 512 > $param
+	do_facet ost1 "echo 512 > $param"
+	for algo in t10ip512 t10ip4k t10crc512 t10crc4k; do
+		echo "$types" | grep -qw $algo || continue
+		set_checksum_type $algo
+		$LFS setstripe -c 1 -i 0 $DIR/$tfile
+		dd if=$F77_TMP of=$DIR/$tfile bs=1M count=$F77SZ oflag=direct ||
+			error "$algo: dd error"
+		cancel_lru_locks osc
+		cmp $F77_TMP $DIR/$tfile || error "$algo: file compare failed"
+		rm -f $DIR/$tfile
+	done
+	echo $old > $param
+	do_facet ost1 "echo $old_ost > $param"
+	set_checksums 0
+	set_checksum_type $ORIG_CSUM_TYPE
+}
+run_test 77k "T10 checksums computed in parallel, checksum_speed"
+
 [ "$ORIG_CSUM" ] && set_checksums $ORIG_CSUM || true
 rm -f $F77_TMP
 unset F77_TMP
@@ -6655,6 +6751,160 @@ test_101g() {
 }
 run_test 101g "Big bulk(4/16 MiB) readahead"
 
+test_101h() {
+	local llite=$($LCTL list_param llite.* | head -n 1)
+	local nodes
+	local unused
+	local nodes_unused
+
+	$LCTL get_param -n $llite.cache_node_stats > /dev/null 2>&1 ||
+		{ skip "no cache_node_stats on client" && return; }
+
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=16 ||
+		error "dd $DIR/$tfile failed"
+	cancel_lru_locks osc
+	cat $DIR/$tfile > /dev/null || error "read $DIR/$tfile failed"
+
+	# no IO in flight, the per-node slots must add up to the total
+	$LCTL get_param $llite.cache_node_stats
+	unused=$($LCTL get_param -n $llite.max_cached_mb |
+		 awk '/^unused_mb/ { print $2 }')
+	nodes_unused=$($LCTL get_param -n $llite.cache_node_stats |
+		       awk '$1 ~ /^[0-9]+$/ { sum += $2 } END { print sum }')
+	nodes=$($LCTL get_param -n $llite.cache_node_stats |
+		awk '$1 ~ /^[0-9]+$/' | wc -l)
+	# each node rounds its share down to MB
+	(( unused >= nodes_unused && unused - nodes_unused <= nodes )) ||
+		error "unused_mb $unused != per-node total $nodes_unused"
+	rm -f $DIR/$tfile
+}
+run_test 101h "per-NUMA-node LRU slots add up to max_cached_mb"
+
+test_101i() {
+	local osc=$($LCTL list_param osc.$FSNAME-OST0000-osc-[^M]* | head -n 1)
+	local rpcs
+	local i
+
+	$LCTL get_param -n $osc.connect_flags | grep -q multiobj_brw ||
+		{ skip "OST does not support multi-object writes" && return; }
+
+	test_mkdir -p $DIR/$tdir
+	$LFS setstripe -c 1 -i 0 $DIR/$tdir || error "setstripe failed"
+
+	$LCTL set_param -n $osc.rpc_stats=0
+	for ((i = 0; i < 32; i++)); do
+		dd if=/dev/zero of=$DIR/$tdir/$tfile.$i bs=4k count=1 \
+			2>/dev/null || error "dd $tfile.$i failed"
+	done
+	sync
+
+	$LCTL get_param $osc.rpc_stats | grep "multi-object"
+	rpcs=$($LCTL get_param -n $osc.rpc_stats |
+	       awk '/^multi-object write RPCs:/ { print $4 }')
+	[ "$rpcs" -gt 0 ] || error "small files not written together"
+
+	# the files must read back intact from the OST
+	cancel_lru_locks osc
+	for ((i = 0; i < 32; i++)); do
+		cmp -n 4096 $DIR/$tdir/$tfile.$i /dev/zero ||
+			error "$tfile.$i corrupted"
+	done
+	rm -rf $DIR/$tdir
+}
+run_test 101i "small writes of several objects share OST_WRITE RPCs"
+
+test_101j() {
+	local streams=3
+	local size_mb=16
+	local bsize=65536
+	local nreads=$((size_mb * 1048576 / bsize))
+	local pages=$((streams * size_mb * 1048576 / $(get_page_size client)))
+	local cmd="o"
+	local i
+	local s
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile || error "setstripe failed"
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=$((streams * size_mb)) \
+		2>/dev/null || error "dd failed"
+
+	# several sequential readers interleaved on a single descriptor
+	for ((i = 0; i < nreads; i++)); do
+		for ((s = 0; s < streams; s++)); do
+			cmd+="z$(((s * size_mb * 1048576) + i * bsize))r$bsize"
+		done
+	done
+	cmd+="c"
+
+	cancel_lru_locks osc
+	$LCTL set_param -n llite.*.read_ahead_stats 0
+	$MULTIOP $DIR/$tfile $cmd || error "multiop $DIR/$tfile failed"
+
+	$LCTL get_param llite.*.read_ahead_stats
+	local hit=$($LCTL get_param -n llite.*.read_ahead_stats |
+		    get_named_value 'hits' | cut -d" " -f1 | calc_total)
+	local miss=$($LCTL get_param -n llite.*.read_ahead_stats |
+		     get_named_value 'misses' | cut -d" " -f1 | calc_total)
+
+	# each reader would reset the window of the others with a single
+	# read-ahead state, and nearly every page would be missed
+	[ $hit -gt 0 ] || error "no read-ahead hit"
+	[ $miss -lt $((pages / 10)) ] ||
+		error "$miss of $pages pages missed read-ahead"
+	rm -f $DIR/$tfile
+}
+run_test 101j "read-ahead of interleaved sequential readers on one fd"
+
+test_101k() {
+	local size_mb=64
+	local pages=$((size_mb * 1048576 / $(get_page_size client)))
+	local active=$($LCTL get_param -n llite.*.max_read_ahead_async_active |
+		       head -n 1)
+	local threshold=$($LCTL get_param -n \
+			  llite.*.read_ahead_async_file_threshold_mb | head -n 1)
+	local sum
+	local async
+	local miss
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile || error "setstripe failed"
+	dd if=/dev/urandom of=$DIR/$tfile bs=1M count=$size_mb 2>/dev/null ||
+		error "dd failed"
+	sum=$(md5sum < $DIR/$tfile)
+
+	# start async read-ahead as soon as the window is one RPC
+	$LCTL set_param -n llite.*.read_ahead_async_file_threshold_mb=1
+	$LCTL set_param -n llite.*.max_read_ahead_async_active=16
+	cancel_lru_locks osc
+	$LCTL set_param -n llite.*.read_ahead_stats 0
+	[ "$(md5sum < $DIR/$tfile)" == "$sum" ] ||
+		error "data read ahead by worker threads differs"
+
+	$LCTL get_param llite.*.read_ahead_stats
+	async=$($LCTL get_param -n llite.*.read_ahead_stats |
+		get_named_value 'async readahead' | cut -d" " -f1 | calc_total)
+	miss=$($LCTL get_param -n llite.*.read_ahead_stats |
+	       get_named_value 'misses' | cut -d" " -f1 | calc_total)
+	[ $async -gt 0 ] || error "no async read-ahead"
+	[ $miss -lt $((pages / 10)) ] ||
+		error "$miss of $pages pages missed async read-ahead"
+
+	# disabled, the reader reads ahead by itself
+	$LCTL set_param -n llite.*.max_read_ahead_async_active=0
+	cancel_lru_locks osc
+	$LCTL set_param -n llite.*.read_ahead_stats 0
+	[ "$(md5sum < $DIR/$tfile)" == "$sum" ] || error "data differs"
+	async=$($LCTL get_param -n llite.*.read_ahead_stats |
+		get_named_value 'async readahead' | cut -d" " -f1 | calc_total)
+
+	$LCTL set_param -n llite.*.max_read_ahead_async_active=$active
+	$LCTL set_param -n \
+		llite.*.read_ahead_async_file_threshold_mb=$threshold
+	rm -f $DIR/$tfile
+
+	[ $async -eq 0 ] ||
+		error "$async async read-ahead with max_read_ahead_async_active=0"
+}
+run_test 101k "read-ahead by worker threads"
+
 setup_test102() {
 	test_mkdir -p $DIR/$tdir
 	chown $RUNAS_ID $DIR/$tdir
@@ -8442,6 +8692,131 @@ test_123b () { # statahead(bug 15027)
 }
 run_test 123b "not panic with network error in statahead enqueue (bug 15027)"
 
+test_123c() { # stat names in numeric order, not in readdir order
+	test_mkdir -p $DIR/$tdir
+	createmany -o $DIR/$tdir/f_%04d 200 || error "createmany failed"
+
+	local first=$(ls -U $DIR/$tdir | grep -v "^\.\.*$" | head -n 1)
+	local start=1
+	[ "$first" = "f_0001" ] && start=2
+	local before=$($LCTL get_param -n llite.*.statahead_stats |
+		       awk '/statahead pattern:/ { sum += $3 } END { print sum }')
+
+	cancel_lru_locks mdc
+	cancel_lru_locks osc
+	# keep the directory open, statahead serves its opener only
+	exec 5<$DIR/$tdir
+	for ((i = start; i < 200; i++)); do
+		[ -e $DIR/$tdir/$(printf "f_%04d" $i) ] ||
+			error "f_$i not found"
+	done
+	exec 5<&-
+
+	local after=$($LCTL get_param -n llite.*.statahead_stats |
+		      awk '/statahead pattern:/ { sum += $3 } END { print sum }')
+	$LCTL get_param -n llite.*.statahead_stats
+	[ $after -gt $before ] || error "pattern statahead not started"
+	rm -rf $DIR/$tdir
+}
+run_test 123c "statahead of names following a numeric pattern"
+
+test_123d() { # statahead threads are bounded by statahead_running_max
+	test_mkdir -p $DIR/$tdir
+	createmany -o $DIR/$tdir/$tfile-%d 100 || error "createmany failed"
+
+	local max=$($LCTL get_param -n llite.*.statahead_running_max |
+		    head -n 1)
+	local before=$($LCTL get_param -n llite.*.statahead_stats |
+		       awk '/statahead total:/ { sum += $3 } END { print sum }')
+
+	$LCTL set_param llite.*.statahead_running_max=0
+	cancel_lru_locks mdc
+	ls -l $DIR/$tdir > /dev/null
+	$LCTL set_param llite.*.statahead_running_max=$max
+
+	local after=$($LCTL get_param -n llite.*.statahead_stats |
+		      awk '/statahead total:/ { sum += $3 } END { print sum }')
+	[ $after -eq $before ] ||
+		error "statahead started with statahead_running_max=0"
+
+	cancel_lru_locks mdc
+	ls -l $DIR/$tdir > /dev/null
+	after=$($LCTL get_param -n llite.*.statahead_stats |
+		awk '/statahead total:/ { sum += $3 } END { print sum }')
+	[ $after -gt $before ] || error "statahead not started"
+	rm -rf $DIR/$tdir
+}
+run_test 123d "statahead_running_max limits statahead threads"
+
+statahead_stat() {
+	$LCTL get_param -n llite.*.statahead_stats |
+		awk '/statahead '"$1"':/ { sum += $3 } END { print sum }'
+}
+
+test_123e() { # stat names of a list given by LL_IOC_STATAHEAD
+	test_mkdir -p $DIR/$tdir
+	createmany -o $DIR/$tdir/$tfile-%d 100 || error "createmany failed"
+	# neither readdir order nor a numeric pattern
+	local names=$(ls $DIR/$tdir | sort -R)
+	local list=$(statahead_stat list)
+	local hit=$(statahead_stat hit)
+
+	cancel_lru_locks mdc
+	statahead_list $DIR/$tdir $names || error "statahead_list failed"
+	$LCTL get_param -n llite.*.statahead_stats
+	[ $(statahead_stat list) -gt $list ] ||
+		error "list statahead not started"
+	[ $(statahead_stat hit) -gt $hit ] || error "no statahead hit"
+
+	# the second handle only gets statahead once the first one is closed
+	list=$(statahead_stat list)
+	hit=$(statahead_stat hit)
+	cancel_lru_locks mdc
+	statahead_list -d $DIR/$tdir $names ||
+		error "statahead_list on second handle failed"
+	$LCTL get_param -n llite.*.statahead_stats
+	[ $(statahead_stat list) -gt $list ] ||
+		error "list statahead not started on second handle"
+	[ $(statahead_stat hit) -gt $hit ] ||
+		error "no statahead hit on second handle"
+	rm -rf $DIR/$tdir
+}
+run_test 123e "statahead of an explicit name list"
+
+test_123f() { # name lists appended to or replacing running statahead
+	# more names than one LL_IOC_STATAHEAD batch of 8192
+	local count=9000
+
+	test_mkdir -p $DIR/$tdir
+	createmany -o $DIR/$tdir/$tfile-%d $count ||
+		error "createmany failed"
+	local names=$(ls $DIR/$tdir | sort -R)
+	local list=$(statahead_stat list)
+	local hit=$(statahead_stat hit)
+
+	# llapi_statahead() splits the list in batches
+	cancel_lru_locks mdc
+	statahead_list $DIR/$tdir $names || error "statahead_list failed"
+	$LCTL get_param -n llite.*.statahead_stats
+	[ $(statahead_stat list) -ge $((list + 2)) ] ||
+		error "list not split in batches"
+	[ $(statahead_stat hit) -gt $hit ] || error "no statahead hit"
+
+	# a stat before starts readdir statahead, and the reverse list is
+	# replaced with the right one batch by batch
+	list=$(statahead_stat list)
+	hit=$(statahead_stat hit)
+	cancel_lru_locks mdc
+	statahead_list -s -r -b 1000 $DIR/$tdir $names ||
+		error "statahead_list of appended batches failed"
+	$LCTL get_param -n llite.*.statahead_stats
+	[ $(statahead_stat list) -gt $list ] ||
+		error "list statahead not started after stat"
+	[ $(statahead_stat hit) -gt $hit ] || error "no statahead hit"
+	rm -rf $DIR/$tdir
+}
+run_test 123f "statahead of name lists appended to running statahead"
+
 test_124a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
 	[ -z "$($LCTL get_param -n mdc.*.connect_flags | grep lru_resize)" ] &&
@@ -8646,6 +9021,36 @@ test_124c() {
 }
 run_test 124c "LRUR cancel very aged locks"
 
+test_124d() {
+	local dev="ldlm_test_$$"
+	local ncpus=$(getconf _NPROCESSORS_ONLN)
+	local rc=0
+
+	load_module ptlrpc/ldlm_test ||
+		{ skip_env "ldlm_test module not available" && return; }
+
+	dmesg -c > /dev/null
+	$LCTL <<-EOF || rc=$?
+		attach ldlm_test $dev ${dev}_uuid
+		setup
+		cleanup
+		detach
+	EOF
+	rmmod -v ldlm_test
+	dmesg | grep "$dev:"
+	[ $rc -eq 0 ] || error "resource lookup stress failed: rc = $rc"
+
+	# the lockless lookup must not serialize on the bucket lock
+	[ $ncpus -ge 4 ] || return 0
+	local pat="threads: \([0-9]*\) lookups.*"
+	local one=$(dmesg | sed -n "s/.*$dev: 1 $pat/\1/p")
+	local all=$(dmesg | sed -n "s/.*$dev: $ncpus $pat/\1/p")
+	[ -n "$one" -a -n "$all" ] || error "no lookup rate reported"
+	[ $all -gt $one ] ||
+		error "$ncpus threads did $all lookups/s, 1 thread did $one"
+}
+run_test 124d "concurrent lockless lookup/put of ldlm resources"
+
 test_125() { # 13358
 	[ -z "$(lctl get_param -n llite.*.client_type | grep local)" ] && skip "must run as local client" && return
 	[ -z "$(lctl get_param -n mdc.*-mdc-*.connect_flags | grep acl)" ] && skip "must have acl enabled" && return
@@ -9578,6 +9983,42 @@ test_133g() {
 }
 run_test 133g "Check for Oopses on bad io area writes/reads in /proc"
 
+test_133h() {
+	[[ $(lustre_version_code $SINGLEMDS) -lt $(version_code 2.8.52) ]] &&
+		skip "Need MDS version at least 2.8.52" && return
+
+	local nsdir="ldlm.namespaces.mdt-*-MDT0000_UUID"
+
+	# the resource exists before statistics are enabled, the client
+	# keeps it alive with its cached lock
+	touch $DIR/$tfile || error "touch $DIR/$tfile failed"
+	stat $DIR/$tfile > /dev/null || error "stat $DIR/$tfile failed"
+	local fid=$($LFS path2fid $DIR/$tfile)
+
+	do_facet mds1 $LCTL set_param $nsdir.lockstat=1
+	chmod 0600 $DIR/$tfile || error "chmod $DIR/$tfile failed"
+
+	local stats=$(do_facet mds1 $LCTL get_param -n $nsdir.lockstat)
+	echo "$stats"
+	local enq=$(echo "$stats" | grep "fid: $fid" |
+		    sed -e 's/.*enqueue: \([0-9]*\),.*/\1/')
+	[ -n "$enq" ] || {
+		do_facet mds1 $LCTL set_param $nsdir.lockstat=0
+		error "no lock statistics for $fid"
+	}
+
+	# no more collection once disabled
+	do_facet mds1 $LCTL set_param $nsdir.lockstat=0
+	stat $DIR/$tfile > /dev/null || error "stat $DIR/$tfile failed"
+	chmod 0644 $DIR/$tfile || error "chmod $DIR/$tfile failed"
+	local enq2=$(do_facet mds1 $LCTL get_param -n $nsdir.lockstat |
+		     grep "fid: $fid" |
+		     sed -e 's/.*enqueue: \([0-9]*\),.*/\1/')
+	[ "$enq" = "$enq2" ] ||
+		error "statistics updated after disabling: $enq != $enq2"
+}
+run_test 133h "Verifying ldlm resource lock statistics"
+
 test_134a() {
 	[[ $(lustre_version_code $SINGLEMDS) -lt $(version_code 2.7.54) ]] &&
 		skip "Need MDS version at least 2.7.54" && return
@@ -9653,6 +10094,80 @@ test_134b() {
 }
 run_test 134b "Server rejects lock request when reaching lock_limit_mb"
 
+test_134c() {
+	[[ $(lustre_version_code $SINGLEMDS) -lt $(version_code 2.8.52) ]] &&
+		skip "Need MDS version at least 2.8.52" && return
+
+	mkdir -p $DIR/$tdir || error "failed to create $DIR/$tdir"
+	cancel_lru_locks mdc
+
+	local nsdir="ldlm.namespaces.*-MDT0000-mdc-*"
+	local nr=1000
+	createmany -o $DIR/$tdir/f $nr ||
+		error "failed to create $nr files in $DIR/$tdir"
+	local unused=$($LCTL get_param -n $nsdir.lock_unused_count)
+
+	local low_wm=$(do_facet mds1 $LCTL get_param -n \
+			ldlm.lock_reclaim_threshold_mb)
+	# disable global reclaim, only the per-export limit is checked
+	do_facet mds1 $LCTL set_param ldlm.lock_reclaim_threshold_mb=0
+	do_facet mds1 $LCTL set_param ldlm.lock_export_soft_limit=100
+	# ignore lock age
+	#define OBD_FAIL_LDLM_WATERMARK_LOW     0x327
+	do_facet mds1 $LCTL set_param fail_loc=0x327
+	touch $DIR/$tdir/m
+
+	echo "sleep 10 seconds ..."
+	sleep 10
+	local lck_cnt=$($LCTL get_param -n $nsdir.lock_unused_count)
+
+	do_facet mds1 $LCTL set_param fail_loc=0
+	do_facet mds1 $LCTL set_param ldlm.lock_export_soft_limit=0
+	do_facet mds1 $LCTL set_param ldlm.lock_reclaim_threshold_mb=${low_wm}m
+	[ $lck_cnt -lt $unused ] ||
+		error "No locks reclaimed, before:$unused, after:$lck_cnt"
+
+	rm $DIR/$tdir/m
+	unlinkmany $DIR/$tdir/f $nr
+}
+run_test 134c "Server reclaims locks of client over lock_export_soft_limit"
+
+test_134d() {
+	[[ $(lustre_version_code $SINGLEMDS) -lt $(version_code 2.8.52) ]] &&
+		skip "Need MDS version at least 2.8.52" && return
+
+	mkdir -p $DIR/$tdir || error "failed to create $DIR/$tdir"
+	cancel_lru_locks mdc
+
+	local nsdir="ldlm.namespaces.*-MDT0000-mdc-*"
+	local nr=1000
+	local low_wm=$(do_facet mds1 $LCTL get_param -n \
+			ldlm.lock_reclaim_threshold_mb)
+	# disable global reclaim, only the per-export limit is checked
+	do_facet mds1 $LCTL set_param ldlm.lock_reclaim_threshold_mb=0
+	# no soft limit, it is derived from the hard one
+	do_facet mds1 $LCTL set_param ldlm.lock_export_soft_limit=0
+	do_facet mds1 $LCTL set_param ldlm.lock_export_hard_limit=400
+	# ignore lock age
+	#define OBD_FAIL_LDLM_WATERMARK_LOW     0x327
+	do_facet mds1 $LCTL set_param fail_loc=0x327
+
+	# the client must not be refused forever once over the hard limit
+	timeout 300 createmany -o $DIR/$tdir/f $nr
+	local rc=$?
+	local lck_cnt=$($LCTL get_param -n $nsdir.lock_unused_count)
+
+	do_facet mds1 $LCTL set_param fail_loc=0
+	do_facet mds1 $LCTL set_param ldlm.lock_export_hard_limit=0
+	do_facet mds1 $LCTL set_param ldlm.lock_reclaim_threshold_mb=${low_wm}m
+	[ $rc -eq 0 ] || error "failed to create $nr files in $DIR/$tdir: $rc"
+	[ $lck_cnt -lt $nr ] ||
+		error "No locks reclaimed, locks:$lck_cnt"
+
+	unlinkmany $DIR/$tdir/f $nr
+}
+run_test 134d "Server reclaims locks of client with only a hard limit"
+
 test_140() { #bug-17379
 	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
         test_mkdir -p $DIR/$tdir || error "Creating dir $DIR/$tdir"
@@ -11970,6 +12485,42 @@ test_207b() {
 }
 run_test 207b "can refresh layout at open"
 
+test_207c() {
+	[ $OSTCOUNT -lt 2 ] && skip "needs >= 2 OSTs" && return
+	local window=$($LCTL get_param -n lov.*clilov*.glimpse_window |
+		       head -n1)
+	[ -z "$window" ] && skip "no glimpse_window on client" && return
+
+	$SETSTRIPE -c -1 $DIR/$tfile || error "setstripe failed"
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=$((OSTCOUNT * 2)) ||
+		error "dd failed"
+	local fsz=$(stat -c %s $DIR/$tfile)
+	local dlmtrace_set=false
+
+	! $LCTL get_param debug | grep -q dlmtrace &&
+		$LCTL set_param debug=+dlmtrace && dlmtrace_set=true
+	# window 1 glimpses the stripes one by one, window 2 lets several
+	# completions race on the same anchor
+	local w
+	local sz
+	for w in 1 2; do
+		$LCTL set_param lov.*clilov*.glimpse_window=$w
+		cancel_lru_locks osc
+		$LCTL clear
+		sz=$(stat -c %s $DIR/$tfile)
+		[ $fsz -eq $sz ] ||
+			error "window $w: file size expected $fsz, actual $sz"
+		[ $OSTCOUNT -gt $w ] || continue
+		$LCTL dk | grep -q "throttle .* entries to window $w" ||
+			error "window $w: glimpses were not throttled"
+	done
+	$LCTL set_param lov.*clilov*.glimpse_window=$window
+	$dlmtrace_set && $LCTL set_param debug=-dlmtrace
+
+	rm -f $DIR/$tfile
+}
+run_test 207c "glimpse with a bounded glimpse window"
+
 test_208() {
 	# FIXME: in this test suite, only RD lease is used. This is okay
 	# for now as only exclusive open is supported. After generic lease
@@ -13659,6 +14210,43 @@ test_247e() {
 }
 run_test 247e "mount .. as fileset"
 
+test_248() {
+	local fast_read_sav=$($LCTL get_param -n llite.*.fast_read 2>/dev/null)
+	[ -z "$fast_read_sav" ] && skip "no fast read support" && return
+
+	# create a large file for fast read verification
+	dd if=/dev/urandom of=$DIR/$tfile bs=1M count=128 ||
+		error "dd $tfile failed"
+	local cksum=$(md5sum < $DIR/$tfile)
+
+	# make sure the file is created correctly and cached
+	cancel_lru_locks osc
+	$MULTIOP $DIR/$tfile oO_RDONLY:r134217728c || error "read failed"
+
+	$LCTL set_param -n llite.*.fast_read=1
+
+	echo "Test 1: verify cached data read by fast read is correct"
+	[ "$(md5sum < $DIR/$tfile)" = "$cksum" ] ||
+		error "fast read data mismatch"
+
+	echo "Test 2: verify fast read keeps readahead going for uncached data"
+	cancel_lru_locks osc
+	$LCTL set_param -n llite.*.read_ahead_stats 0
+	[ "$(md5sum < $DIR/$tfile)" = "$cksum" ] ||
+		error "data mismatch after cache drop"
+	local miss=$($LCTL get_param -n llite.*.read_ahead_stats |
+		     get_named_value 'misses' | cut -d" " -f1 | calc_total)
+	# a sequential 128MB read should miss only at the start of the file
+	[ $miss -lt 16 ] || {
+		$LCTL get_param llite.*.read_ahead_stats
+		error "fast read starved readahead, $miss misses"
+	}
+
+	$LCTL set_param -n llite.*.fast_read=$fast_read_sav
+	rm -f $DIR/$tfile
+}
+run_test 248 "fast read verification"
+
 test_250() {
 	[ "$(facet_fstype ost$(($($GETSTRIPE -i $DIR/$tfile) + 1)))" = "zfs" ] \
 	 && skip "no 16TB file size limit on ZFS" && return
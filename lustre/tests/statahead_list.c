@@ -0,0 +1,194 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ * Lustre is a trademark of Sun Microsystems, Inc.
+ *
+ * Stat ahead a list of names with llapi_statahead(), then stat them in the
+ * list order. Statahead only serves the process and directory handle which
+ * started it, so both steps must be done by the same program.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <lustre/lustreapi.h>
+
+char usage[] =
+"Usage: %s [-d] [-s] [-r] [-b batch] <dir> <name> [name ...]\n"
+"       stat ahead <name>s under <dir>, then stat them in the given order\n"
+"       -d: start statahead on a second handle of <dir>, which must fail\n"
+"           while the first handle is open, and succeed once it's closed\n"
+"       -s: stat the first name before, which may start statahead already\n"
+"       -r: pass the names in reverse order first, then replace them\n"
+"       -b: pass the names in calls of <batch> names, appended in turn\n";
+
+/* stat ahead @count @names in calls of @batch names */
+static int statahead(int fd, const char **names, int count, int batch,
+		     unsigned int flags)
+{
+	int done;
+	int rc;
+
+	for (done = 0; done < count; done += rc) {
+		if (batch > count - done)
+			batch = count - done;
+
+		rc = llapi_statahead(fd, names + done, batch,
+				     done == 0 ? flags : 0);
+		if (rc < 0)
+			return rc;
+		if (rc != batch) {
+			fprintf(stderr, "statahead queued %d of %d names\n",
+				rc, batch);
+			return -ENOSPC;
+		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	const char **names;
+	const char **reversed;
+	struct stat st;
+	int second = 0;
+	int first = 0;
+	int replace = 0;
+	int batch = 0;
+	int count;
+	int fd2 = -1;
+	int fd;
+	int rc;
+	int i;
+
+	while ((rc = getopt(argc, argv, "dsrb:")) != -1) {
+		switch (rc) {
+		case 'd':
+			second = 1;
+			break;
+		case 's':
+			first = 1;
+			break;
+		case 'r':
+			replace = 1;
+			break;
+		case 'b':
+			batch = atoi(optarg);
+			if (batch <= 0) {
+				fprintf(stderr, usage, argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		default:
+			fprintf(stderr, usage, argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (argc - optind < 2) {
+		fprintf(stderr, usage, argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	names = (const char **)&argv[optind + 1];
+	count = argc - optind - 1;
+	if (batch == 0)
+		batch = count;
+
+	fd = open(argv[optind], O_RDONLY | O_DIRECTORY);
+	if (fd < 0) {
+		fprintf(stderr, "open %s: %s\n", argv[optind], strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	if (second) {
+		fd2 = open(argv[optind], O_RDONLY | O_DIRECTORY);
+		if (fd2 < 0) {
+			fprintf(stderr, "open %s again: %s\n", argv[optind],
+				strerror(errno));
+			return EXIT_FAILURE;
+		}
+
+		/* the first handle owns statahead of the directory */
+		rc = llapi_statahead(fd2, names, count, 0);
+		if (rc != -EPERM) {
+			fprintf(stderr, "statahead on second handle: rc %d, "
+				"expected %d\n", rc, -EPERM);
+			return EXIT_FAILURE;
+		}
+
+		close(fd);
+		fd = fd2;
+	}
+
+	if (first && fstatat(fd, names[0], &st, 0) < 0) {
+		fprintf(stderr, "stat %s/%s: %s\n", argv[optind], names[0],
+			strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	if (replace) {
+		reversed = malloc(count * sizeof(*reversed));
+		if (reversed == NULL) {
+			fprintf(stderr, "cannot allocate %d names\n", count);
+			return EXIT_FAILURE;
+		}
+
+		for (i = 0; i < count; i++)
+			reversed[i] = names[count - i - 1];
+
+		rc = statahead(fd, reversed, count, batch, 0);
+		free(reversed);
+		if (rc < 0) {
+			fprintf(stderr, "statahead %s reversed: %s\n",
+				argv[optind], strerror(-rc));
+			return EXIT_FAILURE;
+		}
+	}
+
+	rc = statahead(fd, names, count, batch,
+		       replace ? LL_SA_NAMES_REPLACE : 0);
+	if (rc < 0) {
+		fprintf(stderr, "statahead %s: %s\n", argv[optind],
+			strerror(-rc));
+		return EXIT_FAILURE;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (fstatat(fd, names[i], &st, 0) < 0) {
+			fprintf(stderr, "stat %s/%s: %s\n", argv[optind],
+				names[i], strerror(errno));
+			return EXIT_FAILURE;
+		}
+	}
+
+	close(fd);
+	return EXIT_SUCCESS;
+}
@@ -4266,6 +4266,88 @@ int llapi_path2parent(const char *path, unsigned int linkno,
 	return rc;
 }
 
+/**
+ * Stat ahead \a names under the directory opened as \a dirfd, a following
+ * stat() of these names by the calling process is served from the client
+ * statahead cache instead of a synchronous MDS RPC each.
+ *
+ * The names are passed to the kernel in batches of LL_SA_NAMES_BATCH, and
+ * are queued after the names of earlier calls not stat'ed ahead yet, unless
+ * LL_SA_NAMES_REPLACE is given. At most LL_SA_NAMES_QUEUED names wait in
+ * the kernel, if more are given the count of names queued is returned, and
+ * the rest can be passed again once the process stat'ed the first names.
+ *
+ * \param dirfd	directory opened by the calling process
+ * \param names	names under the directory, in the order they'll be stat'ed
+ * \param count	number of names
+ * \param flags	LL_SA_NAMES_* flags
+ *
+ * \retval count of names queued on success, which is \a count unless the
+ *	   kernel queue was full.
+ * \retval -EPERM if another open handle of the directory owns statahead.
+ * \retval -EAGAIN if statahead of the directory stops for a low hit ratio,
+ *	   retry shortly.
+ * \retval -ENOSPC if the kernel queue was full already.
+ * \retval -EMFILE if too many statahead threads run on the client.
+ * \retval -errno on failure.
+ */
+int llapi_statahead(int dirfd, const char **names, int count,
+		    unsigned int flags)
+{
+	struct ll_statahead_names *lsn;
+	size_t size;
+	char *ptr;
+	int batch;
+	int done;
+	int rc = 0;
+	int i;
+
+	if (count <= 0)
+		return -EINVAL;
+
+	lsn = malloc(sizeof(*lsn) + LL_SA_NAMES_BATCH * (NAME_MAX + 1));
+	if (lsn == NULL)
+		return -ENOMEM;
+
+	for (done = 0; done < count; done += batch) {
+		batch = count - done;
+		if (batch > LL_SA_NAMES_BATCH)
+			batch = LL_SA_NAMES_BATCH;
+
+		memset(lsn, 0, sizeof(*lsn));
+		size = 0;
+		ptr = lsn->lsn_names;
+		for (i = done; i < done + batch; i++) {
+			size_t len = strlen(names[i]);
+
+			if (len == 0 || len > NAME_MAX) {
+				rc = -EINVAL;
+				goto out;
+			}
+			memcpy(ptr, names[i], len + 1);
+			ptr += len + 1;
+			size += len + 1;
+		}
+
+		lsn->lsn_count = batch;
+		lsn->lsn_size = size;
+		/* only the first batch replaces names of earlier calls */
+		lsn->lsn_flags = done == 0 ? flags : 0;
+
+		rc = ioctl(dirfd, LL_IOC_STATAHEAD, lsn);
+		if (rc < 0) {
+			rc = -errno;
+			/* stat ahead the names queued so far */
+			if (rc == -ENOSPC && done > 0)
+				rc = 0;
+			goto out;
+		}
+	}
+out:
+	free(lsn);
+	return rc < 0 ? rc : done;
+}
+
 int llapi_get_connect_flags(const char *mnt, __u64 *flags)
 {
         DIR *root;
@@ -547,6 +547,7 @@ check_obd_connect_data(void)
 	CHECK_DEFINE_64X(OBD_CONNECT_FLOCK_DEAD);
 	CHECK_DEFINE_64X(OBD_CONNECT_OPEN_BY_FID);
 	CHECK_DEFINE_64X(OBD_CONNECT_LFSCK);
+	CHECK_DEFINE_64X(OBD_CONNECT_MULTIOBJ_BRW);
 	CHECK_DEFINE_64X(OBD_CONNECT_UNLINK_CLOSE);
 	CHECK_DEFINE_64X(OBD_CONNECT_MULTIMODRPCS);
 	CHECK_DEFINE_64X(OBD_CONNECT_DIR_STRIPE);
@@ -559,6 +560,10 @@ check_obd_connect_data(void)
 	CHECK_VALUE_X(OBD_CKSUM_CRC32);
 	CHECK_VALUE_X(OBD_CKSUM_ADLER);
 	CHECK_VALUE_X(OBD_CKSUM_CRC32C);
+	CHECK_VALUE_X(OBD_CKSUM_T10IP512);
+	CHECK_VALUE_X(OBD_CKSUM_T10IP4K);
+	CHECK_VALUE_X(OBD_CKSUM_T10CRC512);
+	CHECK_VALUE_X(OBD_CKSUM_T10CRC4K);
 }
 
 static void
@@ -657,7 +662,10 @@ check_obdo(void)
 	CHECK_CVALUE_X(OBD_FL_CKSUM_CRC32);
 	CHECK_CVALUE_X(OBD_FL_CKSUM_ADLER);
 	CHECK_CVALUE_X(OBD_FL_CKSUM_CRC32C);
-	CHECK_CVALUE_X(OBD_FL_CKSUM_RSVD2);
+	CHECK_CVALUE_X(OBD_FL_CKSUM_T10IP512);
+	CHECK_CVALUE_X(OBD_FL_CKSUM_T10IP4K);
+	CHECK_CVALUE_X(OBD_FL_CKSUM_T10CRC512);
+	CHECK_CVALUE_X(OBD_FL_CKSUM_T10CRC4K);
 	CHECK_CVALUE_X(OBD_FL_CKSUM_RSVD3);
 	CHECK_CVALUE_X(OBD_FL_SHRINK_GRANT);
 	CHECK_CVALUE_X(OBD_FL_MMAP);
@@ -1205,6 +1205,8 @@ void lustre_assert_wire_constants(void)
 		 OBD_CONNECT_OPEN_BY_FID);
 	LASSERTF(OBD_CONNECT_LFSCK == 0x40000000000000ULL, "found 0x%.16llxULL\n",
 		 OBD_CONNECT_LFSCK);
+	LASSERTF(OBD_CONNECT_MULTIOBJ_BRW == 0x80000000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT_MULTIOBJ_BRW);
 	LASSERTF(OBD_CONNECT_UNLINK_CLOSE == 0x100000000000000ULL, "found 0x%.16llxULL\n",
 		 OBD_CONNECT_UNLINK_CLOSE);
 	LASSERTF(OBD_CONNECT_MULTIMODRPCS == 0x200000000000000ULL, "found 0x%.16llxULL\n",
@@ -1227,6 +1229,14 @@ void lustre_assert_wire_constants(void)
 		(unsigned)OBD_CKSUM_ADLER);
 	LASSERTF(OBD_CKSUM_CRC32C == 0x00000004UL, "found 0x%.8xUL\n",
 		(unsigned)OBD_CKSUM_CRC32C);
+	LASSERTF(OBD_CKSUM_T10IP512 == 0x00000008UL, "found 0x%.8xUL\n",
+		(unsigned)OBD_CKSUM_T10IP512);
+	LASSERTF(OBD_CKSUM_T10IP4K == 0x00000010UL, "found 0x%.8xUL\n",
+		(unsigned)OBD_CKSUM_T10IP4K);
+	LASSERTF(OBD_CKSUM_T10CRC512 == 0x00000020UL, "found 0x%.8xUL\n",
+		(unsigned)OBD_CKSUM_T10CRC512);
+	LASSERTF(OBD_CKSUM_T10CRC4K == 0x00000040UL, "found 0x%.8xUL\n",
+		(unsigned)OBD_CKSUM_T10CRC4K);
 
 	/* Checks for struct obdo */
 	LASSERTF((int)sizeof(struct obdo) == 208, "found %lld\n",
@@ -1451,7 +1461,10 @@ void lustre_assert_wire_constants(void)
 	CLASSERT(OBD_FL_CKSUM_CRC32 == 0x00001000);
 	CLASSERT(OBD_FL_CKSUM_ADLER == 0x00002000);
 	CLASSERT(OBD_FL_CKSUM_CRC32C == 0x00004000);
-	CLASSERT(OBD_FL_CKSUM_RSVD2 == 0x00008000);
+	CLASSERT(OBD_FL_CKSUM_T10IP512 == 0x00005000);
+	CLASSERT(OBD_FL_CKSUM_T10IP4K == 0x00006000);
+	CLASSERT(OBD_FL_CKSUM_T10CRC512 == 0x00007000);
+	CLASSERT(OBD_FL_CKSUM_T10CRC4K == 0x00008000);
 	CLASSERT(OBD_FL_CKSUM_RSVD3 == 0x00010000);
 	CLASSERT(OBD_FL_SHRINK_GRANT == 0x00020000);
 	CLASSERT(OBD_FL_MMAP == 0x00040000);